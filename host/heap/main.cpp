@@ -0,0 +1,181 @@
+// Host LVGL heap replay: drives LvglHeap with a synthetic trace shaped like
+// LVGL's allocations and reports where each size band is placed and how
+// fragmented the pools get.
+//
+//   pio run -e native-heap
+//   .pio/build/native-heap/program [--frames N] [--seed N]
+//
+// The trace is synthetic (object, style and label sizes from lv_obj_t and
+// friends on LVGL 8.3, lv_mem_buf scratch, layer buffers, a lazily built
+// screen opened and destroyed every 400 frames). It shows the allocator's
+// placement policy and pool sizing under churn, not the device's real mix;
+// for that, read waterdisp_lvgl_heap_* from /metrics.
+//
+// Only calls that hand out a block are counted: an lv_mem_buf slot reused
+// without growing never reaches the heap.
+
+#include <Arduino.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "config.h"
+#include "LvglHeap.h"
+#include "LvglTask.h"
+
+// LvglHeap's metrics collector takes the LVGL lock; nothing else runs here
+LvglTask lvglTask;
+LvglTask::LvglTask() {}
+bool LvglTask::lock(uint32_t timeoutMs) { return true; }
+void LvglTask::unlock() {}
+
+enum SizeBand { BAND_SMALL, BAND_MEDIUM, BAND_LARGE, BAND_COUNT };
+
+static const char* const bandNames[BAND_COUNT] = { "<= 128", "129-511", ">= 512" };
+static const char* const poolNames[LVGL_POOL_COUNT] = { "psram", "small", "scratch" };
+
+static std::mt19937 rng;
+static uint64_t placed[BAND_COUNT][LVGL_POOL_COUNT];
+
+static int rnd(int lo, int hi) {
+    return std::uniform_int_distribution<int>(lo, hi)(rng);
+}
+
+static SizeBand bandOf(size_t size) {
+    if (size <= 128) return BAND_SMALL;
+    if (size < 512) return BAND_MEDIUM;
+    return BAND_LARGE;
+}
+
+// Attribute a heap call to the pool whose allocation count moved
+static void* track(size_t size, void* (*call)(void*, size_t), void* ptr) {
+    LvglHeapStats before = lvglHeap.getStats();
+    void* result = call(ptr, size);
+    LvglHeapStats after = lvglHeap.getStats();
+    for (uint8_t i = 0; i < LVGL_POOL_COUNT; i++) {
+        if (after.pools[i].allocations != before.pools[i].allocations) {
+            placed[bandOf(size)][i]++;
+        }
+    }
+    return result;
+}
+
+static void* allocCall(void* ptr, size_t size) { return lvglHeap.allocate(size); }
+static void* reallocCall(void* ptr, size_t size) { return lvglHeap.reallocate(ptr, size); }
+
+static void* heapAlloc(size_t size) { return track(size, allocCall, nullptr); }
+static void* heapRealloc(void* ptr, size_t size) { return track(size, reallocCall, ptr); }
+
+// Objects of a screen: the object, sometimes spec_attr, its style list and
+// label text; Settings also has dropdown/textarea text and the scan list
+static std::vector<void*> buildScreen(int objects, bool settings) {
+    std::vector<void*> blocks;
+    for (int i = 0; i < objects; i++) {
+        blocks.push_back(heapAlloc(rnd(52, 96)));
+        if (rnd(0, 2) == 0) blocks.push_back(heapAlloc(rnd(56, 72)));
+        blocks.push_back(heapAlloc(rnd(8, 48)));
+        if (rnd(0, 1)) blocks.push_back(heapAlloc(rnd(6, 40)));
+        if (settings && rnd(0, 9) == 0) blocks.push_back(heapAlloc(rnd(160, 480)));
+    }
+    blocks.push_back(settings ? heapAlloc(rnd(1200, 2400)) : heapAlloc(960));
+    return blocks;
+}
+
+int main(int argc, char** argv) {
+    uint32_t frames = 20000;
+    uint32_t seed = 1234;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            return 2;
+        }
+    }
+    rng.seed(seed);
+    lvglHeap.begin();
+
+    std::vector<void*> mainScreen = buildScreen(100, false);
+    std::vector<void*> labels;
+    for (int i = 0; i < 12; i++) labels.push_back(heapAlloc(rnd(6, 24)));
+    void* memBuf[4] = {};
+    size_t memSize[4] = {};
+    std::vector<void*> settings;
+    std::vector<void*> anims;
+
+    uint8_t worstFrag[LVGL_POOL_COUNT] = {};
+    uint32_t minLargest[LVGL_POOL_COUNT];
+    std::fill(minLargest, minLargest + LVGL_POOL_COUNT, UINT32_MAX);
+
+    for (uint32_t frame = 0; frame < frames; frame++) {
+        // Live label updates
+        for (void*& label : labels) {
+            if (rnd(0, 3) == 0) label = heapRealloc(label, rnd(6, 40));
+        }
+
+        // lv_mem_buf_get() keeps its slots and only reallocates one to grow it
+        for (int i = 0; i < 4; i++) {
+            size_t want = rnd(0, 1) ? rnd(100, 800) : rnd(800, 1600);
+            if (memBuf[i] == nullptr || want > memSize[i]) {
+                memBuf[i] = heapRealloc(memBuf[i], want);
+                memSize[i] = want;
+            }
+        }
+
+        // Layer buffer for an opacity or transform draw, freed the same frame
+        if (rnd(0, 9) == 0) {
+            void* layer = heapAlloc(rnd(3072, 24576));
+            anims.push_back(heapAlloc(rnd(60, 120)));
+            lvglHeap.release(layer);
+        }
+
+        // Animations and timers come and go
+        if (rnd(0, 2) == 0) anims.push_back(heapAlloc(rnd(88, 112)));
+        while (anims.size() > 10) {
+            size_t k = rnd(0, anims.size() - 1);
+            lvglHeap.release(anims[k]);
+            anims.erase(anims.begin() + k);
+        }
+
+        // Settings built on demand and destroyed again (UI_LAZY_SCREENS)
+        if (frame % 400 == 0) settings = buildScreen(80, true);
+        if (frame % 400 == 250) {
+            std::shuffle(settings.begin(), settings.end(), rng);
+            for (void* p : settings) lvglHeap.release(p);
+            settings.clear();
+        }
+
+        if (frame % 50 == 0) {
+            LvglHeapStats s = lvglHeap.getStats();
+            for (uint8_t i = 0; i < LVGL_POOL_COUNT; i++) {
+                if (s.pools[i].size == 0) continue;
+                worstFrag[i] = std::max(worstFrag[i], s.pools[i].fragmentation);
+                minLargest[i] = std::min(minLargest[i], s.pools[i].largestFree);
+            }
+        }
+    }
+
+    printf("%-8s %10s %8s %8s %8s\n", "size", "allocs", "psram", "small", "scratch");
+    for (uint8_t b = 0; b < BAND_COUNT; b++) {
+        uint64_t total = 0;
+        for (uint8_t i = 0; i < LVGL_POOL_COUNT; i++) total += placed[b][i];
+        printf("%-8s %10llu", bandNames[b], (unsigned long long)total);
+        for (uint8_t i = 0; i < LVGL_POOL_COUNT; i++) {
+            printf(" %7.1f%%", total > 0 ? placed[b][i] * 100.0 / total : 0.0);
+        }
+        printf("\n");
+    }
+
+    LvglHeapStats s = lvglHeap.getStats();
+    printf("\nlive %u bytes, peak %u bytes, %u blocks, %u failures, %u spills\n",
+           s.liveBytes, s.peakBytes, s.liveBlocks, s.failures, s.spills);
+    for (uint8_t i = 0; i < LVGL_POOL_COUNT; i++) {
+        if (s.pools[i].size == 0) continue;
+        printf("%-8s %6u bytes, %6u free, largest %6u, fragmentation %u%% (worst %u%%, smallest largest %u)\n",
+               poolNames[i], s.pools[i].size, s.pools[i].freeBytes, s.pools[i].largestFree,
+               s.pools[i].fragmentation, worstFrag[i], minLargest[i]);
+    }
+    return s.failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,147 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Host stand-in for the parts of the Arduino-ESP32 core used by the UI,
+// hardware-control and metrics code. Only built in the [env:native] host build.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <math.h>
+#include <string>
+
+// Like the real core, pull in the FreeRTOS API
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+
+#define LOW             0
+#define HIGH            1
+#define INPUT           0x01
+#define OUTPUT          0x03
+#define INPUT_PULLUP    0x05
+#define RISING          0x01
+#define FALLING         0x02
+#define CHANGE          0x03
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+// millis() follows a simulated clock that the host runner advances, so
+// timeouts and rate limits behave the same on every run. micros() is wall
+// time, so the code's own duration measurements stay meaningful.
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void yield();
+void hostAdvanceMillis(uint32_t ms);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+#define digitalPinToInterrupt(p) (p)
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode);
+void detachInterrupt(uint8_t pin);
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+uint32_t getCpuFrequencyMhz();
+void* ps_malloc(size_t size);
+
+class String {
+public:
+    String() {}
+    String(const char* s) : _s(s ? s : "") {}
+    String(const std::string& s) : _s(s) {}
+    String(char c) : _s(1, c) {}
+    explicit String(int v) : _s(std::to_string(v)) {}
+    explicit String(unsigned int v) : _s(std::to_string(v)) {}
+    explicit String(long v) : _s(std::to_string(v)) {}
+    explicit String(unsigned long v) : _s(std::to_string(v)) {}
+    String(float v, unsigned int decimals = 2) { format(v, decimals); }
+    String(double v, unsigned int decimals = 2) { format(v, decimals); }
+
+    const char* c_str() const { return _s.c_str(); }
+    unsigned int length() const { return _s.length(); }
+    bool isEmpty() const { return _s.empty(); }
+    void reserve(unsigned int size) { _s.reserve(size); }
+
+    bool concat(const char* s) { _s += s; return true; }
+    bool concat(const String& s) { _s += s._s; return true; }
+    bool concat(char c) { _s += c; return true; }
+
+    String& operator+=(const String& s) { _s += s._s; return *this; }
+    String& operator+=(const char* s) { _s += s; return *this; }
+    String& operator+=(char c) { _s += c; return *this; }
+
+    char operator[](unsigned int i) const { return i < _s.size() ? _s[i] : 0; }
+    bool operator==(const String& o) const { return _s == o._s; }
+    bool operator==(const char* o) const { return _s == o; }
+    bool operator!=(const String& o) const { return _s != o._s; }
+    bool operator!=(const char* o) const { return _s != o; }
+
+    int indexOf(char c, unsigned int from = 0) const {
+        size_t p = _s.find(c, from);
+        return p == std::string::npos ? -1 : (int)p;
+    }
+    int indexOf(const char* s, unsigned int from = 0) const {
+        size_t p = _s.find(s, from);
+        return p == std::string::npos ? -1 : (int)p;
+    }
+    String substring(unsigned int from) const { return from < _s.size() ? String(_s.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const {
+        if (from >= _s.size() || to <= from) return String();
+        return String(_s.substr(from, to - from));
+    }
+    bool startsWith(const String& p) const { return _s.compare(0, p._s.size(), p._s) == 0; }
+    long toInt() const { return atol(_s.c_str()); }
+    float toFloat() const { return atof(_s.c_str()); }
+    void trim();
+
+    friend String operator+(const String& a, const String& b) { return String(a._s + b._s); }
+    friend String operator+(const String& a, const char* b) { return String(a._s + b); }
+    friend String operator+(const char* a, const String& b) { return String(a + b._s); }
+
+private:
+    std::string _s;
+    void format(double v, unsigned int decimals);
+};
+
+class IPAddress {
+public:
+    IPAddress() : _addr(0) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _addr(a | (b << 8) | (c << 16) | ((uint32_t)d << 24)) {}
+    String toString() const;
+
+private:
+    uint32_t _addr;
+};
+
+class HardwareSerial {
+public:
+    void begin(unsigned long baud) {}
+    size_t write(const uint8_t* data, size_t len);
+    size_t print(const char* s);
+    size_t println(const char* s = "");
+    size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+    void flush();
+};
+
+extern HardwareSerial Serial;
+
+class EspClass {
+public:
+    uint32_t getCycleCount();
+    uint32_t getFreeHeap();
+};
+
+extern EspClass ESP;
+
+#endif // HOST_ARDUINO_H
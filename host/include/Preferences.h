@@ -0,0 +1,39 @@
+#ifndef HOST_PREFERENCES_H
+#define HOST_PREFERENCES_H
+
+#include <Arduino.h>
+
+// In-memory NVS: namespaces live for the lifetime of the process
+class Preferences {
+public:
+    Preferences() : _ns(nullptr), _readOnly(false) {}
+    ~Preferences() { end(); }
+
+    bool begin(const char* name, bool readOnly = false);
+    void end();
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key);
+
+    size_t putString(const char* key, const char* value);
+    size_t putString(const char* key, const String& value) { return putString(key, value.c_str()); }
+    String getString(const char* key, const String& defaultValue = String());
+
+    size_t putFloat(const char* key, float value);
+    float getFloat(const char* key, float defaultValue = 0);
+    size_t putInt(const char* key, int32_t value);
+    int32_t getInt(const char* key, int32_t defaultValue = 0);
+    size_t putUInt(const char* key, uint32_t value);
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0);
+    size_t putBool(const char* key, bool value);
+    bool getBool(const char* key, bool defaultValue = false);
+
+private:
+    const char* _ns;
+    bool _readOnly;
+
+    size_t put(const char* key, const std::string& value);
+    bool get(const char* key, std::string& value);
+};
+
+#endif // HOST_PREFERENCES_H
@@ -0,0 +1,58 @@
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include <Arduino.h>
+#include <functional>
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum {
+    ARDUINO_EVENT_WIFI_SCAN_DONE,
+    ARDUINO_EVENT_WIFI_STA_CONNECTED,
+    ARDUINO_EVENT_WIFI_STA_DISCONNECTED,
+    ARDUINO_EVENT_WIFI_STA_GOT_IP,
+    ARDUINO_EVENT_MAX
+} arduino_event_id_t;
+
+typedef union {
+    struct {
+        uint8_t reason;
+    } wifi_sta_disconnected;
+} arduino_event_info_t;
+
+typedef std::function<void(arduino_event_id_t event, arduino_event_info_t info)> WiFiEventFuncCb;
+
+// Host stand-in for the station interface. The runner drives the link state
+// with hostSetConnected(), which fires the registered events like the real
+// event task would (synchronously, on the caller's thread).
+class WiFiClass {
+public:
+    WiFiClass();
+
+    wl_status_t status() const { return _connected ? WL_CONNECTED : WL_DISCONNECTED; }
+    bool isConnected() const { return _connected; }
+    String SSID() const { return _ssid; }
+    IPAddress localIP() const { return _connected ? IPAddress(192, 168, 1, 50) : IPAddress(); }
+
+    int onEvent(WiFiEventFuncCb callback, arduino_event_id_t event);
+
+    void hostSetConnected(bool connected, const char* ssid = "HostNet");
+
+private:
+    bool _connected;
+    String _ssid;
+    WiFiEventFuncCb _handlers[ARDUINO_EVENT_MAX][4];
+    uint8_t _handlerCount[ARDUINO_EVENT_MAX];
+
+    void fire(arduino_event_id_t event);
+};
+
+extern WiFiClass WiFi;
+
+#endif // HOST_WIFI_H
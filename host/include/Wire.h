@@ -0,0 +1,8 @@
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+// Host stand-in: the touch controller is replaced by the scripted touch input
+class TwoWire {
+};
+
+#endif // HOST_WIRE_H
@@ -0,0 +1,26 @@
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Host stand-in for the FreeRTOS subset used by the firmware. Tasks are
+// std::threads, queues and mutexes are std:: primitives; ticks are 1 ms.
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE         0
+#define pdTRUE          1
+#define pdPASS          pdTRUE
+#define pdFAIL          pdFALSE
+#define portMAX_DELAY   ((TickType_t)0xFFFFFFFF)
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define configTICK_RATE_HZ 1000
+#define portYIELD_FROM_ISR(x) do { (void)(x); } while (0)
+
+BaseType_t xPortGetCoreID();
+
+#endif // HOST_FREERTOS_H
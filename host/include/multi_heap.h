@@ -0,0 +1,38 @@
+#ifndef HOST_MULTI_HEAP_H
+#define HOST_MULTI_HEAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Host implementation of the ESP-IDF multi_heap API: a first-fit allocator
+// inside the caller's region, so pool limits and fragmentation show up the
+// same way they do on the device (the numbers differ from TLSF).
+
+typedef struct multi_heap_info* multi_heap_handle_t;
+
+typedef struct {
+    size_t total_free_bytes;
+    size_t total_allocated_bytes;
+    size_t largest_free_block;
+    size_t minimum_free_bytes;
+    size_t allocated_blocks;
+    size_t free_blocks;
+    size_t total_blocks;
+} multi_heap_info_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+multi_heap_handle_t multi_heap_register(void* start, size_t size);
+void* multi_heap_malloc(multi_heap_handle_t heap, size_t size);
+void multi_heap_free(multi_heap_handle_t heap, void* p);
+void* multi_heap_realloc(multi_heap_handle_t heap, void* p, size_t size);
+size_t multi_heap_get_allocated_size(multi_heap_handle_t heap, void* p);
+void multi_heap_get_info(multi_heap_handle_t heap, multi_heap_info_t* info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_MULTI_HEAP_H
@@ -0,0 +1,108 @@
+#include "HostDisplay.h"
+#include "Gesture.h"
+#include "config.h"
+#include <Arduino.h>
+
+HostDisplay::HostDisplay() {
+    _disp = nullptr;
+    _framebuffer = nullptr;
+    _buffer = nullptr;
+    _pixels = 0;
+    _lastPixels = 0;
+}
+
+void HostDisplay::begin(uint16_t bufferLines) {
+    const uint32_t screenPixels = SCREEN_WIDTH * SCREEN_HEIGHT;
+    _framebuffer = (lv_color_t*)calloc(screenPixels, sizeof(lv_color_t));
+
+    lv_disp_drv_init(&_drv);
+    _drv.hor_res = SCREEN_WIDTH;
+    _drv.ver_res = SCREEN_HEIGHT;
+    _drv.flush_cb = flush;
+    _drv.user_data = this;
+
+    _buffer = (lv_color_t*)malloc(SCREEN_WIDTH * bufferLines * sizeof(lv_color_t));
+    lv_disp_draw_buf_init(&_drawBuf, _buffer, NULL, SCREEN_WIDTH * bufferLines);
+    _drv.draw_buf = &_drawBuf;
+    _disp = lv_disp_drv_register(&_drv);
+
+    // Frames are rendered only by refresh(), so each one can be timed
+    lv_timer_pause(_lv_disp_get_refr_timer(_disp));
+}
+
+uint32_t HostDisplay::refresh() {
+    _pixels = 0;
+    uint32_t start = micros();
+    lv_refr_now(_disp);
+    uint32_t elapsed = micros() - start;
+    _lastPixels = _pixels;
+    return elapsed;
+}
+
+void HostDisplay::flush(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p) {
+    HostDisplay* self = (HostDisplay*)drv->user_data;
+    uint32_t w = lv_area_get_width(area);
+    uint32_t h = lv_area_get_height(area);
+    self->_pixels += w * h;
+
+    for (uint32_t row = 0; row < h; row++) {
+        memcpy(&self->_framebuffer[(area->y1 + row) * SCREEN_WIDTH + area->x1],
+               &color_p[row * w], w * sizeof(lv_color_t));
+    }
+    lv_disp_flush_ready(drv);
+}
+
+// FNV-1a over the framebuffer, for snapshot comparison
+uint32_t HostDisplay::hash() const {
+    const uint8_t* bytes = (const uint8_t*)_framebuffer;
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < SCREEN_WIDTH * SCREEN_HEIGHT * sizeof(lv_color_t); i++) {
+        h = (h ^ bytes[i]) * 16777619u;
+    }
+    return h;
+}
+
+HostTouch::HostTouch() {
+    memset(&_frame, 0, sizeof(_frame));
+}
+
+void HostTouch::begin() {
+    lv_indev_drv_init(&_drv);
+    _drv.type = LV_INDEV_TYPE_POINTER;
+    _drv.read_cb = read;
+    _drv.user_data = this;
+    lv_indev_drv_register(&_drv);
+}
+
+void HostTouch::press(uint16_t x, uint16_t y) {
+    _frame.count = 1;
+    _frame.points[0].id = 0;
+    _frame.points[0].x = x;
+    _frame.points[0].y = y;
+    _frame.points[0].size = 30;
+}
+
+void HostTouch::release() {
+    _frame.count = 0;
+}
+
+void HostTouch::poll() {
+    gestureDetector.update(_frame, millis());
+}
+
+void HostTouch::read(lv_indev_drv_t* drv, lv_indev_data_t* data) {
+    HostTouch* self = (HostTouch*)drv->user_data;
+
+    // As my_touchpad_read(): a recognised gesture cancels the press
+    if (gestureDetector.takeCapture()) {
+        lv_indev_wait_release(lv_indev_get_act());
+    }
+
+    if (self->_frame.count > 0) {
+        data->state = LV_INDEV_STATE_PR;
+        data->point.x = self->_frame.points[0].x;
+        data->point.y = self->_frame.points[0].y;
+    } else {
+        data->state = LV_INDEV_STATE_REL;
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef HOST_DISPLAY_H
+#define HOST_DISPLAY_H
+
+#include <lvgl.h>
+#include "GT911.h"
+
+// LVGL display backed by a framebuffer in memory. LVGL renders into a
+// bufferLines-high buffer that flush copies from, as on the device.
+class HostDisplay {
+public:
+    HostDisplay();
+
+    void begin(uint16_t bufferLines);
+
+    // Render all invalidated areas now. Returns the render time in microseconds.
+    uint32_t refresh();
+
+    // Pixels flushed by the last refresh()
+    uint32_t lastFlushedPixels() const { return _lastPixels; }
+
+    const uint16_t* framebuffer() const { return (const uint16_t*)_framebuffer; }
+    uint32_t hash() const;
+
+private:
+    lv_disp_draw_buf_t _drawBuf;
+    lv_disp_drv_t _drv;
+    lv_disp_t* _disp;
+    lv_color_t* _framebuffer;
+    lv_color_t* _buffer;
+    uint32_t _pixels;
+    uint32_t _lastPixels;
+
+    static void flush(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p);
+};
+
+// Scripted stand-in for the GT911: feeds the LVGL pointer and, like the
+// touch reader task, the gesture detector.
+class HostTouch {
+public:
+    HostTouch();
+
+    void begin();
+
+    void press(uint16_t x, uint16_t y);
+    void release();
+
+    // Hand the current state to the gesture detector (once per simulated poll)
+    void poll();
+
+private:
+    lv_indev_drv_t _drv;
+    TouchFrame _frame;
+
+    static void read(lv_indev_drv_t* drv, lv_indev_data_t* data);
+};
+
+#endif // HOST_DISPLAY_H
@@ -0,0 +1,491 @@
+// Host implementations of the Arduino, ESP-IDF and FreeRTOS stand-ins in
+// host/include. Only built in the [env:native] host build.
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <WiFi.h>
+#include <ESPmDNS.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <multi_heap.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+HardwareSerial Serial;
+EspClass ESP;
+WiFiClass WiFi;
+MDNSResponder MDNS;
+
+// ============================================================
+// TIME
+// ============================================================
+
+static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+static uint32_t simulatedMillis = 0;
+
+unsigned long millis() {
+    return simulatedMillis;
+}
+
+unsigned long micros() {
+    return (unsigned long)esp_timer_get_time();
+}
+
+int64_t esp_timer_get_time() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - startTime).count();
+}
+
+void hostAdvanceMillis(uint32_t ms) {
+    simulatedMillis += ms;
+}
+
+void delay(uint32_t ms) {
+    hostAdvanceMillis(ms);
+}
+
+void yield() {
+}
+
+uint32_t getCpuFrequencyMhz() {
+    return 1000;    // Cycle counter below counts nanoseconds
+}
+
+uint32_t EspClass::getCycleCount() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - startTime).count();
+}
+
+uint32_t EspClass::getFreeHeap() {
+    return 0;
+}
+
+// ============================================================
+// GPIO (the valve and flow sensor are not simulated)
+// ============================================================
+
+void pinMode(uint8_t pin, uint8_t mode) {}
+void digitalWrite(uint8_t pin, uint8_t value) {}
+int digitalRead(uint8_t pin) { return LOW; }
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode) {}
+void detachInterrupt(uint8_t pin) {}
+
+// ============================================================
+// STRING, IPADDRESS, SERIAL
+// ============================================================
+
+void String::format(double v, unsigned int decimals) {
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%.*f", decimals, v);
+    _s = buf;
+}
+
+void String::trim() {
+    size_t begin = _s.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        _s.clear();
+        return;
+    }
+    size_t end = _s.find_last_not_of(" \t\r\n");
+    _s = _s.substr(begin, end - begin + 1);
+}
+
+String IPAddress::toString() const {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", _addr & 0xFF, (_addr >> 8) & 0xFF,
+             (_addr >> 16) & 0xFF, _addr >> 24);
+    return String(buf);
+}
+
+// Firmware output goes to stderr so it never mixes with the runner's report
+size_t HardwareSerial::write(const uint8_t* data, size_t len) {
+    return fwrite(data, 1, len, stderr);
+}
+
+size_t HardwareSerial::print(const char* s) {
+    return fputs(s, stderr);
+}
+
+size_t HardwareSerial::println(const char* s) {
+    return fprintf(stderr, "%s\n", s);
+}
+
+size_t HardwareSerial::printf(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int n = vfprintf(stderr, fmt, args);
+    va_end(args);
+    return n < 0 ? 0 : n;
+}
+
+void HardwareSerial::flush() {
+    fflush(stderr);
+}
+
+// ============================================================
+// PREFERENCES
+// ============================================================
+
+static std::map<std::string, std::map<std::string, std::string>> nvsStore;
+
+bool Preferences::begin(const char* name, bool readOnly) {
+    _ns = name;
+    _readOnly = readOnly;
+    return true;
+}
+
+void Preferences::end() {
+    _ns = nullptr;
+}
+
+bool Preferences::clear() {
+    if (_ns == nullptr || _readOnly) return false;
+    nvsStore[_ns].clear();
+    return true;
+}
+
+bool Preferences::remove(const char* key) {
+    if (_ns == nullptr || _readOnly) return false;
+    return nvsStore[_ns].erase(key) > 0;
+}
+
+bool Preferences::isKey(const char* key) {
+    std::string value;
+    return get(key, value);
+}
+
+size_t Preferences::put(const char* key, const std::string& value) {
+    if (_ns == nullptr || _readOnly) return 0;
+    nvsStore[_ns][key] = value;
+    return value.size() > 0 ? value.size() : 1;
+}
+
+bool Preferences::get(const char* key, std::string& value) {
+    if (_ns == nullptr) return false;
+    auto ns = nvsStore.find(_ns);
+    if (ns == nvsStore.end()) return false;
+    auto it = ns->second.find(key);
+    if (it == ns->second.end()) return false;
+    value = it->second;
+    return true;
+}
+
+size_t Preferences::putString(const char* key, const char* value) { return put(key, value); }
+size_t Preferences::putFloat(const char* key, float value) { return put(key, std::to_string(value)); }
+size_t Preferences::putInt(const char* key, int32_t value) { return put(key, std::to_string(value)); }
+size_t Preferences::putUInt(const char* key, uint32_t value) { return put(key, std::to_string(value)); }
+size_t Preferences::putBool(const char* key, bool value) { return put(key, value ? "1" : "0"); }
+
+String Preferences::getString(const char* key, const String& defaultValue) {
+    std::string v;
+    return get(key, v) ? String(v) : defaultValue;
+}
+
+float Preferences::getFloat(const char* key, float defaultValue) {
+    std::string v;
+    return get(key, v) ? strtof(v.c_str(), nullptr) : defaultValue;
+}
+
+int32_t Preferences::getInt(const char* key, int32_t defaultValue) {
+    std::string v;
+    return get(key, v) ? (int32_t)strtol(v.c_str(), nullptr, 10) : defaultValue;
+}
+
+uint32_t Preferences::getUInt(const char* key, uint32_t defaultValue) {
+    std::string v;
+    return get(key, v) ? (uint32_t)strtoul(v.c_str(), nullptr, 10) : defaultValue;
+}
+
+bool Preferences::getBool(const char* key, bool defaultValue) {
+    std::string v;
+    return get(key, v) ? v == "1" : defaultValue;
+}
+
+// ============================================================
+// WIFI
+// ============================================================
+
+WiFiClass::WiFiClass() : _connected(false) {
+    memset(_handlerCount, 0, sizeof(_handlerCount));
+}
+
+int WiFiClass::onEvent(WiFiEventFuncCb callback, arduino_event_id_t event) {
+    if (_handlerCount[event] >= 4) return -1;
+    _handlers[event][_handlerCount[event]++] = callback;
+    return 0;
+}
+
+void WiFiClass::fire(arduino_event_id_t event) {
+    arduino_event_info_t info;
+    memset(&info, 0, sizeof(info));
+    for (uint8_t i = 0; i < _handlerCount[event]; i++) {
+        _handlers[event][i](event, info);
+    }
+}
+
+void WiFiClass::hostSetConnected(bool connected, const char* ssid) {
+    if (connected == _connected) return;
+    _connected = connected;
+    _ssid = connected ? ssid : "";
+    fire(connected ? ARDUINO_EVENT_WIFI_STA_GOT_IP : ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+}
+
+// ============================================================
+// HEAP
+// ============================================================
+
+void* ps_malloc(size_t size) {
+    return malloc(size);
+}
+
+extern "C" void* heap_caps_malloc(size_t size, uint32_t caps) {
+    return malloc(size);
+}
+
+extern "C" void* heap_caps_aligned_alloc(size_t alignment, size_t size, uint32_t caps) {
+    return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+extern "C" void heap_caps_free(void* ptr) {
+    free(ptr);
+}
+
+extern "C" size_t heap_caps_get_free_size(uint32_t caps) { return 0; }
+extern "C" size_t heap_caps_get_minimum_free_size(uint32_t caps) { return 0; }
+extern "C" size_t heap_caps_get_largest_free_block(uint32_t caps) { return 0; }
+
+// Blocks are laid out back to back; each starts with its total size, with
+// bit 0 set while in use. Free neighbours are merged lazily on allocation.
+struct multi_heap_info {
+    uint8_t* start;
+    size_t size;
+    size_t minimumFree;
+};
+
+static const size_t HEAP_HDR = 16;      // Keeps payloads 16-byte aligned
+static const size_t HEAP_MIN_SPLIT = HEAP_HDR + 16;
+
+static inline size_t& blockWord(uint8_t* block) { return *(size_t*)block; }
+static inline size_t blockSize(uint8_t* block) { return blockWord(block) & ~(size_t)1; }
+static inline bool blockUsed(uint8_t* block) { return blockWord(block) & 1; }
+
+static size_t heapFreeBytes(multi_heap_handle_t heap) {
+    size_t total = 0;
+    for (uint8_t* b = heap->start; b < heap->start + heap->size; b += blockSize(b)) {
+        if (!blockUsed(b)) total += blockSize(b) - HEAP_HDR;
+    }
+    return total;
+}
+
+extern "C" multi_heap_handle_t multi_heap_register(void* start, size_t size) {
+    multi_heap_info* heap = new multi_heap_info;
+    uintptr_t aligned = ((uintptr_t)start + 15) & ~(uintptr_t)15;
+    heap->start = (uint8_t*)aligned;
+    heap->size = (size - (aligned - (uintptr_t)start)) & ~(size_t)15;
+    blockWord(heap->start) = heap->size;
+    heap->minimumFree = heap->size - HEAP_HDR;
+    return heap;
+}
+
+extern "C" void* multi_heap_malloc(multi_heap_handle_t heap, size_t size) {
+    size_t need = HEAP_HDR + ((size + 15) & ~(size_t)15);
+    uint8_t* end = heap->start + heap->size;
+
+    for (uint8_t* b = heap->start; b < end; b += blockSize(b)) {
+        if (blockUsed(b)) continue;
+
+        // Coalesce following free blocks
+        uint8_t* next = b + blockSize(b);
+        while (next < end && !blockUsed(next)) {
+            blockWord(b) = blockSize(b) + blockSize(next);
+            next = b + blockSize(b);
+        }
+
+        size_t have = blockSize(b);
+        if (have < need) continue;
+
+        if (have - need >= HEAP_MIN_SPLIT) {
+            blockWord(b + need) = have - need;
+            have = need;
+        }
+        blockWord(b) = have | 1;
+
+        size_t freeNow = heapFreeBytes(heap);
+        if (freeNow < heap->minimumFree) heap->minimumFree = freeNow;
+        return b + HEAP_HDR;
+    }
+    return nullptr;
+}
+
+extern "C" void multi_heap_free(multi_heap_handle_t heap, void* p) {
+    if (p == nullptr) return;
+    uint8_t* b = (uint8_t*)p - HEAP_HDR;
+    blockWord(b) = blockSize(b);
+}
+
+extern "C" size_t multi_heap_get_allocated_size(multi_heap_handle_t heap, void* p) {
+    return blockSize((uint8_t*)p - HEAP_HDR) - HEAP_HDR;
+}
+
+extern "C" void* multi_heap_realloc(multi_heap_handle_t heap, void* p, size_t size) {
+    if (p == nullptr) return multi_heap_malloc(heap, size);
+    size_t old = multi_heap_get_allocated_size(heap, p);
+    if (size <= old) return p;
+
+    void* moved = multi_heap_malloc(heap, size);
+    if (moved == nullptr) return nullptr;
+    memcpy(moved, p, old);
+    multi_heap_free(heap, p);
+    return moved;
+}
+
+extern "C" void multi_heap_get_info(multi_heap_handle_t heap, multi_heap_info_t* info) {
+    memset(info, 0, sizeof(*info));
+    uint8_t* end = heap->start + heap->size;
+    uint8_t* b = heap->start;
+
+    while (b < end) {
+        size_t size = blockSize(b);
+        if (blockUsed(b)) {
+            info->total_allocated_bytes += size - HEAP_HDR;
+            info->allocated_blocks++;
+            b += size;
+            continue;
+        }
+        // Report adjacent free blocks as one, as they would be once merged
+        size_t run = 0;
+        while (b < end && !blockUsed(b)) {
+            run += blockSize(b);
+            b += blockSize(b);
+        }
+        info->total_free_bytes += run - HEAP_HDR;
+        info->free_blocks++;
+        if (run - HEAP_HDR > info->largest_free_block) {
+            info->largest_free_block = run - HEAP_HDR;
+        }
+    }
+    info->total_blocks = info->allocated_blocks + info->free_blocks;
+    info->minimum_free_bytes = heap->minimumFree;
+}
+
+// ============================================================
+// FREERTOS
+// ============================================================
+
+struct HostQueue {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::vector<uint8_t>> items;
+    size_t length;
+    size_t itemSize;
+};
+
+struct HostSemaphore {
+    std::recursive_timed_mutex mutex;
+};
+
+BaseType_t xPortGetCoreID() {
+    return 0;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    HostQueue* q = new HostQueue;
+    q->length = length;
+    q->itemSize = itemSize;
+    return q;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    delete queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticksToWait) {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    // Never waits: the host runner is single-threaded around the UI
+    if (queue->items.size() >= queue->length) return pdFALSE;
+    const uint8_t* bytes = (const uint8_t*)item;
+    queue->items.emplace_back(bytes, bytes + queue->itemSize);
+    queue->cv.notify_one();
+    return pdTRUE;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* woken) {
+    if (woken != nullptr) *woken = pdFALSE;
+    return xQueueSend(queue, item, 0);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticksToWait) {
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    if (queue->items.empty() && ticksToWait > 0) {
+        auto ready = [queue]() { return !queue->items.empty(); };
+        if (ticksToWait == portMAX_DELAY) {
+            queue->cv.wait(lock, ready);
+        } else {
+            queue->cv.wait_for(lock, std::chrono::milliseconds(ticksToWait), ready);
+        }
+    }
+    if (queue->items.empty()) return pdFALSE;
+    memcpy(item, queue->items.front().data(), queue->itemSize);
+    queue->items.pop_front();
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    return queue->items.size();
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return new HostSemaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() {
+    return new HostSemaphore;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) {
+    delete sem;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticksToWait) {
+    if (ticksToWait == portMAX_DELAY) {
+        sem->mutex.lock();
+        return pdTRUE;
+    }
+    return sem->mutex.try_lock_for(std::chrono::milliseconds(ticksToWait)) ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    sem->mutex.unlock();
+    return pdTRUE;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stack, void* arg,
+                       UBaseType_t priority, TaskHandle_t* handle) {
+    std::thread(fn, arg).detach();
+    if (handle != nullptr) *handle = (TaskHandle_t)1;
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stack, void* arg,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core) {
+    return xTaskCreate(fn, name, stack, arg, priority, handle);
+}
+
+void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+TickType_t xTaskGetTickCount() {
+    return (TickType_t)(esp_timer_get_time() / 1000);
+}
@@ -0,0 +1,107 @@
+// Host doubles for the firmware services the UI talks to but that only make
+// sense on the device: the LVGL task (the runner drives LVGL itself) and the
+// WiFi service (scans return a fixed network list).
+
+#include "LvglTask.h"
+#include "WiFiService.h"
+
+// ============================================================
+// LVGL TASK
+// ============================================================
+
+// Global instance
+LvglTask lvglTask;
+
+LvglTask::LvglTask() {
+    _mutex = nullptr;
+    _tickTimer = nullptr;
+    _task = nullptr;
+    _refrPeriod = LV_DISP_DEF_REFR_PERIOD;
+}
+
+void LvglTask::begin() {
+}
+
+// The runner calls lv_* from a single thread, as setup() does on the device
+bool LvglTask::lock(uint32_t timeoutMs) {
+    return true;
+}
+
+void LvglTask::unlock() {
+}
+
+LvglLock::LvglLock() {
+}
+
+LvglLock::~LvglLock() {
+}
+
+// ============================================================
+// WIFI SERVICE
+// ============================================================
+
+// Global instance
+WiFiService wifiService;
+
+static const WiFiScanEntry hostNetworks[] = {
+    { "HostNet",        -48, 6,  true },
+    { "Workshop-5G",    -61, 36, true },
+    { "Guest",          -70, 11, false },
+    { "Neighbour WiFi", -83, 1,  true },
+};
+
+WiFiService::WiFiService() {
+    _state = WIFI_SVC_IDLE;
+    _attemptStart = 0;
+    _nextAttempt = 0;
+    _backoff = WIFI_RECONNECT_MIN;
+    _servicesStarted = false;
+    _linkUp = false;
+    _linkDown = false;
+    _scanMutex = nullptr;
+    _scanCount = 0;
+    _scanTime = 0;
+    _scanning = false;
+    _scanDoneCallback = nullptr;
+}
+
+void WiFiService::begin() {
+}
+
+void WiFiService::update() {
+}
+
+void WiFiService::connect(const char* ssid, const char* password) {
+    _ssid = ssid;
+    _password = password;
+    _state = WIFI_SVC_CONNECTING;
+    _attemptStart = millis();
+}
+
+// Completes immediately with hostNetworks
+bool WiFiService::startScan() {
+    storeScanResults();
+    return true;
+}
+
+void WiFiService::storeScanResults() {
+    _scanCount = sizeof(hostNetworks) / sizeof(hostNetworks[0]);
+    memcpy(_scanResults, hostNetworks, sizeof(hostNetworks));
+    _scanTime = millis();
+    _scanning = false;
+
+    if (_scanDoneCallback != nullptr) {
+        _scanDoneCallback();
+    }
+}
+
+uint8_t WiFiService::getScanResults(WiFiScanEntry* entries, uint8_t maxEntries) {
+    uint8_t count = _scanCount < maxEntries ? _scanCount : maxEntries;
+    memcpy(entries, _scanResults, count * sizeof(WiFiScanEntry));
+    return count;
+}
+
+uint32_t WiFiService::getScanAge() {
+    if (_scanTime == 0) return UINT32_MAX;
+    return millis() - _scanTime;
+}
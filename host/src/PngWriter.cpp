@@ -0,0 +1,109 @@
+#include "PngWriter.h"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+static uint32_t crcTable[256];
+
+static void initCrcTable() {
+    if (crcTable[1] != 0) return;
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        crcTable[n] = c;
+    }
+}
+
+static uint32_t crc32(uint32_t crc, const uint8_t* data, size_t len) {
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static void put32(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back(v >> 24);
+    out.push_back(v >> 16);
+    out.push_back(v >> 8);
+    out.push_back(v);
+}
+
+static void writeChunk(FILE* f, const char* type, const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> chunk;
+    put32(chunk, data.size());
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    put32(chunk, crc32(0, chunk.data() + 4, chunk.size() - 4));
+    fwrite(chunk.data(), 1, chunk.size(), f);
+}
+
+bool writePng(const char* path, const uint16_t* pixels, uint16_t width, uint16_t height) {
+    initCrcTable();
+
+    FILE* f = fopen(path, "wb");
+    if (f == nullptr) return false;
+
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    fwrite(signature, 1, sizeof(signature), f);
+
+    std::vector<uint8_t> ihdr;
+    put32(ihdr, width);
+    put32(ihdr, height);
+    ihdr.push_back(8);      // Bit depth
+    ihdr.push_back(2);      // Truecolour
+    ihdr.push_back(0);      // Deflate
+    ihdr.push_back(0);      // Adaptive filtering
+    ihdr.push_back(0);      // No interlace
+    writeChunk(f, "IHDR", ihdr);
+
+    // Raw scanlines: filter type 0, then RGB888 expanded from RGB565
+    std::vector<uint8_t> raw;
+    raw.reserve((size_t)height * (1 + width * 3));
+    for (uint16_t y = 0; y < height; y++) {
+        raw.push_back(0);
+        for (uint16_t x = 0; x < width; x++) {
+            uint16_t c = pixels[(size_t)y * width + x];
+            uint8_t r = (c >> 11) & 0x1F;
+            uint8_t g = (c >> 5) & 0x3F;
+            uint8_t b = c & 0x1F;
+            raw.push_back((r << 3) | (r >> 2));
+            raw.push_back((g << 2) | (g >> 4));
+            raw.push_back((b << 3) | (b >> 2));
+        }
+    }
+
+    // zlib stream of stored deflate blocks
+    std::vector<uint8_t> idat;
+    idat.push_back(0x78);
+    idat.push_back(0x01);
+    size_t pos = 0;
+    do {
+        size_t len = raw.size() - pos;
+        if (len > 65535) len = 65535;
+        bool last = pos + len == raw.size();
+        idat.push_back(last ? 1 : 0);
+        idat.push_back(len & 0xFF);
+        idat.push_back(len >> 8);
+        idat.push_back(~len & 0xFF);
+        idat.push_back((~len >> 8) & 0xFF);
+        idat.insert(idat.end(), raw.begin() + pos, raw.begin() + pos + len);
+        pos += len;
+    } while (pos < raw.size());
+
+    uint32_t a = 1, b = 0;
+    for (uint8_t v : raw) {
+        a = (a + v) % 65521;
+        b = (b + a) % 65521;
+    }
+    put32(idat, (b << 16) | a);
+    writeChunk(f, "IDAT", idat);
+
+    writeChunk(f, "IEND", std::vector<uint8_t>());
+
+    bool ok = ferror(f) == 0;
+    fclose(f);
+    return ok;
+}
@@ -0,0 +1,10 @@
+#ifndef PNG_WRITER_H
+#define PNG_WRITER_H
+
+#include <stdint.h>
+
+// Writes an RGB565 image as a 24-bit PNG. Deflate uses stored blocks only:
+// snapshots are for pixel comparison, not for size.
+bool writePng(const char* path, const uint16_t* pixels, uint16_t width, uint16_t height);
+
+#endif // PNG_WRITER_H
@@ -0,0 +1,444 @@
+// Host UI runner: builds every UIManager screen against an in-memory display,
+// writes PNG snapshots and reports full-redraw and update render times.
+//
+//   pio run -e native
+//   .pio/build/native/program [--out DIR] [--baseline DIR | --no-baseline]
+//                             [--update-baseline] [--iterations N]
+//                             [--buffer-lines N] [--script FILE] [--log]
+//
+// Snapshots are compared against the reference hashes in
+// host/snapshots/snapshots.txt (or DIR/snapshots.txt) and the exit code is 1
+// if any screen changed, is missing or has no reference hash. An empty
+// reference fails too. --update-baseline rewrites the reference from this
+// run instead.
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <lvgl.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <vector>
+
+#include "config.h"
+#include "UIManager.h"
+#include "HardwareControl.h"
+#include "WiFiService.h"
+#include "LvglHeap.h"
+#include "Gesture.h"
+#include "Log.h"
+#include "HostDisplay.h"
+#include "PngWriter.h"
+
+#define HOST_STEP_MS      5     // Simulated time per LVGL timer pass
+#define HOST_TOUCH_POLL   20    // Gesture detector feed, as TOUCH_POLL_INTERVAL
+#define HOST_FRAME_MS     33    // Simulated time between update frames
+
+static const char* const screenNames[SCREEN_COUNT] = {
+    "main", "keypad", "dispensing", "config", "calibration"
+};
+
+struct ScreenReport {
+    bool rendered;
+    uint32_t showUs;            // showScreen(), including a lazy build
+    int32_t heapBytes;          // LVGL heap change across showScreen()
+    uint32_t fullUs;            // Median full-screen redraw
+    uint32_t fullPx;
+    bool updated;               // Screen has a live update scenario
+    uint32_t updateUs;          // Median render after a typical update
+    uint32_t updatePx;
+    uint32_t hash;
+};
+
+static HostDisplay display;
+static HostTouch touch;
+static std::string outDir = "snapshots";
+static const char* const REFERENCE_DIR = "host/snapshots";
+static std::map<std::string, uint32_t> snapshots;
+static uint32_t lastTouchPoll = 0;
+
+// Advance simulated time, running LVGL timers and the UI message queue the
+// way the LVGL task does. Rendering only happens in display.refresh().
+static void step(uint32_t ms) {
+    for (uint32_t t = 0; t < ms; t += HOST_STEP_MS) {
+        hostAdvanceMillis(HOST_STEP_MS);
+        lv_tick_inc(HOST_STEP_MS);
+        if (millis() - lastTouchPoll >= HOST_TOUCH_POLL) {
+            lastTouchPoll = millis();
+            touch.poll();
+        }
+        lv_timer_handler();
+        uiManager.processMessages();
+    }
+}
+
+// Let animations finish, then render
+static void settle() {
+    step(600);
+    display.refresh();
+}
+
+static uint32_t median(std::vector<uint32_t>& values) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+static void snapshot(const std::string& name) {
+    std::string path = outDir + "/" + name + ".png";
+    if (!writePng(path.c_str(), display.framebuffer(), SCREEN_WIDTH, SCREEN_HEIGHT)) {
+        fprintf(stderr, "Failed to write %s\n", path.c_str());
+    }
+    snapshots[name] = display.hash();
+}
+
+// ============================================================
+// PER-SCREEN UPDATES
+// ============================================================
+
+// Applies one typical live update to the current screen. Returns false if the
+// screen has none.
+static bool applyUpdate(UIScreen screen, uint32_t i) {
+    switch (screen) {
+        case SCREEN_MAIN:
+            // WiFi indicator, through the same event path as the device
+            WiFi.hostSetConnected(i % 2 == 0);
+            return true;
+
+        case SCREEN_DISPENSING:
+            // ~10 ml/s at the default calibration
+            for (uint8_t p = 0; p < 15; p++) {
+                hardwareControl.handleFlowPulse();
+            }
+            hardwareControl.update();
+            uiManager.postDispenseStatus();
+            step(HOST_FRAME_MS);    // Flow chart timer
+            return true;
+
+        case SCREEN_CONFIG:
+            wifiService.startScan();
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+static void enterScreen(UIScreen screen) {
+    if (screen == SCREEN_DISPENSING) {
+        hardwareControl.startDispensing(5000);
+    }
+    uiManager.showScreen(screen);
+}
+
+static void leaveScreen(UIScreen screen) {
+    if (screen == SCREEN_DISPENSING) {
+        hardwareControl.stopDispensing();
+    }
+    WiFi.hostSetConnected(false);
+}
+
+static ScreenReport benchmarkScreen(UIScreen screen, uint32_t iterations) {
+    ScreenReport r;
+    memset(&r, 0, sizeof(r));
+
+    int32_t heapBefore = lvglHeap.getLiveBytes();
+    uint32_t start = micros();
+    enterScreen(screen);
+    r.showUs = micros() - start;
+    r.heapBytes = (int32_t)lvglHeap.getLiveBytes() - heapBefore;
+
+    settle();
+    r.rendered = true;
+    r.hash = display.hash();
+    snapshot(screenNames[screen]);
+
+    std::vector<uint32_t> times;
+    for (uint32_t i = 0; i < iterations; i++) {
+        lv_obj_invalidate(lv_scr_act());
+        times.push_back(display.refresh());
+        r.fullPx = display.lastFlushedPixels();
+    }
+    r.fullUs = median(times);
+
+    times.clear();
+    uint64_t px = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        if (!applyUpdate(screen, i)) break;
+        uiManager.processMessages();
+        lv_timer_handler();     // Animations started by the update
+        times.push_back(display.refresh());
+        px += display.lastFlushedPixels();
+    }
+    if (!times.empty()) {
+        r.updated = true;
+        r.updatePx = px / times.size();
+        r.updateUs = median(times);
+    }
+
+    leaveScreen(screen);
+    return r;
+}
+
+// ============================================================
+// TOUCH SCRIPT
+// ============================================================
+
+static bool screenByName(const std::string& name, UIScreen& screen) {
+    for (uint8_t i = 0; i < SCREEN_COUNT; i++) {
+        if (name == screenNames[i]) {
+            screen = (UIScreen)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// One command per line:
+//   show <screen>                 tap <x> <y>
+//   press <x> <y>                 release
+//   swipe <x0> <y0> <x1> <y1> [ms]
+//   wait <ms>                     wifi on|off
+//   snapshot <name>               # comment
+static bool runScript(const char* path) {
+    std::ifstream in(path);
+    if (!in) {
+        fprintf(stderr, "Cannot open script %s\n", path);
+        return false;
+    }
+
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(in, line)) {
+        lineNo++;
+        std::istringstream args(line);
+        std::string cmd;
+        if (!(args >> cmd) || cmd[0] == '#') continue;
+
+        if (cmd == "show") {
+            std::string name;
+            UIScreen screen;
+            args >> name;
+            if (!screenByName(name, screen)) {
+                fprintf(stderr, "%s:%d: unknown screen '%s'\n", path, lineNo, name.c_str());
+                return false;
+            }
+            uiManager.showScreen(screen);
+        } else if (cmd == "tap" || cmd == "press") {
+            int x, y;
+            args >> x >> y;
+            touch.press(x, y);
+            step(HOST_TOUCH_POLL * 3);
+            if (cmd == "tap") {
+                touch.release();
+                step(HOST_TOUCH_POLL * 3);
+            }
+        } else if (cmd == "release") {
+            touch.release();
+            step(HOST_TOUCH_POLL * 3);
+        } else if (cmd == "swipe") {
+            int x0, y0, x1, y1, ms = 200;
+            args >> x0 >> y0 >> x1 >> y1;
+            args >> ms;
+            for (int t = 0; t <= ms; t += HOST_TOUCH_POLL) {
+                touch.press(x0 + (x1 - x0) * t / ms, y0 + (y1 - y0) * t / ms);
+                step(HOST_TOUCH_POLL);
+            }
+            touch.release();
+            step(HOST_TOUCH_POLL * 3);
+        } else if (cmd == "wait") {
+            int ms = 0;
+            args >> ms;
+            step(ms);
+        } else if (cmd == "wifi") {
+            std::string state;
+            args >> state;
+            WiFi.hostSetConnected(state == "on");
+            step(HOST_STEP_MS);
+        } else if (cmd == "snapshot") {
+            std::string name;
+            args >> name;
+            settle();
+            snapshot(name);
+        } else {
+            fprintf(stderr, "%s:%d: unknown command '%s'\n", path, lineNo, cmd.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+// ============================================================
+// SNAPSHOT INDEX
+// ============================================================
+
+static void writeIndex(const std::string& dir) {
+    std::ofstream out(dir + "/snapshots.txt");
+    out << "# Framebuffer hash per snapshot, written by the host UI runner\n";
+    for (const auto& s : snapshots) {
+        char hex[9];
+        snprintf(hex, sizeof(hex), "%08x", s.second);
+        out << s.first << " " << hex << "\n";
+    }
+}
+
+// Returns the number of snapshots that differ from (or are missing in) the baseline
+static int compareIndex(const std::string& baselineDir) {
+    std::ifstream in(baselineDir + "/snapshots.txt");
+    if (!in) {
+        fprintf(stderr, "No snapshots.txt in %s\n", baselineDir.c_str());
+        return 1;
+    }
+
+    std::map<std::string, uint32_t> baseline;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string name, hex;
+        if (!(fields >> name >> hex) || name[0] == '#') continue;
+        baseline[name] = strtoul(hex.c_str(), nullptr, 16);
+    }
+
+    // A reference without hashes would pass every run
+    if (baseline.empty()) {
+        fprintf(stderr, "\n%s/snapshots.txt has no hashes; run with --update-baseline and commit it\n",
+                baselineDir.c_str());
+        return 1;
+    }
+
+    int changed = 0;
+    printf("\n%-16s %s\n", "snapshot", "vs baseline");
+    // Script snapshots the reference doesn't have are listed but don't fail
+    // the run; every screen must have a reference hash
+    for (const auto& s : snapshots) {
+        auto it = baseline.find(s.first);
+        bool screen = std::find(screenNames, screenNames + SCREEN_COUNT, s.first) != screenNames + SCREEN_COUNT;
+        const char* status;
+        if (it == baseline.end()) {
+            status = screen ? "NO REFERENCE" : "new";
+            if (screen) changed++;
+        } else if (it->second == s.second) {
+            status = "same";
+        } else {
+            status = "CHANGED";
+            changed++;
+        }
+        printf("%-16s %s\n", s.first.c_str(), status);
+    }
+    for (const auto& b : baseline) {
+        if (snapshots.find(b.first) == snapshots.end()) {
+            printf("%-16s %s\n", b.first.c_str(), "MISSING");
+            changed++;
+        }
+    }
+    return changed;
+}
+
+// ============================================================
+// MAIN
+// ============================================================
+
+static void usage() {
+    fprintf(stderr, "usage: program [--out DIR] [--baseline DIR | --no-baseline] [--update-baseline] "
+                    "[--iterations N] [--buffer-lines N] [--script FILE] [--log]\n");
+}
+
+int main(int argc, char** argv) {
+    std::string baselineDir = REFERENCE_DIR;
+    bool updateBaseline = false;
+    const char* script = nullptr;
+    uint32_t iterations = 30;
+    uint16_t bufferLines = DRAW_BUF_DEFAULT_LINES;
+    bool log = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--out" && hasValue) {
+            outDir = argv[++i];
+        } else if (arg == "--baseline" && hasValue) {
+            baselineDir = argv[++i];
+        } else if (arg == "--no-baseline") {
+            baselineDir.clear();
+        } else if (arg == "--update-baseline") {
+            updateBaseline = true;
+        } else if (arg == "--iterations" && hasValue) {
+            iterations = atoi(argv[++i]);
+        } else if (arg == "--buffer-lines" && hasValue && atoi(argv[i + 1]) > 0) {
+            bufferLines = atoi(argv[++i]);
+        } else if (arg == "--script" && hasValue) {
+            script = argv[++i];
+        } else if (arg == "--log") {
+            log = true;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    std::filesystem::create_directories(outDir);
+
+    // Firmware log lines go to stderr through the normal drain task
+    if (log) {
+        logger.begin();
+    }
+
+    lvglHeap.begin();
+    lv_init();
+    display.begin(bufferLines);
+    touch.begin();
+
+    gestureDetector.onGesture([](const Gesture& gesture) {
+        uiManager.postGesture(gesture);
+    });
+
+    hardwareControl.begin();
+
+    uint32_t start = micros();
+    uiManager.begin();
+    uint32_t bootUs = micros() - start;
+    settle();
+
+    ScreenReport reports[SCREEN_COUNT];
+    for (uint8_t i = 0; i < SCREEN_COUNT; i++) {
+        reports[i] = benchmarkScreen((UIScreen)i, iterations);
+        uiManager.showScreen(SCREEN_MAIN);
+        settle();
+    }
+
+    bool scriptOk = script == nullptr || runScript(script);
+
+    printf("UI boot: %u us, LVGL heap %u bytes live, %u bytes peak\n",
+           bootUs, lvglHeap.getLiveBytes(), lvglHeap.getStats().peakBytes);
+    printf("Render: %u-line buffer, %u iterations, median microseconds\n\n",
+           bufferLines, iterations);
+    printf("%-12s %9s %10s %9s %8s %9s %9s  %s\n",
+           "screen", "show_us", "heap_b", "full_us", "full_px", "update_us", "update_px", "hash");
+    for (uint8_t i = 0; i < SCREEN_COUNT; i++) {
+        const ScreenReport& r = reports[i];
+        printf("%-12s %9u %10d %9u %8u ", screenNames[i], r.showUs, r.heapBytes, r.fullUs, r.fullPx);
+        if (r.updated) {
+            printf("%9u %9u", r.updateUs, r.updatePx);
+        } else {
+            printf("%9s %9s", "-", "-");
+        }
+        printf("  %08x\n", r.hash);
+    }
+
+    writeIndex(outDir);
+
+    int status = scriptOk ? 0 : 2;
+    if (updateBaseline && !baselineDir.empty()) {
+        std::filesystem::create_directories(baselineDir);
+        writeIndex(baselineDir);
+        printf("\nReference hashes written to %s/snapshots.txt\n", baselineDir.c_str());
+    } else if (!baselineDir.empty() && compareIndex(baselineDir) > 0) {
+        status = 1;
+    }
+
+    if (log) {
+        logger.flush();
+    }
+    return status;
+}
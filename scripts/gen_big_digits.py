@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+"""
+Generate the glyph atlas for the large dispensed-volume readout.
+
+Renders anti-aliased seven-segment digits 0-9, a minus sign and a decimal
+point into 4-bit alpha bitmaps and writes src/BigDigitGlyphs.h/.cpp.
+BigDigits expands them to 8-bit alpha in RAM at startup.
+
+Run from the project root after changing the dimensions below:
+
+    python3 scripts/gen_big_digits.py
+"""
+
+import os
+
+CELL_W = 48         # Digit cell width (px)
+CELL_H = 88         # Cell height (px)
+DOT_W = 20          # Decimal point cell width (px)
+THICK = 10          # Segment thickness (px)
+GAP = 2             # Gap between segments (px)
+MARGIN = 4          # Blank border inside each cell (px)
+SUPERSAMPLE = 4     # Samples per axis per pixel
+
+# Segments a-g, per digit
+SEGMENTS = {
+    '0': 'abcdef', '1': 'bc', '2': 'abdeg', '3': 'abcdg', '4': 'bcfg',
+    '5': 'acdfg', '6': 'acdefg', '7': 'abc', '8': 'abcdefg', '9': 'abcdfg',
+    '-': 'g',
+}
+GLYPHS = '0123456789-'
+
+
+def segment_polygons():
+    """Hexagonal segments inside the digit cell, as point lists."""
+    x0, x1 = MARGIN, CELL_W - MARGIN
+    y0, y1 = MARGIN, CELL_H - MARGIN
+    ym = (y0 + y1) / 2
+    h = THICK / 2
+
+    def horizontal(y):
+        l, r = x0 + GAP, x1 - GAP
+        return [(l, y), (l + h, y - h), (r - h, y - h), (r, y), (r - h, y + h), (l + h, y + h)]
+
+    def vertical(x, top, bottom):
+        t, b = top + GAP, bottom - GAP
+        return [(x, t), (x + h, t + h), (x + h, b - h), (x, b), (x - h, b - h), (x - h, t + h)]
+
+    return {
+        'a': horizontal(y0 + h),
+        'g': horizontal(ym),
+        'd': horizontal(y1 - h),
+        'f': vertical(x0 + h, y0 + h, ym),
+        'b': vertical(x1 - h, y0 + h, ym),
+        'e': vertical(x0 + h, ym, y1 - h),
+        'c': vertical(x1 - h, ym, y1 - h),
+    }
+
+
+def inside(poly, x, y):
+    """Point in convex polygon (points in clockwise screen order)."""
+    n = len(poly)
+    for i in range(n):
+        ax, ay = poly[i]
+        bx, by = poly[(i + 1) % n]
+        if (bx - ax) * (y - ay) - (by - ay) * (x - ax) < 0:
+            return False
+    return True
+
+
+def render(width, test):
+    """4-bit coverage bitmap, one value per pixel."""
+    pixels = []
+    n = SUPERSAMPLE * SUPERSAMPLE
+    for py in range(CELL_H):
+        for px in range(width):
+            hits = 0
+            for sy in range(SUPERSAMPLE):
+                for sx in range(SUPERSAMPLE):
+                    if test(px + (sx + 0.5) / SUPERSAMPLE, py + (sy + 0.5) / SUPERSAMPLE):
+                        hits += 1
+            pixels.append((hits * 15 + n // 2) // n)
+    return pixels
+
+
+def pack(pixels):
+    """Two pixels per byte, first pixel in the high nibble."""
+    if len(pixels) % 2:
+        pixels = pixels + [0]
+    return bytes((pixels[i] << 4) | pixels[i + 1] for i in range(0, len(pixels), 2))
+
+
+def c_array(data, indent='    '):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append(indent + ', '.join('0x%02X' % b for b in data[i:i + 16]) + ',')
+    return '\n'.join(lines)
+
+
+def main():
+    polys = segment_polygons()
+    digits = []
+    for g in GLYPHS:
+        segs = [polys[s] for s in SEGMENTS[g]]
+        digits.append(pack(render(CELL_W, lambda x, y: any(inside(p, x, y) for p in segs))))
+
+    r = THICK * 0.65
+    cx, cy = DOT_W / 2, CELL_H - MARGIN - r
+    dot = pack(render(DOT_W, lambda x, y: (x - cx) ** 2 + (y - cy) ** 2 <= r * r))
+
+    root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    src = os.path.join(root, 'src')
+
+    with open(os.path.join(src, 'BigDigitGlyphs.h'), 'w') as f:
+        f.write('''#ifndef BIG_DIGIT_GLYPHS_H
+#define BIG_DIGIT_GLYPHS_H
+
+// Generated by scripts/gen_big_digits.py - do not edit
+
+#include <stdint.h>
+
+#define BIG_DIGIT_CELL_W    %d
+#define BIG_DIGIT_CELL_H    %d
+#define BIG_DIGIT_DOT_W     %d
+#define BIG_DIGIT_GLYPHS    "%s"
+#define BIG_DIGIT_GLYPH_COUNT %d
+
+// 4-bit alpha, two pixels per byte (first in the high nibble), row-major
+extern const uint8_t bigDigitGlyphs[BIG_DIGIT_GLYPH_COUNT][BIG_DIGIT_CELL_W * BIG_DIGIT_CELL_H / 2];
+extern const uint8_t bigDigitDot[BIG_DIGIT_DOT_W * BIG_DIGIT_CELL_H / 2];
+
+#endif // BIG_DIGIT_GLYPHS_H
+''' % (CELL_W, CELL_H, DOT_W, GLYPHS, len(GLYPHS)))
+
+    with open(os.path.join(src, 'BigDigitGlyphs.cpp'), 'w') as f:
+        f.write('// Generated by scripts/gen_big_digits.py - do not edit\n\n')
+        f.write('#include "BigDigitGlyphs.h"\n\n')
+        f.write('const uint8_t bigDigitGlyphs[BIG_DIGIT_GLYPH_COUNT][BIG_DIGIT_CELL_W * BIG_DIGIT_CELL_H / 2] = {\n')
+        for g, data in zip(GLYPHS, digits):
+            f.write("    {   // '%s'\n%s\n    },\n" % (g, c_array(data, ' ' * 8)))
+        f.write('};\n\n')
+        f.write('const uint8_t bigDigitDot[BIG_DIGIT_DOT_W * BIG_DIGIT_CELL_H / 2] = {\n')
+        f.write(c_array(dot) + '\n};\n')
+
+    size = sum(len(d) for d in digits) + len(dot)
+    print('Wrote src/BigDigitGlyphs.h/.cpp: %d glyphs, %d bytes' % (len(GLYPHS) + 1, size))
+
+
+if __name__ == '__main__':
+    main()
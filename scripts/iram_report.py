@@ -0,0 +1,136 @@
+"""
+PlatformIO post-link script: report internal RAM usage and where the hot
+path (see src/HotPath.h) ended up.
+
+Prints, and writes to <build dir>/iram_report.txt:
+  - IRAM/DRAM section sizes of the firmware ELF
+  - each hot path function with its size and whether it is in IRAM or flash
+  - the largest IRAM symbols
+
+Build with HOT_PATH_IRAM=1 and =0 (platformio.ini) to see what the hot path
+costs in IRAM; the same functions are timed on the device by GET /api/hotpath.
+"""
+
+import os
+import re
+import subprocess
+
+Import("env")
+
+# Functions the HOT_PATH_ATTR / LV_ATTRIBUTE_FAST_MEM placement is meant to
+# cover, as regular expressions over demangled symbol names
+HOT_PATH = [
+    r"^my_disp_flush\(",
+    r"^my_touchpad_read\(",
+    r"^GT911::getLatest",
+    r"^firstPoint\(",
+    r"^HardwareControl::(update|checkDispensing|getDispensedAmount|getFlowRate)\(",
+    r"^MetricHistogram::observe\(",
+    r"^lv_draw_sw_blend_basic$",
+    r"^(fill|map)_(normal|set_px|blended|argb)",
+    r"^lv_color_fill$",
+    r"^lv_mem(cpy|set)",
+    r"^lv_disp_flush_ready$",
+]
+
+# Output sections that live in internal RAM
+IRAM_SECTIONS = (".iram0.vectors", ".iram0.text")
+DRAM_SECTIONS = (".dram0.data", ".dram0.bss")
+
+TOP_SYMBOLS = 15
+
+
+def tool(name):
+    # xtensa-esp32s3-elf-gcc -> xtensa-esp32s3-elf-<name>
+    cc = env.subst("$CC")
+    return re.sub(r"gcc(\.exe)?$", name + r"\1", cc)
+
+
+def hot_path_flag():
+    for define in env.get("CPPDEFINES", []):
+        if isinstance(define, (list, tuple)) and define[0] == "HOT_PATH_IRAM":
+            return str(define[1])
+        if define == "HOT_PATH_IRAM":
+            return "1"
+    return "0"
+
+
+def read_sections(elf):
+    out = subprocess.check_output([tool("objdump"), "-h", elf], text=True)
+    sections = {}
+    for line in out.splitlines():
+        parts = line.split()
+        # Idx Name Size VMA LMA File-off Algn
+        if len(parts) >= 7 and parts[0].isdigit():
+            sections[parts[1]] = (int(parts[2], 16), int(parts[3], 16))
+    return sections
+
+
+def read_symbols(elf):
+    out = subprocess.check_output([tool("nm"), "-S", "-C", "--size-sort", elf], text=True)
+    symbols = []
+    for line in out.splitlines():
+        parts = line.split(None, 3)
+        if len(parts) == 4 and parts[2].lower() == "t":
+            symbols.append((int(parts[0], 16), int(parts[1], 16), parts[3]))
+    return symbols
+
+
+def build_report(elf):
+    sections = read_sections(elf)
+    iram_ranges = [(sections[s][1], sections[s][1] + sections[s][0]) for s in IRAM_SECTIONS if s in sections]
+
+    def in_iram(addr):
+        return any(lo <= addr < hi for lo, hi in iram_ranges)
+
+    lines = ["IRAM report (HOT_PATH_IRAM=%s)" % hot_path_flag()]
+
+    lines.append("")
+    iram_total = 0
+    for name in IRAM_SECTIONS + DRAM_SECTIONS:
+        if name in sections:
+            lines.append("  %-16s %8d bytes" % (name, sections[name][0]))
+            if name in IRAM_SECTIONS:
+                iram_total += sections[name][0]
+    lines.append("  %-16s %8d bytes" % ("IRAM total", iram_total))
+
+    symbols = read_symbols(elf)
+    hot = [re.compile(p) for p in HOT_PATH]
+    lines.append("")
+    lines.append("Hot path:")
+    hot_iram = 0
+    hot_flash = 0
+    for addr, size, name in sorted(symbols, key=lambda s: s[2]):
+        if not any(p.search(name) for p in hot):
+            continue
+        where = "IRAM" if in_iram(addr) else "flash"
+        if where == "IRAM":
+            hot_iram += size
+        else:
+            hot_flash += size
+        lines.append("  %-6s %6d  %s" % (where, size, name))
+    lines.append("  %d bytes in IRAM, %d bytes in flash" % (hot_iram, hot_flash))
+
+    lines.append("")
+    lines.append("Largest IRAM symbols:")
+    iram_symbols = [s for s in symbols if in_iram(s[0])]
+    for addr, size, name in sorted(iram_symbols, key=lambda s: -s[1])[:TOP_SYMBOLS]:
+        lines.append("  %6d  %s" % (size, name))
+
+    return "\n".join(lines) + "\n"
+
+
+def iram_report(source, target, env):
+    elf = str(target[0])
+    try:
+        report = build_report(elf)
+    except (OSError, subprocess.CalledProcessError) as e:
+        print("IRAM report skipped: %s" % e)
+        return
+
+    print(report)
+    with open(os.path.join(env.subst("$BUILD_DIR"), "iram_report.txt"), "w") as f:
+        f.write(report)
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", iram_report)
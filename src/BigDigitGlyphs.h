@@ -0,0 +1,18 @@
+#ifndef BIG_DIGIT_GLYPHS_H
+#define BIG_DIGIT_GLYPHS_H
+
+// Generated by scripts/gen_big_digits.py - do not edit
+
+#include <stdint.h>
+
+#define BIG_DIGIT_CELL_W    48
+#define BIG_DIGIT_CELL_H    88
+#define BIG_DIGIT_DOT_W     20
+#define BIG_DIGIT_GLYPHS    "0123456789-"
+#define BIG_DIGIT_GLYPH_COUNT 11
+
+// 4-bit alpha, two pixels per byte (first in the high nibble), row-major
+extern const uint8_t bigDigitGlyphs[BIG_DIGIT_GLYPH_COUNT][BIG_DIGIT_CELL_W * BIG_DIGIT_CELL_H / 2];
+extern const uint8_t bigDigitDot[BIG_DIGIT_DOT_W * BIG_DIGIT_CELL_H / 2];
+
+#endif // BIG_DIGIT_GLYPHS_H
@@ -0,0 +1,175 @@
+#include "BigDigits.h"
+#include "BigDigitGlyphs.h"
+#include <esp_heap_caps.h>
+
+#define GLYPH_SIZE  (BIG_DIGIT_CELL_W * BIG_DIGIT_CELL_H)
+#define DOT_INDEX   BIG_DIGIT_GLYPH_COUNT
+
+// 8-bit alpha copy of the atlas, shared by all readouts: the digit glyphs
+// followed by the decimal point
+static uint8_t* atlas = nullptr;
+
+BigDigits::BigDigits() {
+    _obj = nullptr;
+    _intDigits = 0;
+    _decimals = 0;
+    _cellCount = 0;
+}
+
+lv_obj_t* BigDigits::create(lv_obj_t* parent, uint8_t intDigits, uint8_t decimals) {
+    if (intDigits < 1) intDigits = 1;
+    if (intDigits + decimals + 1 > BIG_DIGITS_MAX_CELLS) {
+        decimals = 0;
+        intDigits = BIG_DIGITS_MAX_CELLS;
+    }
+    _intDigits = intDigits;
+    _decimals = decimals;
+    _cellCount = intDigits + (decimals > 0 ? 1 + decimals : 0);
+    memset(_cells, ' ', sizeof(_cells));
+
+    expandAtlas();
+
+    _obj = lv_obj_create(parent);
+    lv_obj_remove_style_all(_obj);
+    lv_obj_clear_flag(_obj, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_size(_obj, cellX(_cellCount), BIG_DIGIT_CELL_H);
+    lv_obj_add_event_cb(_obj, drawEventHandler, LV_EVENT_DRAW_MAIN, this);
+
+    setValue(0);
+    return _obj;
+}
+
+lv_coord_t BigDigits::cellX(uint8_t cell) const {
+    // The point cell is narrower than the digit cells
+    if (_decimals > 0 && cell > _intDigits) {
+        return (cell - 1) * BIG_DIGIT_CELL_W + BIG_DIGIT_DOT_W;
+    }
+    return cell * BIG_DIGIT_CELL_W;
+}
+
+lv_coord_t BigDigits::cellWidth(uint8_t cell) const {
+    return (_decimals > 0 && cell == _intDigits) ? BIG_DIGIT_DOT_W : BIG_DIGIT_CELL_W;
+}
+
+void BigDigits::format(int32_t scaled, char* cells) const {
+    bool negative = scaled < 0;
+    uint32_t v = negative ? -(uint32_t)scaled : scaled;
+
+    // Right to left: decimals, point, then integer digits until v runs out
+    int8_t cell = _cellCount - 1;
+    for (uint8_t i = 0; i < _decimals; i++) {
+        cells[cell--] = '0' + v % 10;
+        v /= 10;
+    }
+    if (_decimals > 0) {
+        cells[cell--] = '.';
+    }
+    for (uint8_t i = 0; i < _intDigits; i++, cell--) {
+        if (i == 0 || v > 0) {
+            cells[cell] = '0' + v % 10;
+            v /= 10;
+        } else if (negative) {
+            cells[cell] = '-';
+            negative = false;
+        } else {
+            cells[cell] = ' ';
+        }
+    }
+
+    // Too large for the cells: show all dashes rather than a wrong number
+    if (v > 0 || negative) {
+        for (uint8_t i = 0; i < _cellCount; i++) {
+            if (cells[i] != '.') cells[i] = '-';
+        }
+    }
+}
+
+void BigDigits::setValue(int32_t scaled) {
+    char cells[BIG_DIGITS_MAX_CELLS];
+    format(scaled, cells);
+
+    lv_area_t coords;
+    lv_obj_get_coords(_obj, &coords);
+
+    for (uint8_t i = 0; i < _cellCount; i++) {
+        if (cells[i] == _cells[i]) continue;
+        _cells[i] = cells[i];
+
+        lv_area_t area;
+        area.x1 = coords.x1 + cellX(i);
+        area.x2 = area.x1 + cellWidth(i) - 1;
+        area.y1 = coords.y1;
+        area.y2 = coords.y2;
+        lv_obj_invalidate_area(_obj, &area);
+    }
+}
+
+const uint8_t* BigDigits::expandAtlas() {
+    if (atlas != nullptr) return atlas;
+
+    size_t size = BIG_DIGIT_GLYPH_COUNT * GLYPH_SIZE + BIG_DIGIT_DOT_W * BIG_DIGIT_CELL_H;
+    atlas = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (atlas == nullptr) {
+        atlas = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_8BIT);
+    }
+    if (atlas == nullptr) return nullptr;
+
+    // 4-bit to 8-bit alpha: 0xF becomes 0xFF
+    const uint8_t* src = &bigDigitGlyphs[0][0];
+    size_t digitBytes = BIG_DIGIT_GLYPH_COUNT * GLYPH_SIZE / 2;
+    for (size_t i = 0; i < digitBytes; i++) {
+        atlas[i * 2] = (src[i] >> 4) * 0x11;
+        atlas[i * 2 + 1] = (src[i] & 0x0F) * 0x11;
+    }
+    uint8_t* dot = atlas + BIG_DIGIT_GLYPH_COUNT * GLYPH_SIZE;
+    for (size_t i = 0; i < sizeof(bigDigitDot); i++) {
+        dot[i * 2] = (bigDigitDot[i] >> 4) * 0x11;
+        dot[i * 2 + 1] = (bigDigitDot[i] & 0x0F) * 0x11;
+    }
+    return atlas;
+}
+
+void BigDigits::drawEventHandler(lv_event_t* e) {
+    BigDigits* self = (BigDigits*)lv_event_get_user_data(e);
+    lv_obj_t* obj = lv_event_get_target(e);
+    lv_draw_ctx_t* draw_ctx = lv_event_get_draw_ctx(e);
+    if (atlas == nullptr) return;
+
+    lv_area_t coords;
+    lv_obj_get_coords(obj, &coords);
+
+    lv_draw_sw_blend_dsc_t blend;
+    lv_memset_00(&blend, sizeof(blend));
+    blend.color = lv_obj_get_style_text_color(obj, LV_PART_MAIN);
+    blend.opa = lv_obj_get_style_text_opa(obj, LV_PART_MAIN);
+    blend.blend_mode = LV_BLEND_MODE_NORMAL;
+    blend.mask_res = LV_DRAW_MASK_RES_CHANGED;
+
+    for (uint8_t i = 0; i < self->_cellCount; i++) {
+        const char* glyph = strchr(BIG_DIGIT_GLYPHS, self->_cells[i]);
+        const uint8_t* mask;
+        if (self->_cells[i] == '.') {
+            mask = atlas + BIG_DIGIT_GLYPH_COUNT * GLYPH_SIZE;
+        } else if (self->_cells[i] != ' ' && glyph != nullptr) {
+            mask = atlas + (glyph - BIG_DIGIT_GLYPHS) * GLYPH_SIZE;
+        } else {
+            continue;
+        }
+
+        lv_area_t cell;
+        cell.x1 = coords.x1 + self->cellX(i);
+        cell.x2 = cell.x1 + self->cellWidth(i) - 1;
+        cell.y1 = coords.y1;
+        cell.y2 = coords.y1 + BIG_DIGIT_CELL_H - 1;
+
+        // Cells outside the area being redrawn cost nothing
+        lv_area_t clipped;
+        if (!_lv_area_intersect(&clipped, &cell, draw_ctx->clip_area)) continue;
+
+        // The blend clips to draw_ctx->clip_area and offsets into the mask
+        blend.blend_area = &cell;
+        blend.mask_area = &cell;
+        blend.mask_buf = (lv_opa_t*)mask;
+        lv_draw_sw_blend(draw_ctx, &blend);
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef BIG_DIGITS_H
+#define BIG_DIGITS_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+
+#define BIG_DIGITS_MAX_CELLS    12
+
+// Large fixed-point readout drawn from a pre-rendered seven-segment atlas
+// (BigDigitGlyphs) instead of a font. Every character has its own fixed-width
+// cell, so a new value only invalidates the cells whose character changed
+// and a redraw is a plain alpha blend per cell, with no glyph lookup, kerning
+// or text layout. The colour comes from the object's text colour style.
+class BigDigits {
+public:
+    BigDigits();
+
+    // Create the readout: intDigits before the point, decimals after it.
+    // Leading zeros are blank; a negative value shows a minus sign.
+    lv_obj_t* create(lv_obj_t* parent, uint8_t intDigits, uint8_t decimals);
+
+    lv_obj_t* obj() const { return _obj; }
+
+    // Value scaled by 10^decimals, e.g. 1234 is "123.4" with one decimal
+    void setValue(int32_t scaled);
+
+private:
+    lv_obj_t* _obj;
+    uint8_t _intDigits;
+    uint8_t _decimals;
+    uint8_t _cellCount;
+    char _cells[BIG_DIGITS_MAX_CELLS];      // Shown character per cell, ' ' when blank
+
+    lv_coord_t cellX(uint8_t cell) const;
+    lv_coord_t cellWidth(uint8_t cell) const;
+    void format(int32_t scaled, char* cells) const;
+
+    static const uint8_t* expandAtlas();
+    static void drawEventHandler(lv_event_t* e);
+};
+
+#endif // BIG_DIGITS_H
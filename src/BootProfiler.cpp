@@ -0,0 +1,101 @@
+#include "BootProfiler.h"
+#include <esp_timer.h>
+#include <esp_system.h>
+#include <ArduinoJson.h>
+
+// Global instance
+BootProfiler bootProfiler;
+
+// Guards the table; phases are recorded from setup() and the network task
+static portMUX_TYPE bootLock = portMUX_INITIALIZER_UNLOCKED;
+
+static const char* resetReasonName(esp_reset_reason_t reason) {
+    switch (reason) {
+        case ESP_RST_POWERON:   return "power-on";
+        case ESP_RST_EXT:       return "external";
+        case ESP_RST_SW:        return "software";
+        case ESP_RST_PANIC:     return "panic";
+        case ESP_RST_INT_WDT:   return "interrupt watchdog";
+        case ESP_RST_TASK_WDT:  return "task watchdog";
+        case ESP_RST_WDT:       return "watchdog";
+        case ESP_RST_DEEPSLEEP: return "deep sleep";
+        case ESP_RST_BROWNOUT:  return "brownout";
+        case ESP_RST_SDIO:      return "sdio";
+        default:                return "unknown";
+    }
+}
+
+BootProfiler::BootProfiler() {
+    memset(_phases, 0, sizeof(_phases));
+    _count = 0;
+}
+
+int8_t BootProfiler::begin(const char* name) {
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    char task[configMAX_TASK_NAME_LEN];
+    strlcpy(task, pcTaskGetName(nullptr), sizeof(task));
+
+    int8_t slot = -1;
+    portENTER_CRITICAL(&bootLock);
+    if (_count < BOOT_MAX_PHASES) {
+        slot = _count++;
+        _phases[slot].name = name;
+        memcpy(_phases[slot].task, task, sizeof(task));
+        _phases[slot].startUs = now;
+        _phases[slot].endUs = 0;
+    }
+    portEXIT_CRITICAL(&bootLock);
+    return slot;
+}
+
+void BootProfiler::end(int8_t slot) {
+    if (slot < 0) return;
+    uint32_t now = (uint32_t)esp_timer_get_time();
+
+    portENTER_CRITICAL(&bootLock);
+    _phases[slot].endUs = now;
+    portEXIT_CRITICAL(&bootLock);
+}
+
+void BootProfiler::mark(const char* name) {
+    int8_t slot = begin(name);
+    if (slot < 0) return;
+
+    portENTER_CRITICAL(&bootLock);
+    _phases[slot].endUs = _phases[slot].startUs;
+    portEXIT_CRITICAL(&bootLock);
+}
+
+uint8_t BootProfiler::getPhases(BootPhaseRecord* records, uint8_t maxRecords) {
+    portENTER_CRITICAL(&bootLock);
+    uint8_t count = _count < maxRecords ? _count : maxRecords;
+    memcpy(records, _phases, count * sizeof(BootPhaseRecord));
+    portEXIT_CRITICAL(&bootLock);
+    return count;
+}
+
+String BootProfiler::getJSON() {
+    BootPhaseRecord phases[BOOT_MAX_PHASES];
+    uint8_t count = getPhases(phases, BOOT_MAX_PHASES);
+
+    DynamicJsonDocument doc(256 + count * 160);
+    doc["resetReason"] = resetReasonName(esp_reset_reason());
+    doc["uptimeMs"] = millis();
+
+    JsonArray list = doc.createNestedArray("phases");
+    for (uint8_t i = 0; i < count; i++) {
+        JsonObject p = list.createNestedObject();
+        p["name"] = phases[i].name;
+        p["task"] = phases[i].task;
+        p["startUs"] = phases[i].startUs;
+        if (phases[i].endUs == 0) {
+            p["durationUs"] = nullptr;      // Still running
+        } else if (phases[i].endUs != phases[i].startUs) {
+            p["durationUs"] = phases[i].endUs - phases[i].startUs;
+        }
+    }
+
+    String output;
+    serializeJson(doc, output);
+    return output;
+}
@@ -0,0 +1,43 @@
+#ifndef BOOT_PROFILER_H
+#define BOOT_PROFILER_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#define BOOT_MAX_PHASES 24
+
+struct BootPhaseRecord {
+    const char* name;       // Must be a string literal
+    char task[configMAX_TASK_NAME_LEN];  // Task that ran it; copied, the task may be gone
+    uint32_t startUs;       // Since reset (esp_timer)
+    uint32_t endUs;         // 0 while running; == startUs for a mark
+};
+
+// Timestamps of the boot phases, from setup() and the network start task.
+// Fixed table, no allocation; safe to call from any task.
+class BootProfiler {
+public:
+    BootProfiler();
+
+    // Start a phase. Returns its slot for end(), or -1 when the table is full.
+    int8_t begin(const char* name);
+    void end(int8_t slot);
+
+    // A point in time rather than a span (first frame, WiFi up)
+    void mark(const char* name);
+
+    // Copy all records. Returns the count.
+    uint8_t getPhases(BootPhaseRecord* records, uint8_t maxRecords);
+
+    String getJSON();
+
+private:
+    BootPhaseRecord _phases[BOOT_MAX_PHASES];
+    uint8_t _count;
+};
+
+// Global instance
+extern BootProfiler bootProfiler;
+
+#endif // BOOT_PROFILER_H
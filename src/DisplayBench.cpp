@@ -0,0 +1,178 @@
+#include "DisplayBench.h"
+#include "config.h"
+#include "Log.h"
+#include <lvgl.h>
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include <Preferences.h>
+#include <ArduinoJson.h>
+
+// Global instance
+DisplayBench displayBench;
+
+// Scratch namespace for the flash load; erased when the run ends
+#define BENCH_PREFS_NAMESPACE "dispbench"
+
+DisplayBench::DisplayBench() {
+    _phase = BENCH_IDLE;
+    _requestedSeconds = 0;
+    _seconds = 0;
+    _phaseStart = 0;
+    memset(&_baseline, 0, sizeof(_baseline));
+    memset(&_load, 0, sizeof(_load));
+    _loadActive = false;
+    _udpPackets = 0;
+    _nvsWrites = 0;
+}
+
+void DisplayBench::begin() {
+    metrics.addCollector(collect);
+}
+
+bool DisplayBench::start(uint16_t seconds) {
+    if (isRunning() || _requestedSeconds != 0 || seconds == 0) {
+        return false;
+    }
+    _requestedSeconds = seconds;
+    return true;
+}
+
+void DisplayBench::update() {
+    if (_requestedSeconds != 0 && !isRunning()) {
+        _seconds = _requestedSeconds;
+        _requestedSeconds = 0;
+        memset(&_baseline, 0, sizeof(_baseline));
+        memset(&_load, 0, sizeof(_load));
+        LOG_INFO("Display bench: %us baseline, then %us under load", _seconds, _seconds);
+        enterPhase(BENCH_BASELINE);
+        return;
+    }
+
+    if (!isRunning()) return;
+
+    if (_phase == BENCH_LOAD) {
+        // Render load: redraw the whole screen on every LVGL pass
+        lv_obj_invalidate(lv_scr_act());
+    }
+
+    if (millis() - _phaseStart < (unsigned long)_seconds * 1000) return;
+
+    if (_phase == BENCH_BASELINE) {
+        finishPhase(_baseline);
+        enterPhase(BENCH_LOAD);
+    } else {
+        _loadActive = false;
+        finishPhase(_load);
+        _load.udpPackets = _udpPackets;
+        _load.nvsWrites = _nvsWrites;
+        enterPhase(BENCH_DONE);
+
+        LOG_INFO("Display bench: late frames %u/%u baseline, %u/%u under load (max interval %u us, period %u us)",
+                 _baseline.frames.lateFrames, _baseline.frames.frames,
+                 _load.frames.lateFrames, _load.frames.frames,
+                 _load.frames.maxIntervalUs, _load.frames.periodUs);
+    }
+}
+
+void DisplayBench::enterPhase(DisplayBenchPhase phase) {
+    _phase = phase;
+    _phaseStart = millis();
+    resetFrameStats();
+
+    if (phase == BENCH_LOAD) {
+        _udpPackets = 0;
+        _nvsWrites = 0;
+        _loadActive = true;
+        // Same priority as loop() so the load competes with real work
+        xTaskCreate(loadTask, "bench_load", 4096, this, 1, nullptr);
+    }
+}
+
+void DisplayBench::finishPhase(DisplayBenchResult& result) {
+    result.frames = getFrameStats();
+}
+
+void DisplayBench::loadTask(void* arg) {
+    DisplayBench* self = (DisplayBench*)arg;
+    WiFiUDP udp;
+    Preferences prefs;
+    static uint8_t payload[1400];
+    unsigned long start = millis();
+    unsigned long lastFlashWrite = 0;
+    uint32_t packetsSent = 0;
+
+    memset(payload, 0xA5, sizeof(payload));
+    prefs.begin(BENCH_PREFS_NAMESPACE, false);
+
+    // Unicast to one host, never broadcast: the load must stay on this link
+    IPAddress target;
+    if (!target.fromString(DISPLAY_BENCH_UDP_HOST)) {
+        target = WiFi.gatewayIP();
+    }
+
+    while (self->_loadActive) {
+        // WiFi: packets to the discard port keep the radio and lwIP busy, paced
+        // to DISPLAY_BENCH_UDP_RATE
+        uint32_t due = (uint64_t)(millis() - start) * DISPLAY_BENCH_UDP_RATE / 1000;
+        if (WiFi.status() == WL_CONNECTED && (uint32_t)target != 0) {
+            for (uint8_t i = 0; i < 8 && packetsSent < due; i++) {
+                packetsSent++;
+                udp.beginPacket(target, 9);
+                udp.write(payload, sizeof(payload));
+                if (udp.endPacket()) {
+                    self->_udpPackets = self->_udpPackets + 1;
+                }
+            }
+        }
+        // Don't let a disconnected stretch turn into a burst later
+        if (due > packetsSent + 8) packetsSent = due - 8;
+
+        // Flash: NVS writes disable the cache while they erase/program
+        if (self->_nvsWrites < DISPLAY_BENCH_NVS_MAX_WRITES &&
+            millis() - lastFlashWrite >= DISPLAY_BENCH_NVS_INTERVAL) {
+            payload[0]++;
+            prefs.putBytes("blob", payload, 1024);
+            metrics.nvsWrites.inc();
+            self->_nvsWrites = self->_nvsWrites + 1;
+            lastFlashWrite = millis();
+        }
+
+        vTaskDelay(1);
+    }
+
+    prefs.clear();
+    prefs.end();
+    vTaskDelete(nullptr);
+}
+
+String DisplayBench::getStatusJSON() {
+    StaticJsonDocument<512> doc;
+    static const char* const phaseNames[] = { "idle", "baseline", "load", "done" };
+
+    doc["phase"] = phaseNames[_phase];
+    doc["seconds"] = _seconds;
+
+    const DisplayBenchResult* results[] = { &_baseline, &_load };
+    const char* keys[] = { "baseline", "load" };
+    for (uint8_t i = 0; i < 2; i++) {
+        JsonObject r = doc.createNestedObject(keys[i]);
+        r["frames"] = results[i]->frames.frames;
+        r["lateFrames"] = results[i]->frames.lateFrames;
+        r["maxIntervalUs"] = results[i]->frames.maxIntervalUs;
+        r["periodUs"] = results[i]->frames.periodUs;
+    }
+    doc["load"]["udpPackets"] = _load.udpPackets;
+    doc["load"]["nvsWrites"] = _load.nvsWrites;
+
+    String output;
+    serializeJson(doc, output);
+    return output;
+}
+
+void DisplayBench::collect(PrometheusWriter& w) {
+    DisplayFrameStats s = getFrameStats();
+    w.gauge("waterdisp_display_late_frames", "Frame-done interrupts since the last reset that came over 1.5x the nominal period apart",
+            s.lateFrames);
+    w.gauge("waterdisp_display_max_frame_interval_microseconds", "Longest frame interval since the last reset",
+            s.maxIntervalUs);
+}
@@ -0,0 +1,66 @@
+#ifndef DISPLAY_BENCH_H
+#define DISPLAY_BENCH_H
+
+#include <Arduino.h>
+#include "display_driver.h"
+#include "Metrics.h"
+
+enum DisplayBenchPhase {
+    BENCH_IDLE,
+    BENCH_BASELINE,     // Normal operation, for comparison
+    BENCH_LOAD,         // Paced UDP + NVS writes + full-screen redraws
+    BENCH_DONE
+};
+
+struct DisplayBenchResult {
+    DisplayFrameStats frames;
+    uint32_t udpPackets;
+    uint32_t nvsWrites;
+};
+
+// Measures frame-done interrupt timing (late frames, longest interval) with
+// and without combined WiFi, flash and render load. This shows interrupt
+// latency and stalled transfers, not PSRAM underruns, which corrupt pixels
+// without delaying the interrupt. Driven from the LVGL task via update().
+class DisplayBench {
+public:
+    DisplayBench();
+
+    // Registers the /metrics collector
+    void begin();
+
+    // Request a run; each phase lasts 'seconds'. Safe to call from any task.
+    bool start(uint16_t seconds);
+
+    // Advances the phases and generates render load. Call from the LVGL thread.
+    void update();
+
+    bool isRunning() const { return _phase == BENCH_BASELINE || _phase == BENCH_LOAD; }
+
+    String getStatusJSON();
+
+private:
+    volatile DisplayBenchPhase _phase;
+    volatile uint16_t _requestedSeconds;
+    uint16_t _seconds;
+    unsigned long _phaseStart;
+
+    DisplayBenchResult _baseline;
+    DisplayBenchResult _load;
+
+    // Written by the load task
+    volatile bool _loadActive;
+    volatile uint32_t _udpPackets;
+    volatile uint32_t _nvsWrites;
+
+    void enterPhase(DisplayBenchPhase phase);
+    void finishPhase(DisplayBenchResult& result);
+
+    static void loadTask(void* arg);
+    static void collect(PrometheusWriter& writer);
+};
+
+// Global instance
+extern DisplayBench displayBench;
+
+#endif // DISPLAY_BENCH_H
@@ -0,0 +1,360 @@
+#include "DrawBufferTuner.h"
+#include "DisplayBench.h"
+#include "IdleManager.h"
+#include "UITheme.h"
+#include "Log.h"
+#include <esp_heap_caps.h>
+#include <Preferences.h>
+#include <ArduinoJson.h>
+
+// Global instance
+DrawBufferTuner drawBufferTuner;
+
+static const uint16_t tuneLines[] = DRAW_BUF_TUNE_LINES;
+static const uint8_t tuneLineCount = sizeof(tuneLines) / sizeof(tuneLines[0]);
+static_assert(tuneLineCount * 4 <= DRAW_BUF_MAX_CANDIDATES, "Too many DRAW_BUF_TUNE_LINES entries");
+
+static const char* placementName(DrawBufPlacement placement) {
+    return placement == DRAW_BUF_PSRAM ? "psram" : "internal";
+}
+
+static uint32_t placementCaps(DrawBufPlacement placement) {
+    return (placement == DRAW_BUF_PSRAM ? MALLOC_CAP_SPIRAM : MALLOC_CAP_INTERNAL) | MALLOC_CAP_8BIT;
+}
+
+DrawBufferTuner::DrawBufferTuner() {
+    _drawBuf = nullptr;
+    _config = { DRAW_BUF_DEFAULT_LINES, DRAW_BUF_INTERNAL, true };
+    _source = DRAW_BUF_SRC_DEFAULT;
+    _buf1 = nullptr;
+    _buf2 = nullptr;
+    _tuneRequested = false;
+    _tuning = false;
+    _tuneMs = 0;
+    _lastTuneTime = 0;
+    memset(_candidates, 0, sizeof(_candidates));
+    _candidateCount = 0;
+}
+
+bool DrawBufferTuner::begin(lv_disp_draw_buf_t* drawBuf) {
+    _drawBuf = drawBuf;
+
+    DrawBufConfig wanted = _config;
+    bool stored = loadConfig(wanted);
+
+    if (allocate(wanted)) {
+        _source = stored ? DRAW_BUF_SRC_STORED : DRAW_BUF_SRC_DEFAULT;
+    } else {
+        // Same size in PSRAM, then the smallest single buffer anywhere
+        const DrawBufConfig fallbacks[] = {
+            { wanted.lines, DRAW_BUF_PSRAM, wanted.dual },
+            { tuneLines[0], DRAW_BUF_INTERNAL, false },
+            { tuneLines[0], DRAW_BUF_PSRAM, false }
+        };
+        bool allocated = false;
+        for (const DrawBufConfig& config : fallbacks) {
+            if (allocate(config)) {
+                allocated = true;
+                break;
+            }
+        }
+        if (!allocated) {
+            LOG_ERROR("Failed to allocate display draw buffer!");
+            _drawBuf = nullptr;
+            return false;
+        }
+        LOG_WARN("Draw buffers: %u lines in %s did not fit", wanted.lines, placementName(wanted.placement));
+        _source = DRAW_BUF_SRC_FALLBACK;
+    }
+
+    LOG_INFO("Draw buffers: %ux%u lines in %s (%u bytes each)",
+             _config.dual ? 2 : 1, _config.lines, placementName(_config.placement),
+             (unsigned)bufferBytes(_config));
+
+    metrics.addCollector(collect);
+
+    // Nothing stored yet: tune once the UI is up
+    if (!stored) {
+        _tuneRequested = true;
+    }
+    return true;
+}
+
+bool DrawBufferTuner::requestTune() {
+    if (_drawBuf == nullptr || _tuneRequested || _tuning) {
+        return false;
+    }
+    _tuneRequested = true;
+    return true;
+}
+
+void DrawBufferTuner::update() {
+    if (!_tuneRequested || _drawBuf == nullptr) return;
+
+    // The benchmark's redraws would skew the timings, and the other way round
+    if (displayBench.isRunning()) return;
+
+    _tuneRequested = false;
+    tune();
+}
+
+size_t DrawBufferTuner::bufferBytes(const DrawBufConfig& config) {
+    return (size_t)SCREEN_WIDTH * config.lines * sizeof(lv_color_t);
+}
+
+bool DrawBufferTuner::allocate(const DrawBufConfig& config) {
+    uint32_t caps = placementCaps(config.placement);
+    size_t bytes = bufferBytes(config);
+    size_t total = config.dual ? bytes * 2 : bytes;
+    size_t reserve = config.placement == DRAW_BUF_PSRAM ? DRAW_BUF_PSRAM_RESERVE : DRAW_BUF_INTERNAL_RESERVE;
+
+    // Leave room for everything that starts after the display
+    if (heap_caps_get_free_size(caps) < total + reserve) {
+        return false;
+    }
+
+    void* buf1 = heap_caps_aligned_alloc(64, bytes, caps);
+    void* buf2 = config.dual ? heap_caps_aligned_alloc(64, bytes, caps) : nullptr;
+    if (buf1 == nullptr || (config.dual && buf2 == nullptr)) {
+        heap_caps_free(buf1);
+        heap_caps_free(buf2);
+        return false;
+    }
+
+    _buf1 = buf1;
+    _buf2 = buf2;
+    _config = config;
+    lv_disp_draw_buf_init(_drawBuf, buf1, buf2, SCREEN_WIDTH * config.lines);
+    return true;
+}
+
+void DrawBufferTuner::release() {
+    heap_caps_free(_buf1);
+    heap_caps_free(_buf2);
+    _buf1 = nullptr;
+    _buf2 = nullptr;
+}
+
+// What the candidates are timed on: the same on every run, whatever screen
+// the UI is on, and made of the theme's buttons, text and bar so it costs
+// about what a real screen does
+lv_obj_t* DrawBufferTuner::createReferenceScreen() {
+    lv_obj_t* scr = lv_obj_create(NULL);
+    lv_obj_add_style(scr, &uiTheme.screen, 0);
+
+    lv_obj_t* title = lv_label_create(scr);
+    lv_obj_add_style(title, &uiTheme.title, 0);
+    lv_label_set_text(title, "Draw buffer tuning");
+    lv_obj_align(title, LV_ALIGN_TOP_MID, 0, 20);
+
+    lv_style_t* const buttonStyles[] = {
+        &uiTheme.btnPrimary, &uiTheme.btnInfo, &uiTheme.btnWarning,
+        &uiTheme.btnAccent, &uiTheme.btnNeutral, &uiTheme.btnDanger
+    };
+    for (uint8_t i = 0; i < 6; i++) {
+        lv_obj_t* btn = lv_btn_create(scr);
+        lv_obj_add_style(btn, buttonStyles[i], 0);
+        lv_obj_set_size(btn, 220, 100);
+        lv_obj_set_pos(btn, 40 + (i % 3) * 250, 90 + (i / 3) * 130);
+
+        lv_obj_t* label = lv_label_create(btn);
+        lv_obj_add_style(label, &uiTheme.textLarge, 0);
+        lv_label_set_text_fmt(label, "%u ml", 250u * (i + 1));
+        lv_obj_center(label);
+    }
+
+    lv_obj_t* bar = lv_bar_create(scr);
+    lv_obj_add_style(bar, &uiTheme.panel, 0);
+    lv_obj_add_style(bar, &uiTheme.btnPrimary, LV_PART_INDICATOR);
+    lv_obj_set_size(bar, 720, 30);
+    lv_obj_align(bar, LV_ALIGN_BOTTOM_MID, 0, -70);
+    lv_bar_set_value(bar, 60, LV_ANIM_OFF);
+
+    lv_obj_t* value = lv_label_create(scr);
+    lv_obj_add_style(value, &uiTheme.value, 0);
+    lv_label_set_text(value, "1234.5 ml");
+    lv_obj_align(value, LV_ALIGN_BOTTOM_MID, 0, -15);
+
+    return scr;
+}
+
+uint32_t DrawBufferTuner::measure(lv_disp_t* disp) {
+    // One untimed pass so image caches and the new buffers are warm
+    lv_obj_invalidate(lv_scr_act());
+    lv_refr_now(disp);
+
+    uint32_t start = micros();
+    for (uint8_t i = 0; i < DRAW_BUF_TUNE_FRAMES; i++) {
+        lv_obj_invalidate(lv_scr_act());
+        lv_refr_now(disp);
+    }
+    return (micros() - start) / DRAW_BUF_TUNE_FRAMES;
+}
+
+void DrawBufferTuner::tune() {
+    lv_disp_t* disp = lv_disp_get_default();
+    if (disp == nullptr) return;
+
+    _tuning = true;
+    idleManager.lock(PM_LOCK_RENDER);
+    uint32_t start = millis();
+    LOG_INFO("Draw buffers: tuning %u candidates", tuneLineCount * 4);
+
+    DrawBufConfig previous = _config;
+    release();
+
+    lv_obj_t* shown = lv_scr_act();
+    lv_obj_t* reference = createReferenceScreen();
+    lv_scr_load(reference);
+
+    _candidateCount = 0;
+    for (uint8_t l = 0; l < tuneLineCount; l++) {
+        for (uint8_t p = 0; p < 2; p++) {
+            for (uint8_t d = 0; d < 2; d++) {
+                DrawBufCandidate& c = _candidates[_candidateCount++];
+                c.config = { tuneLines[l], (DrawBufPlacement)p, d == 1 };
+                c.frameUs = 0;
+                c.fits = allocate(c.config);
+                if (!c.fits) continue;
+
+                c.frameUs = measure(disp);
+                release();
+
+                // Let the idle task run between candidates
+                vTaskDelay(1);
+            }
+        }
+    }
+
+    // Fastest first; anything within the tolerance of it that needs less
+    // internal RAM (then less memory overall) wins
+    uint32_t fastest = UINT32_MAX;
+    for (uint8_t i = 0; i < _candidateCount; i++) {
+        if (_candidates[i].fits && _candidates[i].frameUs < fastest) {
+            fastest = _candidates[i].frameUs;
+        }
+    }
+    uint32_t limit = fastest + fastest / 100 * DRAW_BUF_TUNE_TOLERANCE;
+
+    int8_t best = -1;
+    size_t bestInternal = 0;
+    size_t bestTotal = 0;
+    for (uint8_t i = 0; i < _candidateCount; i++) {
+        const DrawBufCandidate& c = _candidates[i];
+        if (!c.fits || c.frameUs > limit) continue;
+
+        size_t total = bufferBytes(c.config) * (c.config.dual ? 2 : 1);
+        size_t internal = c.config.placement == DRAW_BUF_INTERNAL ? total : 0;
+        if (best < 0 || internal < bestInternal || (internal == bestInternal && total < bestTotal)) {
+            best = i;
+            bestInternal = internal;
+            bestTotal = total;
+        }
+    }
+
+    if (best >= 0 && allocate(_candidates[best].config)) {
+        saveConfig(_config);
+        _source = DRAW_BUF_SRC_TUNED;
+        LOG_INFO("Draw buffers: picked %ux%u lines in %s, %u us per frame",
+                 _config.dual ? 2 : 1, _config.lines, placementName(_config.placement),
+                 _candidates[best].frameUs);
+    } else if (allocate(previous)) {
+        LOG_WARN("Draw buffers: tuning found nothing usable, keeping %u lines", previous.lines);
+    } else if (allocate({ tuneLines[0], DRAW_BUF_INTERNAL, false }) ||
+               allocate({ tuneLines[0], DRAW_BUF_PSRAM, false })) {
+        _source = DRAW_BUF_SRC_FALLBACK;
+        LOG_WARN("Draw buffers: previous configuration no longer fits, using %u lines", _config.lines);
+    } else {
+        // Memory is gone that was there a moment ago; nothing sane to draw into
+        LOG_ERROR("Failed to allocate display draw buffer!");
+        abort();
+    }
+
+    // Back to the UI's screen, redrawn with the buffers that stay
+    lv_scr_load(shown);
+    lv_obj_del(reference);
+    lv_obj_invalidate(lv_scr_act());
+
+    _tuneMs = millis() - start;
+    _lastTuneTime = millis();
+    idleManager.unlock(PM_LOCK_RENDER);
+    _tuning = false;
+}
+
+bool DrawBufferTuner::loadConfig(DrawBufConfig& config) {
+    Preferences prefs;
+    if (!prefs.begin(PREFS_NAMESPACE, true)) return false;
+
+    bool found = prefs.isKey("dbuf_lines");
+    if (found) {
+        uint16_t lines = prefs.getUShort("dbuf_lines", DRAW_BUF_DEFAULT_LINES);
+        if (lines > 0 && lines <= SCREEN_HEIGHT) {
+            config.lines = lines;
+            config.placement = prefs.getBool("dbuf_psram", false) ? DRAW_BUF_PSRAM : DRAW_BUF_INTERNAL;
+            config.dual = prefs.getBool("dbuf_double", true);
+        } else {
+            found = false;
+        }
+    }
+    prefs.end();
+    return found;
+}
+
+void DrawBufferTuner::saveConfig(const DrawBufConfig& config) {
+    Preferences prefs;
+    if (prefs.begin(PREFS_NAMESPACE, false)) {
+        prefs.putUShort("dbuf_lines", config.lines);
+        prefs.putBool("dbuf_psram", config.placement == DRAW_BUF_PSRAM);
+        prefs.putBool("dbuf_double", config.dual);
+        prefs.end();
+    }
+}
+
+String DrawBufferTuner::getStatusJSON() {
+    static const char* const sourceNames[] = { "default", "stored", "tuned", "fallback" };
+    DynamicJsonDocument doc(512 + _candidateCount * 128);
+
+    doc["active"] = isActive();
+    if (isActive()) {
+        doc["lines"] = _config.lines;
+        doc["placement"] = placementName(_config.placement);
+        doc["double"] = _config.dual;
+        doc["bytes"] = bufferBytes(_config) * (_config.dual ? 2 : 1);
+        doc["source"] = sourceNames[_source];
+    }
+    doc["tuning"] = _tuning || _tuneRequested;
+    doc["tuneMs"] = _tuneMs;
+    if (_lastTuneTime != 0) {
+        doc["tuneAgeMs"] = millis() - _lastTuneTime;
+    } else {
+        doc["tuneAgeMs"] = nullptr;
+    }
+    doc["freeInternal"] = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    doc["freePsram"] = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+
+    JsonArray list = doc.createNestedArray("candidates");
+    for (uint8_t i = 0; i < _candidateCount; i++) {
+        const DrawBufCandidate& c = _candidates[i];
+        JsonObject entry = list.createNestedObject();
+        entry["lines"] = c.config.lines;
+        entry["placement"] = placementName(c.config.placement);
+        entry["double"] = c.config.dual;
+        entry["fits"] = c.fits;
+        if (c.fits) {
+            entry["frameUs"] = c.frameUs;
+        } else {
+            entry["frameUs"] = nullptr;
+        }
+    }
+
+    String output;
+    serializeJson(doc, output);
+    return output;
+}
+
+void DrawBufferTuner::collect(PrometheusWriter& w) {
+    const DrawBufConfig& c = drawBufferTuner._config;
+    w.gauge("waterdisp_lvgl_draw_buffer_lines", "Height of each LVGL draw buffer in rows", c.lines);
+    w.gauge("waterdisp_lvgl_draw_buffer_count", "LVGL draw buffers (2 = render while flushing)", c.dual ? 2 : 1);
+    w.gauge("waterdisp_lvgl_draw_buffer_psram", "1 when the LVGL draw buffers are in PSRAM", c.placement == DRAW_BUF_PSRAM);
+}
@@ -0,0 +1,91 @@
+#ifndef DRAW_BUFFER_TUNER_H
+#define DRAW_BUFFER_TUNER_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include "config.h"
+#include "Metrics.h"
+
+// Four candidates (internal/PSRAM, single/double) per DRAW_BUF_TUNE_LINES entry
+#define DRAW_BUF_MAX_CANDIDATES 32
+
+enum DrawBufPlacement : uint8_t {
+    DRAW_BUF_INTERNAL,
+    DRAW_BUF_PSRAM
+};
+
+struct DrawBufConfig {
+    uint16_t lines;             // Buffer height in screen rows
+    DrawBufPlacement placement;
+    bool dual;                  // Two buffers: render one while the other is flushed
+};
+
+struct DrawBufCandidate {
+    DrawBufConfig config;
+    bool fits;                  // Allocated with the reserves left free
+    uint32_t frameUs;           // Average full-screen redraw incl. flush, 0 if not run
+};
+
+enum DrawBufSource {
+    DRAW_BUF_SRC_DEFAULT,       // Not tuned yet
+    DRAW_BUF_SRC_STORED,        // Loaded from Preferences
+    DRAW_BUF_SRC_TUNED,         // Picked by a tuning run since boot
+    DRAW_BUF_SRC_FALLBACK       // Wanted configuration did not fit
+};
+
+// Owns the LVGL draw buffers. A tuning run redraws a fixed reference screen
+// with every candidate height, placement and buffer count, keeps the fastest
+// that fits and stores it in Preferences for the next boot.
+class DrawBufferTuner {
+public:
+    DrawBufferTuner();
+
+    // Allocate the stored configuration (or the default) into drawBuf.
+    // Call before lv_disp_drv_register(); schedules a tuning run if nothing
+    // was stored yet.
+    bool begin(lv_disp_draw_buf_t* drawBuf);
+
+    // Request a tuning run. Safe to call from any task; false when the
+    // buffers are not set up yet or a run is already pending.
+    bool requestTune();
+
+    // Runs a requested tuning pass. Call from the LVGL thread.
+    void update();
+
+    bool isActive() const { return _drawBuf != nullptr; }
+    bool isTuning() const { return _tuning; }
+
+
+    String getStatusJSON();
+
+private:
+    lv_disp_draw_buf_t* _drawBuf;
+    DrawBufConfig _config;
+    DrawBufSource _source;
+    void* _buf1;
+    void* _buf2;
+
+    volatile bool _tuneRequested;
+    volatile bool _tuning;
+    uint32_t _tuneMs;
+    uint32_t _lastTuneTime;
+
+    DrawBufCandidate _candidates[DRAW_BUF_MAX_CANDIDATES];
+    uint8_t _candidateCount;
+
+    bool allocate(const DrawBufConfig& config);
+    void release();
+    void tune();
+    uint32_t measure(lv_disp_t* disp);
+    static lv_obj_t* createReferenceScreen();
+    bool loadConfig(DrawBufConfig& config);
+    void saveConfig(const DrawBufConfig& config);
+
+    static size_t bufferBytes(const DrawBufConfig& config);
+    static void collect(PrometheusWriter& writer);
+};
+
+// Global instance
+extern DrawBufferTuner drawBufferTuner;
+
+#endif // DRAW_BUFFER_TUNER_H
@@ -0,0 +1,76 @@
+#include "FlowHistory.h"
+
+// Global instance
+FlowHistory flowHistory;
+
+FlowHistory::FlowHistory() {
+    _mutex = nullptr;
+    _count = 0;
+    _stride = 1;
+    _fill = 0;
+    _version = 0;
+}
+
+void FlowHistory::begin() {
+    _mutex = xSemaphoreCreateMutex();
+}
+
+void FlowHistory::reset() {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    _count = 0;
+    _stride = 1;
+    _fill = 0;
+    _version++;
+    xSemaphoreGive(_mutex);
+}
+
+// Halve the column count by merging neighbours
+void FlowHistory::compact() {
+    uint8_t half = _count / 2;
+    for (uint8_t i = 0; i < half; i++) {
+        const FlowColumn& a = _columns[2 * i];
+        const FlowColumn& b = _columns[2 * i + 1];
+        _columns[i].minTenths = a.minTenths < b.minTenths ? a.minTenths : b.minTenths;
+        _columns[i].maxTenths = a.maxTenths > b.maxTenths ? a.maxTenths : b.maxTenths;
+    }
+    _count = half;
+    _stride *= 2;
+}
+
+void FlowHistory::addSample(float mlPerSecond) {
+    int32_t tenths = lroundf(mlPerSecond * 10);
+    if (tenths < 0) tenths = 0;
+    if (tenths > INT16_MAX) tenths = INT16_MAX;
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+
+    if (_count > 0 && _fill < _stride) {
+        // Widen the open column
+        FlowColumn& col = _columns[_count - 1];
+        if (tenths < col.minTenths) col.minTenths = tenths;
+        if (tenths > col.maxTenths) col.maxTenths = tenths;
+        _fill++;
+    } else {
+        if (_count == FLOW_HISTORY_COLUMNS) {
+            compact();
+        }
+        _columns[_count].minTenths = tenths;
+        _columns[_count].maxTenths = tenths;
+        _count++;
+        _fill = 1;
+    }
+    _version++;
+
+    xSemaphoreGive(_mutex);
+}
+
+uint8_t FlowHistory::copy(FlowColumn* columns, uint16_t* samplesPerColumn) {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    uint8_t count = _count;
+    memcpy(columns, _columns, count * sizeof(FlowColumn));
+    if (samplesPerColumn != nullptr) {
+        *samplesPerColumn = _stride;
+    }
+    xSemaphoreGive(_mutex);
+    return count;
+}
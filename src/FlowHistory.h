@@ -0,0 +1,50 @@
+#ifndef FLOW_HISTORY_H
+#define FLOW_HISTORY_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "config.h"
+
+// One chart column: the lowest and highest flow rate sampled in it
+struct FlowColumn {
+    int16_t minTenths;      // ml/s x 10
+    int16_t maxTenths;
+};
+
+// Flow rate over the current dispense, for the dispensing screen chart.
+// Holds at most FLOW_HISTORY_COLUMNS min/max columns. When full, neighbouring
+// columns are merged pairwise and each column covers twice as many samples,
+// so memory and chart cost stay the same however long the fill runs.
+// Written by the control loop, read by the LVGL task.
+class FlowHistory {
+public:
+    FlowHistory();
+    void begin();
+
+    // Drop all samples (start of a dispense)
+    void reset();
+
+    void addSample(float mlPerSecond);
+
+    // Bumped on every change; cheap to poll without the lock
+    uint32_t getVersion() const { return _version; }
+
+    // Copy all columns. Returns the column count.
+    uint8_t copy(FlowColumn* columns, uint16_t* samplesPerColumn = nullptr);
+
+private:
+    SemaphoreHandle_t _mutex;
+    FlowColumn _columns[FLOW_HISTORY_COLUMNS];
+    uint8_t _count;
+    uint16_t _stride;       // Samples per column
+    uint16_t _fill;         // Samples in the last column
+    volatile uint32_t _version;
+
+    void compact();
+};
+
+// Global instance
+extern FlowHistory flowHistory;
+
+#endif // FLOW_HISTORY_H
@@ -1,7 +1,18 @@
 #include "GT911.h"
 #include "config.h"
+#include "Trace.h"
+#include "HotPath.h"
+#include <esp_sleep.h>
+#include <driver/gpio.h>
 
-GT911::GT911(uint8_t sda, uint8_t scl, uint8_t int_pin, uint8_t rst_pin, int width, int height) {
+// Status register layout (GT911_POINT_INFO)
+#define GT911_STATUS_READY   0x80
+#define GT911_STATUS_COUNT   0x0F
+
+// Config register whose low two bits select the INT trigger (0 = rising edge)
+#define GT911_MODULE_SWITCH1 0x804D
+
+GT911::GT911(uint8_t sda, uint8_t scl, int8_t int_pin, int8_t rst_pin, int width, int height) {
     _sda = sda;
     _scl = scl;
     _int_pin = int_pin;
@@ -9,6 +20,12 @@ GT911::GT911(uint8_t sda, uint8_t scl, uint8_t int_pin, uint8_t rst_pin, int wid
     _rotation = 0;
     _width = width;
     _height = height;
+    _task = nullptr;
+    _pollInterval = TOUCH_POLL_INTERVAL;
+    _seq.store(0, std::memory_order_relaxed);
+    memset(&_frame, 0, sizeof(_frame));
+    memset(&_lastFrame, 0, sizeof(_lastFrame));
+    _frameCallback = nullptr;
 }
 
 bool GT911::begin() {
@@ -60,6 +77,7 @@ void GT911::reset() {
     delay(10);
 
     if (_int_pin >= 0) {
+        pinMode(_int_pin, OUTPUT);
         digitalWrite(_int_pin, LOW);
         delay(50);
         pinMode(_int_pin, INPUT);
@@ -88,38 +106,184 @@ void GT911::readReg(uint16_t reg, uint8_t* buf, uint8_t len) {
     }
 }
 
-TouchPoint GT911::readTouch() {
+static TouchPoint HOT_PATH_ATTR firstPoint(const TouchFrame& frame) {
     TouchPoint point = {0, 0, false};
+    if (frame.count > 0) {
+        point.x = frame.points[0].x;
+        point.y = frame.points[0].y;
+        point.touched = true;
+    }
+    return point;
+}
+
+TouchPoint GT911::readTouch() {
+    TouchFrame frame;
+    frame.count = 0;
+    readFrame(frame);
+    return firstPoint(frame);
+}
 
-    uint8_t point_info;
-    readReg(GT911_POINT_INFO, &point_info, 1);
+// Scale from the controller's resolution to the screen and apply rotation,
+// in integer math
+void GT911::mapPoint(uint16_t rawX, uint16_t rawY, uint16_t& x, uint16_t& y) {
+    uint32_t sx = (uint32_t)rawX * SCREEN_WIDTH / _width;
+    uint32_t sy = (uint32_t)rawY * SCREEN_HEIGHT / _height;
+    if (sx >= SCREEN_WIDTH) sx = SCREEN_WIDTH - 1;
+    if (sy >= SCREEN_HEIGHT) sy = SCREEN_HEIGHT - 1;
 
-    // Check if touch data is ready
-    if (!(point_info & 0x80)) {
-        return point;
+    switch (_rotation) {
+        case 1:
+            x = SCREEN_HEIGHT - 1 - sy;
+            y = sx;
+            break;
+        case 2:
+            x = SCREEN_WIDTH - 1 - sx;
+            y = SCREEN_HEIGHT - 1 - sy;
+            break;
+        case 3:
+            x = sy;
+            y = SCREEN_WIDTH - 1 - sx;
+            break;
+        default:
+            x = sx;
+            y = sy;
+            break;
     }
+}
 
-    // Get number of touch points
-    uint8_t touch_num = point_info & 0x0F;
+// Reads the status byte and all five point slots in one burst. Returns false
+// if the controller had no new frame (frame is left unchanged).
+bool GT911::readFrame(TouchFrame& frame) {
+    TRACE_SCOPE(TRACE_TOUCH_READ);
 
-    if (touch_num > 0) {
-        uint8_t data[8];  // GT911 sends 8 bytes per touch point
-        readReg(GT911_POINT_1, data, 8);
+    // Status byte followed by GT911_MAX_POINTS slots of: track_id(1) +
+    // x_low(1) + x_high(1) + y_low(1) + y_high(1) + size_low(1) + size_high(1) + reserved(1)
+    uint8_t data[1 + GT911_MAX_POINTS * 8];
+    readReg(GT911_POINT_INFO, data, sizeof(data));
 
-        // GT911 format: track_id(1) + x_low(1) + x_high(1) + y_low(1) + y_high(1) + size_low(1) + size_high(1) + reserved(1)
-        uint16_t x = data[1] | (data[2] << 8);
-        uint16_t y = data[3] | (data[4] << 8);
+    // Check if touch data is ready
+    if (!(data[0] & GT911_STATUS_READY)) {
+        return false;
+    }
 
-        point.x = (float)(((float)x / (float) _width) * 800.0);
-        point.y = (float)(((float)y / (float) _height) * 480.0);
+    // Get number of touch points
+    uint8_t touch_num = data[0] & GT911_STATUS_COUNT;
+    if (touch_num > GT911_MAX_POINTS) {
+        touch_num = GT911_MAX_POINTS;
+    }
 
-        point.touched = true;
+    frame.count = touch_num;
+    for (uint8_t i = 0; i < touch_num; i++) {
+        const uint8_t* p = &data[1 + i * 8];
+        TouchContact& c = frame.points[i];
+        c.id = p[0];
+        mapPoint(p[1] | (p[2] << 8), p[3] | (p[4] << 8), c.x, c.y);
+        c.size = p[5] | (p[6] << 8);
     }
 
     // Clear touch flag
     writeReg(GT911_POINT_INFO, 0);
 
-    return point;
+    return true;
+}
+
+// ============================================================
+// BACKGROUND READER
+// ============================================================
+
+void GT911::startReader() {
+    if (_task != nullptr) return;
+
+    xTaskCreatePinnedToCore(readerTask, "touch", TOUCH_TASK_STACK, this, TOUCH_TASK_PRIORITY, &_task, TOUCH_TASK_CORE);
+
+    if (_int_pin >= 0) {
+        // Follow whatever edge the controller's config says it drives
+        uint8_t mode;
+        readReg(GT911_MODULE_SWITCH1, &mode, 1);
+        int edge = (mode & 0x03) == 0 ? RISING : FALLING;
+
+        pinMode(_int_pin, INPUT);
+        attachInterruptArg(digitalPinToInterrupt(_int_pin), intHandler, this, edge);
+
+        // Edge interrupts don't run in light sleep; wake on the active level
+        gpio_wakeup_enable((gpio_num_t)_int_pin, edge == RISING ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL);
+        esp_sleep_enable_gpio_wakeup();
+    }
+}
+
+void IRAM_ATTR GT911::intHandler(void* arg) {
+    GT911* self = (GT911*)arg;
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(self->_task, &woken);
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+void GT911::readerTask(void* arg) {
+    GT911* self = (GT911*)arg;
+    TouchFrame frame;
+    frame.count = 0;
+
+    for (;;) {
+        TickType_t wait;
+        if (self->_int_pin < 0) {
+            wait = pdMS_TO_TICKS(self->_pollInterval);
+        } else if (frame.count > 0) {
+            // The controller signals release, but don't trust a single edge
+            wait = pdMS_TO_TICKS(TOUCH_RELEASE_TIMEOUT);
+        } else {
+            wait = portMAX_DELAY;
+        }
+        uint32_t notified = ulTaskNotifyTake(pdTRUE, wait);
+
+        if (!self->readFrame(frame)) {
+            // Frames arrive continuously while touched; none since the last
+            // interrupt means the release edge was missed
+            if (self->_int_pin >= 0 && notified == 0 && frame.count > 0) {
+                frame.count = 0;
+            } else {
+                continue;
+            }
+        }
+
+        self->publish(frame);
+        if (self->_frameCallback != nullptr) {
+            self->_frameCallback(frame, millis());
+        }
+    }
+}
+
+// Single writer (the reader task), so a plain sequence counter is enough
+void GT911::publish(const TouchFrame& frame) {
+    uint32_t seq = _seq.load(std::memory_order_relaxed);
+    _seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    _frame = frame;
+    _seq.store(seq + 2, std::memory_order_release);
+}
+
+void HOT_PATH_ATTR GT911::getLatestFrame(TouchFrame& frame) {
+    // A few tries; if the writer keeps getting in the way, the previous
+    // consistent frame is only one report old
+    for (uint8_t attempt = 0; attempt < 4; attempt++) {
+        uint32_t before = _seq.load(std::memory_order_acquire);
+        if (before & 1) continue;
+
+        TouchFrame copy = _frame;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (_seq.load(std::memory_order_relaxed) == before) {
+            _lastFrame = copy;
+            break;
+        }
+    }
+    frame = _lastFrame;
+}
+
+TouchPoint HOT_PATH_ATTR GT911::getLatest() {
+    TouchFrame frame;
+    getLatestFrame(frame);
+    return firstPoint(frame);
 }
 
 void GT911::setRotation(uint8_t rotation) {
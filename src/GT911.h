@@ -3,6 +3,9 @@
 
 #include <Arduino.h>
 #include <Wire.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 
 #define GT911_ADDR1 0x5D
 #define GT911_ADDR2 0x14
@@ -10,28 +13,79 @@
 #define GT911_POINT_INFO  0x814E
 #define GT911_POINT_1     0x814F
 
+// The controller reports up to five points, 8 bytes each
+#define GT911_MAX_POINTS  5
+
 struct TouchPoint {
     uint16_t x;
     uint16_t y;
     bool touched;
 };
 
+struct TouchContact {
+    uint8_t id;         // Track id, stable while the finger stays down
+    uint16_t x;         // Screen coordinates after scaling and rotation
+    uint16_t y;
+    uint16_t size;
+};
+
+struct TouchFrame {
+    uint8_t count;
+    TouchContact points[GT911_MAX_POINTS];
+};
+
 class GT911 {
 public:
-    GT911(uint8_t sda, uint8_t scl, uint8_t int_pin, uint8_t rst_pin, int width, int height);
+    // Pass -1 for int_pin / rst_pin when not connected
+    GT911(uint8_t sda, uint8_t scl, int8_t int_pin, int8_t rst_pin, int width, int height);
     bool begin();
+
+    // Synchronous I2C read of the current touch state (first point)
     TouchPoint readTouch();
+
+    // 0 = panel orientation, 1..3 = rotated by 90/180/270 degrees clockwise
     void setRotation(uint8_t rotation);
 
+    // Move I2C reads to a background task: woken by the INT pin when it is
+    // connected, otherwise polling every TOUCH_POLL_INTERVAL ms.
+    void startReader();
+    bool isReaderRunning() const { return _task != nullptr; }
+
+    // Polling period without INT (ms); slowed down while the display is off
+    void setPollInterval(uint16_t ms) { _pollInterval = ms; }
+
+    // Latest data published by the reader task. Never touches I2C.
+    TouchPoint getLatest();
+    void getLatestFrame(TouchFrame& frame);
+
+    // Called on the reader task for every new frame (gesture detection)
+    void onFrame(void (*callback)(const TouchFrame& frame, uint32_t ms)) { _frameCallback = callback; }
+
 private:
-    uint8_t _sda, _scl, _int_pin, _rst_pin;
+    uint8_t _sda, _scl;
+    int8_t _int_pin, _rst_pin;
     uint8_t _addr;
     uint8_t _rotation;
     uint16_t _width, _height;
 
+    // Reader task state. _frame is published with a sequence lock: odd
+    // _seq means a write is in progress, readers retry or use _lastFrame.
+    TaskHandle_t _task;
+    volatile uint16_t _pollInterval;
+    std::atomic<uint32_t> _seq;
+    TouchFrame _frame;
+    TouchFrame _lastFrame;      // Reader side: last consistent copy
+    void (*_frameCallback)(const TouchFrame& frame, uint32_t ms);
+
     void writeReg(uint16_t reg, uint8_t value);
     void readReg(uint16_t reg, uint8_t* buf, uint8_t len);
     void reset();
+    bool readFrame(TouchFrame& frame);
+    void mapPoint(uint16_t rawX, uint16_t rawY, uint16_t& x, uint16_t& y);
+    void publish(const TouchFrame& frame);
+
+    static void IRAM_ATTR intHandler(void* arg);
+    static void readerTask(void* arg);
 };
 
 #endif // GT911_H
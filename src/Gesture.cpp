@@ -0,0 +1,145 @@
+#include "Gesture.h"
+#include "config.h"
+#include <math.h>
+
+// Global instance
+GestureDetector gestureDetector;
+
+GestureDetector::GestureDetector() {
+    _down = false;
+    _startMs = 0;
+    _startX = _startY = 0;
+    _lastX = _lastY = 0;
+    _maxPoints = 0;
+    _moved = false;
+    _longFired = false;
+    _pinchFired = false;
+    _startDist = 0;
+    _captured = false;
+    _capturePending = false;
+    _callback = nullptr;
+}
+
+bool GestureDetector::takeCapture() {
+    if (!_capturePending) return false;
+    _capturePending = false;
+    return true;
+}
+
+const char* GestureDetector::name(GestureType type) {
+    switch (type) {
+        case GESTURE_SWIPE_LEFT:     return "swipe_left";
+        case GESTURE_SWIPE_RIGHT:    return "swipe_right";
+        case GESTURE_SWIPE_UP:       return "swipe_up";
+        case GESTURE_SWIPE_DOWN:     return "swipe_down";
+        case GESTURE_LONG_PRESS:     return "long_press";
+        case GESTURE_TWO_FINGER_TAP: return "two_finger_tap";
+        case GESTURE_PINCH_IN:       return "pinch_in";
+        case GESTURE_PINCH_OUT:      return "pinch_out";
+        default:                     return "none";
+    }
+}
+
+uint16_t GestureDetector::distance(const TouchContact& a, const TouchContact& b) {
+    int32_t dx = (int32_t)a.x - b.x;
+    int32_t dy = (int32_t)a.y - b.y;
+    return (uint16_t)sqrtf((float)(dx * dx + dy * dy));
+}
+
+void GestureDetector::fire(GestureType type) {
+    if (_callback == nullptr) return;
+    Gesture gesture = { type, _startX, _startY };
+    _callback(gesture);
+}
+
+void GestureDetector::update(const TouchFrame& frame, uint32_t nowMs) {
+    if (frame.count == 0) {
+        if (_down) release(nowMs);
+        return;
+    }
+
+    const TouchContact& first = frame.points[0];
+
+    if (!_down) {
+        _down = true;
+        _startMs = nowMs;
+        _startX = _lastX = first.x;
+        _startY = _lastY = first.y;
+        _maxPoints = 0;
+        _moved = false;
+        _longFired = false;
+        _pinchFired = false;
+        _startDist = 0;
+        _captured = false;
+        _capturePending = false;
+    }
+
+    if (frame.count > _maxPoints) {
+        _maxPoints = frame.count;
+        if (frame.count == 2) {
+            _startDist = distance(frame.points[0], frame.points[1]);
+        }
+    }
+
+    _lastX = first.x;
+    _lastY = first.y;
+    if (abs((int32_t)_lastX - _startX) > GESTURE_SLOP_PX ||
+        abs((int32_t)_lastY - _startY) > GESTURE_SLOP_PX) {
+        _moved = true;
+    }
+
+    // Same horizontal test release() applies to a swipe
+    int32_t adx = abs((int32_t)_lastX - _startX);
+    int32_t ady = abs((int32_t)_lastY - _startY);
+    if (!_captured && (_maxPoints >= 2 ||
+        (!_longFired && adx >= GESTURE_SWIPE_MIN_PX && adx >= 2 * ady))) {
+        _captured = true;
+        _capturePending = true;
+    }
+
+    // Long press: one finger held still
+    if (_maxPoints == 1 && !_moved && !_longFired &&
+        nowMs - _startMs >= GESTURE_LONG_PRESS_MS) {
+        _longFired = true;
+        fire(GESTURE_LONG_PRESS);
+    }
+
+    // Pinch: fires once per touch when the finger distance changes enough
+    if (frame.count == 2 && _maxPoints == 2 && !_pinchFired) {
+        int32_t change = (int32_t)distance(frame.points[0], frame.points[1]) - _startDist;
+        if (change >= GESTURE_PINCH_MIN_PX) {
+            _pinchFired = true;
+            fire(GESTURE_PINCH_OUT);
+        } else if (change <= -GESTURE_PINCH_MIN_PX) {
+            _pinchFired = true;
+            fire(GESTURE_PINCH_IN);
+        }
+    }
+}
+
+void GestureDetector::release(uint32_t nowMs) {
+    _down = false;
+    uint32_t duration = nowMs - _startMs;
+
+    if (_maxPoints == 2) {
+        if (!_pinchFired && duration <= GESTURE_TAP_MAX_MS) {
+            fire(GESTURE_TWO_FINGER_TAP);
+        }
+        return;
+    }
+    if (_maxPoints != 1 || _longFired || duration > GESTURE_SWIPE_MAX_MS) {
+        return;
+    }
+
+    // Swipe: long enough, fast enough, and clearly along one axis
+    int32_t dx = (int32_t)_lastX - _startX;
+    int32_t dy = (int32_t)_lastY - _startY;
+    int32_t adx = abs(dx);
+    int32_t ady = abs(dy);
+
+    if (adx >= GESTURE_SWIPE_MIN_PX && adx >= 2 * ady) {
+        fire(dx < 0 ? GESTURE_SWIPE_LEFT : GESTURE_SWIPE_RIGHT);
+    } else if (ady >= GESTURE_SWIPE_MIN_PX && ady >= 2 * adx) {
+        fire(dy < 0 ? GESTURE_SWIPE_UP : GESTURE_SWIPE_DOWN);
+    }
+}
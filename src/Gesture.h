@@ -0,0 +1,67 @@
+#ifndef GESTURE_H
+#define GESTURE_H
+
+#include <Arduino.h>
+#include "GT911.h"
+
+enum GestureType : uint8_t {
+    GESTURE_NONE,
+    GESTURE_SWIPE_LEFT,
+    GESTURE_SWIPE_RIGHT,
+    GESTURE_SWIPE_UP,
+    GESTURE_SWIPE_DOWN,
+    GESTURE_LONG_PRESS,
+    GESTURE_TWO_FINGER_TAP,
+    GESTURE_PINCH_IN,
+    GESTURE_PINCH_OUT
+};
+
+struct Gesture {
+    GestureType type;
+    uint16_t x;         // Where the gesture started
+    uint16_t y;
+};
+
+// Turns the GT911 frame stream into swipes, long presses and two-finger
+// input. Fed from the touch reader task; gestures are delivered through the
+// callback on that task, so the callback must only hand them off.
+class GestureDetector {
+public:
+    GestureDetector();
+
+    void update(const TouchFrame& frame, uint32_t nowMs);
+
+    void onGesture(void (*callback)(const Gesture& gesture)) { _callback = callback; }
+
+    // True once per touch when it has become a horizontal swipe or a
+    // two-finger gesture, i.e. can no longer be a tap on a button. The touch
+    // read callback then cancels LVGL's press so the gesture does not also
+    // click what it started on. Vertical travel is left to LVGL for scrolling.
+    bool takeCapture();
+
+    static const char* name(GestureType type);
+
+private:
+    bool _down;
+    uint32_t _startMs;
+    uint16_t _startX, _startY;
+    uint16_t _lastX, _lastY;
+    uint8_t _maxPoints;         // Most fingers seen during this touch
+    bool _moved;                // Left the slop radius
+    bool _longFired;
+    bool _pinchFired;
+    uint16_t _startDist;        // Two-finger distance when the second finger landed
+    bool _captured;             // Capture already raised for this touch
+    volatile bool _capturePending;  // Raised on the touch task, taken on the LVGL task
+
+    void (*_callback)(const Gesture& gesture);
+
+    void fire(GestureType type);
+    void release(uint32_t nowMs);
+    static uint16_t distance(const TouchContact& a, const TouchContact& b);
+};
+
+// Global instance
+extern GestureDetector gestureDetector;
+
+#endif // GESTURE_H
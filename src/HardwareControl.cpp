@@ -1,5 +1,10 @@
 #include "HardwareControl.h"
 #include "config.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include "Log.h"
+#include "FlowHistory.h"
+#include "HotPath.h"
 #include <Preferences.h>
 
 // Global instance
@@ -7,10 +12,13 @@ HardwareControl hardwareControl;
 
 // ISR wrapper function
 void IRAM_ATTR flowPulseISR() {
+    tracer.spanBegin(TRACE_FLOW_ISR);
     hardwareControl.handleFlowPulse();
+    tracer.spanEnd(TRACE_FLOW_ISR);
 }
 
 HardwareControl::HardwareControl() {
+    _mutex = nullptr;
     _pulseCount = 0;
     _pulsesPerLiter = DEFAULT_PULSES_PER_LITER;
     _targetML = 0;
@@ -26,6 +34,8 @@ HardwareControl::HardwareControl() {
 }
 
 void HardwareControl::begin() {
+    _mutex = xSemaphoreCreateMutex();
+
     // Setup valve pin
     pinMode(VALVE_PIN, OUTPUT);
     closeValve();
@@ -34,25 +44,34 @@ void HardwareControl::begin() {
     pinMode(FLOW_SENSOR_PIN, INPUT_PULLUP);
     attachInterrupt(digitalPinToInterrupt(FLOW_SENSOR_PIN), flowPulseISR, RISING);
 
+    flowHistory.begin();
+
     // Load calibration from preferences
     Preferences prefs;
     if (prefs.begin(PREFS_NAMESPACE, true)) {
         _pulsesPerLiter = prefs.getFloat("pulses_per_l", DEFAULT_PULSES_PER_LITER);
         prefs.end();
-        Serial.printf("Loaded calibration: %.2f pulses/L\n", _pulsesPerLiter);
+        LOG_INFO("Loaded calibration: %.2f pulses/L", _pulsesPerLiter);
     }
 }
 
 void HardwareControl::openValve() {
-    digitalWrite(VALVE_PIN, HIGH);
-    _valveOpen = true;
-    Serial.println("Valve OPEN");
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    setValve(true);
+    xSemaphoreGive(_mutex);
 }
 
 void HardwareControl::closeValve() {
-    digitalWrite(VALVE_PIN, LOW);
-    _valveOpen = false;
-    Serial.println("Valve CLOSED");
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    setValve(false);
+    xSemaphoreGive(_mutex);
+}
+
+// Called with _mutex held
+void HardwareControl::setValve(bool open) {
+    digitalWrite(VALVE_PIN, open ? HIGH : LOW);
+    _valveOpen = open;
+    LOG_INFO(open ? "Valve OPEN" : "Valve CLOSED");
 }
 
 bool HardwareControl::isValveOpen() {
@@ -66,7 +85,7 @@ void HardwareControl::resetFlowCounter() {
     interrupts();
 }
 
-float HardwareControl::getDispensedAmount() {
+float HOT_PATH_ATTR HardwareControl::getDispensedAmount() {
     noInterrupts();
     uint32_t pulses = _pulseCount;
     interrupts();
@@ -75,7 +94,7 @@ float HardwareControl::getDispensedAmount() {
     return (pulses / _pulsesPerLiter) * 1000.0;
 }
 
-float HardwareControl::getFlowRate() {
+float HOT_PATH_ATTR HardwareControl::getFlowRate() {
     unsigned long now = millis();
     unsigned long timeDiff = now - _lastFlowCheckTime;
 
@@ -97,9 +116,9 @@ float HardwareControl::getFlowRate() {
 }
 
 void HardwareControl::startDispensing(float targetML) {
-    Serial.printf("Starting to dispense %.2f ml\n", targetML);
-
+    LOG_INFO("Starting to dispense %.2f ml", targetML);
 
+    xSemaphoreTake(_mutex, portMAX_DELAY);
     _targetML = targetML;
     _dispensedML = 0;
     _state = DISPENSING;
@@ -110,22 +129,29 @@ void HardwareControl::startDispensing(float targetML) {
     
     _lastPulseTime = millis();
     resetFlowCounter();
-    openValve();
+    flowHistory.reset();
+    setValve(true);
+    xSemaphoreGive(_mutex);
 }
 
 void HardwareControl::pauseDispensing() {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
     if (_state != DISPENSING) {
+        xSemaphoreGive(_mutex);
         return;
     }
 
-    closeValve();
+    setValve(false);
     _state = PAUSED;
     _pauseStartTime = millis();
-    Serial.printf("Dispensing paused at %.2f ml\n", getDispensedAmount());
+    xSemaphoreGive(_mutex);
+    LOG_INFO("Dispensing paused at %.2f ml", getDispensedAmount());
 }
 
 void HardwareControl::resumeDispensing() {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
     if (_state != PAUSED) {
+        xSemaphoreGive(_mutex);
         return;
     }
 
@@ -135,18 +161,26 @@ void HardwareControl::resumeDispensing() {
 
     _state = DISPENSING;
     _lastFlowCheckTime = millis();
-    openValve();
-    Serial.printf("Dispensing resumed from %.2f ml\n", getDispensedAmount());
+    setValve(true);
+    xSemaphoreGive(_mutex);
+    LOG_INFO("Dispensing resumed from %.2f ml", getDispensedAmount());
 }
 
 void HardwareControl::stopDispensing() {
-    closeValve();
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    stop();
+    xSemaphoreGive(_mutex);
+}
+
+// Called with _mutex held
+void HardwareControl::stop() {
+    setValve(false);
 
     if (_state == DISPENSING || _state == PAUSED) {
         _state = STOPPING;
     }
 
-    Serial.printf("Dispensing stopped. Dispensed: %.2f ml\n", getDispensedAmount());
+    LOG_INFO("Dispensing stopped. Dispensed: %.2f ml", getDispensedAmount());
 }
 
 DispensingState HardwareControl::getState() {
@@ -177,7 +211,8 @@ void HardwareControl::setCalibrationFactor(float pulsesPerLiter) {
     if (prefs.begin(PREFS_NAMESPACE, false)) {
         prefs.putFloat("pulses_per_l", pulsesPerLiter);
         prefs.end();
-        Serial.printf("Saved calibration: %.2f pulses/L\n", pulsesPerLiter);
+        metrics.nvsWrites.inc();
+        LOG_INFO("Saved calibration: %.2f pulses/L", pulsesPerLiter);
     }
 }
 
@@ -185,42 +220,70 @@ float HardwareControl::getCalibrationFactor() {
     return _pulsesPerLiter;
 }
 
-void HardwareControl::update() {
+void HOT_PATH_ATTR HardwareControl::update() {
     // Only update when actively dispensing (not when paused)
     if (_state != DISPENSING) {
         return;
     }
 
+    // A UI or web command may have changed the state since the check above
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    if (_state != DISPENSING) {
+        xSemaphoreGive(_mutex);
+        return;
+    }
+
     unsigned long now = millis();
     _dispensedML = getDispensedAmount();
+    DispenseCheck check = checkDispensing(now, _dispensedML);
 
-    // Check if target reached (with overshoot compensation)
-    if (_dispensedML >= (_targetML - OVERSHOOT_COMPENSATION)) {
-        stopDispensing();
+    if (check == DISPENSE_CHECK_TARGET_REACHED) {
+        stop();
         _state = COMPLETED;
-        Serial.println("Target reached!");
+        xSemaphoreGive(_mutex);
+        LOG_INFO("Target reached!");
         return;
     }
 
+    // Flow rate for the dispensing screen chart
+    if (now - _lastFlowCheckTime >= FLOW_RATE_SAMPLE_INTERVAL) {
+        flowHistory.addSample(getFlowRate());
+    }
+
+    if (check == DISPENSE_CHECK_FLOW_TIMEOUT) {
+        stop();
+        _state = ERROR_TIMEOUT;
+        LOG_ERROR("Flow timeout!");
+    } else if (check == DISPENSE_CHECK_NO_FLOW) {
+        stop();
+        _state = ERROR_NO_FLOW;
+        LOG_ERROR("No flow detected!");
+    }
+    xSemaphoreGive(_mutex);
+}
+
+DispenseCheck HOT_PATH_ATTR HardwareControl::checkDispensing(unsigned long now, float dispensedML) {
+    // Check if target reached (with overshoot compensation)
+    if (dispensedML >= (_targetML - OVERSHOOT_COMPENSATION)) {
+        return DISPENSE_CHECK_TARGET_REACHED;
+    }
+
     // Check for flow timeout (accounting for paused time)
     if (now - _lastPulseTime > FLOW_TIMEOUT) {
-        stopDispensing();
-        _state = ERROR_TIMEOUT;
-        Serial.println("Error: Flow timeout!");
-        return;
+        return DISPENSE_CHECK_FLOW_TIMEOUT;
     }
 
     // Check if flow has started (accounting for total paused time)
     unsigned long activeTime = (now - _dispensingStartTime) - _totalPausedTime;
     if (activeTime > 2000 && _pulseCount < 5) {
-        stopDispensing();
-        _state = ERROR_NO_FLOW;
-        Serial.println("Error: No flow detected!");
-        return;
+        return DISPENSE_CHECK_NO_FLOW;
     }
+
+    return DISPENSE_CHECK_OK;
 }
 
 void IRAM_ATTR HardwareControl::handleFlowPulse() {
     _pulseCount++;
+    metrics.flowPulses.inc();
     _lastPulseTime = millis();
 }
@@ -2,6 +2,8 @@
 #define HARDWARE_CONTROL_H
 
 #include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 
 enum DispensingState {
     IDLE,
@@ -13,6 +15,17 @@ enum DispensingState {
     ERROR_NO_FLOW
 };
 
+// Outcome of the per-loop dispensing checks, in the order they are made
+enum DispenseCheck {
+    DISPENSE_CHECK_OK,
+    DISPENSE_CHECK_TARGET_REACHED,
+    DISPENSE_CHECK_FLOW_TIMEOUT,
+    DISPENSE_CHECK_NO_FLOW
+};
+
+// Commands come from loop() (update), the LVGL task (UI buttons) and the
+// AsyncTCP task (web API). Valve and dispensing commands and update() are
+// serialized by a mutex; the getters read single fields without it.
 class HardwareControl {
 public:
     HardwareControl();
@@ -45,10 +58,14 @@ public:
     // Update loop - call this regularly
     void update();
 
+    // Target, timeout and no-flow checks for the given amount; no side effects
+    DispenseCheck checkDispensing(unsigned long now, float dispensedML);
+
     // Interrupt handler (must be public for ISR attachment)
     void IRAM_ATTR handleFlowPulse();
 
 private:
+    SemaphoreHandle_t _mutex;
     volatile uint32_t _pulseCount;
     float _pulsesPerLiter;
     float _targetML;
@@ -62,6 +79,10 @@ private:
     unsigned long _pauseStartTime;
     unsigned long _totalPausedTime;
     uint32_t _lastPulseCount;
+
+    // Called with _mutex held
+    void setValve(bool open);
+    void stop();
 };
 
 // Global instance for ISR access
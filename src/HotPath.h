@@ -0,0 +1,21 @@
+#ifndef HOT_PATH_H
+#define HOT_PATH_H
+
+// Code on the per-frame and per-loop paths (flush, touch read, dispensing
+// checks, LVGL blend/fill) that should not wait on flash cache misses.
+// HOT_PATH_IRAM is set in platformio.ini; build with 0 to compare, see
+// GET /api/hotpath and the IRAM report printed after linking.
+// Plain C so lv_conf.h can use it for LVGL's own hot functions.
+
+#ifndef HOT_PATH_IRAM
+#define HOT_PATH_IRAM 0
+#endif
+
+#if HOT_PATH_IRAM && defined(ESP_PLATFORM)
+#include <esp_attr.h>
+#define HOT_PATH_ATTR IRAM_ATTR
+#else
+#define HOT_PATH_ATTR
+#endif
+
+#endif // HOT_PATH_H
@@ -0,0 +1,252 @@
+#include "HotPathBench.h"
+#include "HotPath.h"
+#include "config.h"
+#include "IdleManager.h"
+#include "Log.h"
+#include <lvgl.h>
+#include <esp_heap_caps.h>
+#include <esp_idf_version.h>
+#include <ArduinoJson.h>
+#if ESP_IDF_VERSION_MAJOR >= 5
+#include <esp_memory_utils.h>
+#else
+#include <soc/soc_memory_types.h>
+#endif
+
+// Global instance
+HotPathBench hotPathBench;
+
+// Scratch area for the LVGL blend targets, allocated for the duration of a run
+static lv_color_t* blendDest = nullptr;
+static lv_color_t* blendSrc = nullptr;
+static lv_area_t blendArea;
+static lv_draw_ctx_t blendCtx;
+
+// Calls fn once and returns the cycles it took. In IRAM itself so the
+// measurement around the call never waits on flash.
+static uint32_t IRAM_ATTR timeCall(HotPathFn fn) {
+    uint32_t start = ESP.getCycleCount();
+    fn();
+    return ESP.getCycleCount() - start;
+}
+
+// Latency distribution of the samples added since 'start' was taken
+static HotPathLatency windowLatency(const MetricHistogram& h, const uint32_t* start) {
+    HotPathLatency result = {};
+    uint32_t delta[METRIC_MAX_BUCKETS + 1];
+    for (uint8_t i = 0; i <= h.bucketCount(); i++) {
+        delta[i] = h.bucket(i) - start[i];
+        result.count += delta[i];
+    }
+    if (result.count == 0) return result;
+
+    const uint8_t pcts[] = { 50, 99 };
+    uint32_t* outputs[] = { &result.p50Us, &result.p99Us };
+    for (uint8_t p = 0; p < 2; p++) {
+        uint32_t rank = (uint32_t)(((uint64_t)result.count * pcts[p] + 99) / 100);
+        uint32_t seen = 0;
+        *outputs[p] = h.max();      // +Inf bucket: best known is the all-time max
+        for (uint8_t i = 0; i < h.bucketCount(); i++) {
+            seen += delta[i];
+            if (seen >= rank) {
+                *outputs[p] = h.bound(i);
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+static void snapshotBuckets(const MetricHistogram& h, uint32_t* out) {
+    for (uint8_t i = 0; i <= h.bucketCount(); i++) {
+        out[i] = h.bucket(i);
+    }
+}
+
+HotPathBench::HotPathBench() {
+    _phase = HOT_PATH_IDLE;
+    _requestedSeconds = 0;
+    _seconds = 0;
+    _phaseStart = 0;
+    memset(_targets, 0, sizeof(_targets));
+    _targetCount = 0;
+    memset(_flushStart, 0, sizeof(_flushStart));
+    memset(_renderStart, 0, sizeof(_renderStart));
+    memset(_updateStart, 0, sizeof(_updateStart));
+    memset(&_flush, 0, sizeof(_flush));
+    memset(&_render, 0, sizeof(_render));
+    memset(&_update, 0, sizeof(_update));
+}
+
+void HotPathBench::begin() {
+    addTarget("lv_blend_fill", blendFill, (const void*)lv_draw_sw_blend_basic);
+    addTarget("lv_blend_map", blendMap, (const void*)lv_draw_sw_blend_basic);
+}
+
+bool HotPathBench::addTarget(const char* name, HotPathFn fn, const void* code) {
+    if (_targetCount >= HOT_PATH_MAX_TARGETS) return false;
+
+    HotPathTarget& t = _targets[_targetCount++];
+    t.name = name;
+    t.fn = fn;
+    t.code = code != nullptr ? code : (const void*)fn;
+    t.inIram = esp_ptr_in_iram(t.code);
+    return true;
+}
+
+bool HotPathBench::start(uint16_t seconds) {
+    if (isRunning() || _requestedSeconds != 0 || seconds == 0) {
+        return false;
+    }
+    _requestedSeconds = seconds;
+    return true;
+}
+
+void HotPathBench::update() {
+    if (_requestedSeconds != 0 && !isRunning()) {
+        _seconds = _requestedSeconds;
+        _requestedSeconds = 0;
+
+        runTargets();
+
+        // Then the real flush and update paths, under full-screen redraws
+        snapshotBuckets(metrics.lvglFlushTime, _flushStart);
+        snapshotBuckets(metrics.lvglRenderTime, _renderStart);
+        snapshotBuckets(metrics.hardwareUpdateTime, _updateStart);
+        _phase = HOT_PATH_WINDOW;
+        _phaseStart = millis();
+        return;
+    }
+
+    if (!isRunning()) return;
+
+    lv_obj_invalidate(lv_scr_act());
+
+    if (millis() - _phaseStart >= (unsigned long)_seconds * 1000) {
+        finishWindow();
+    }
+}
+
+void HotPathBench::runTargets() {
+    size_t bytes = (size_t)SCREEN_WIDTH * HOT_PATH_BENCH_LINES * sizeof(lv_color_t);
+    blendDest = (lv_color_t*)heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    blendSrc = (lv_color_t*)heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+
+    // Full CPU clock so the cycle counts compare across runs
+    idleManager.lock(PM_LOCK_RENDER);
+
+    if (blendDest != nullptr && blendSrc != nullptr) {
+        lv_area_set(&blendArea, 0, 0, SCREEN_WIDTH - 1, HOT_PATH_BENCH_LINES - 1);
+        lv_memset_00(&blendCtx, sizeof(blendCtx));
+        blendCtx.buf = blendDest;
+        blendCtx.buf_area = &blendArea;
+        blendCtx.clip_area = &blendArea;
+        lv_memset_00(blendSrc, bytes);
+    }
+
+    // The blend reads the driver of the display being refreshed
+    lv_disp_t* refreshing = _lv_refr_get_disp_refreshing();
+    _lv_refr_set_disp_refreshing(lv_disp_get_default());
+
+    for (uint8_t i = 0; i < _targetCount; i++) {
+        HotPathTarget& t = _targets[i];
+        bool isBlend = t.fn == blendFill || t.fn == blendMap;
+        if (isBlend && (blendDest == nullptr || blendSrc == nullptr)) {
+            t.avgCycles = t.maxCycles = 0;
+            continue;
+        }
+
+        uint64_t total = 0;
+        uint32_t maxCycles = 0;
+
+        // One call first so the timed runs start from a warm cache
+        timeCall(t.fn);
+        for (uint16_t n = 0; n < HOT_PATH_BENCH_ITERATIONS; n++) {
+            uint32_t cycles = timeCall(t.fn);
+            total += cycles;
+            if (cycles > maxCycles) maxCycles = cycles;
+        }
+        t.avgCycles = total / HOT_PATH_BENCH_ITERATIONS;
+        t.maxCycles = maxCycles;
+    }
+
+    _lv_refr_set_disp_refreshing(refreshing);
+    idleManager.unlock(PM_LOCK_RENDER);
+
+    heap_caps_free(blendDest);
+    heap_caps_free(blendSrc);
+    blendDest = nullptr;
+    blendSrc = nullptr;
+
+    for (uint8_t i = 0; i < _targetCount; i++) {
+        const HotPathTarget& t = _targets[i];
+        LOG_INFO("Hot path %s (%s): %u cycles avg, %u max", t.name,
+                 t.inIram ? "IRAM" : "flash", t.avgCycles, t.maxCycles);
+    }
+}
+
+void HotPathBench::finishWindow() {
+    _flush = windowLatency(metrics.lvglFlushTime, _flushStart);
+    _render = windowLatency(metrics.lvglRenderTime, _renderStart);
+    _update = windowLatency(metrics.hardwareUpdateTime, _updateStart);
+    _phase = HOT_PATH_DONE;
+
+    LOG_INFO("Hot path window: flush p50 %u us p99 %u us (%u), render p50 %u us p99 %u us (%u)",
+             _flush.p50Us, _flush.p99Us, _flush.count, _render.p50Us, _render.p99Us, _render.count);
+}
+
+void HOT_PATH_ATTR HotPathBench::blendFill() {
+    lv_draw_sw_blend_dsc_t dsc;
+    lv_memset_00(&dsc, sizeof(dsc));
+    dsc.blend_area = &blendArea;
+    dsc.color = lv_color_hex(0x2196F3);
+    dsc.opa = LV_OPA_COVER;
+    dsc.mask_res = LV_DRAW_MASK_RES_FULL_COVER;
+    dsc.blend_mode = LV_BLEND_MODE_NORMAL;
+    lv_draw_sw_blend_basic(&blendCtx, &dsc);
+}
+
+void HOT_PATH_ATTR HotPathBench::blendMap() {
+    lv_draw_sw_blend_dsc_t dsc;
+    lv_memset_00(&dsc, sizeof(dsc));
+    dsc.blend_area = &blendArea;
+    dsc.src_buf = blendSrc;
+    dsc.opa = LV_OPA_COVER;
+    dsc.mask_res = LV_DRAW_MASK_RES_FULL_COVER;
+    dsc.blend_mode = LV_BLEND_MODE_NORMAL;
+    lv_draw_sw_blend_basic(&blendCtx, &dsc);
+}
+
+String HotPathBench::getStatusJSON() {
+    DynamicJsonDocument doc(768 + _targetCount * 192);
+    static const char* const phaseNames[] = { "idle", "window", "done" };
+
+    doc["phase"] = phaseNames[_phase];
+    doc["hotPathIram"] = HOT_PATH_IRAM != 0;
+    doc["cpuMhz"] = getCpuFrequencyMhz();
+    doc["iterations"] = HOT_PATH_BENCH_ITERATIONS;
+    doc["seconds"] = _seconds;
+
+    JsonArray list = doc.createNestedArray("targets");
+    for (uint8_t i = 0; i < _targetCount; i++) {
+        const HotPathTarget& t = _targets[i];
+        JsonObject entry = list.createNestedObject();
+        entry["name"] = t.name;
+        entry["inIram"] = t.inIram;
+        entry["avgCycles"] = t.avgCycles;
+        entry["maxCycles"] = t.maxCycles;
+    }
+
+    const HotPathLatency* windows[] = { &_flush, &_render, &_update };
+    const char* keys[] = { "flush", "render", "hardwareUpdate" };
+    for (uint8_t i = 0; i < 3; i++) {
+        JsonObject w = doc.createNestedObject(keys[i]);
+        w["count"] = windows[i]->count;
+        w["p50Us"] = windows[i]->p50Us;
+        w["p99Us"] = windows[i]->p99Us;
+    }
+
+    String output;
+    serializeJson(doc, output);
+    return output;
+}
@@ -0,0 +1,87 @@
+#ifndef HOT_PATH_BENCH_H
+#define HOT_PATH_BENCH_H
+
+#include <Arduino.h>
+#include "Metrics.h"
+
+// Maximum number of registered microbenchmark targets
+#define HOT_PATH_MAX_TARGETS 8
+
+typedef void (*HotPathFn)();
+
+struct HotPathTarget {
+    const char* name;
+    HotPathFn fn;
+    const void* code;           // Function whose placement is reported
+    bool inIram;
+    uint32_t avgCycles;
+    uint32_t maxCycles;
+};
+
+// Live latencies over the run window, from the Metrics histograms
+struct HotPathLatency {
+    uint32_t count;
+    uint32_t p50Us;
+    uint32_t p99Us;
+};
+
+enum HotPathBenchPhase {
+    HOT_PATH_IDLE,
+    HOT_PATH_WINDOW,            // Full-screen redraws, flush/update histograms sampled
+    HOT_PATH_DONE
+};
+
+// Times each hot path function (HotPath.h) in CPU cycles, then records
+// flush, render and hardware update latencies over a window of full-screen
+// redraws. Run once per build with HOT_PATH_IRAM=1 and =0 to compare.
+// Driven from the LVGL task via update().
+class HotPathBench {
+public:
+    HotPathBench();
+
+    // Registers the LVGL blend/fill targets
+    void begin();
+
+    // Add a target; code is the function it exercises, for the IRAM check
+    // (nullptr: fn itself)
+    bool addTarget(const char* name, HotPathFn fn, const void* code);
+
+    // Request a run; the window lasts 'seconds'. Safe to call from any task.
+    bool start(uint16_t seconds);
+
+    // Runs the microbenchmarks and advances the window. Call from the LVGL thread.
+    void update();
+
+    bool isRunning() const { return _phase == HOT_PATH_WINDOW; }
+
+    String getStatusJSON();
+
+private:
+    volatile HotPathBenchPhase _phase;
+    volatile uint16_t _requestedSeconds;
+    uint16_t _seconds;
+    unsigned long _phaseStart;
+
+    HotPathTarget _targets[HOT_PATH_MAX_TARGETS];
+    uint8_t _targetCount;
+
+    // Histogram buckets at the start of the window
+    uint32_t _flushStart[METRIC_MAX_BUCKETS + 1];
+    uint32_t _renderStart[METRIC_MAX_BUCKETS + 1];
+    uint32_t _updateStart[METRIC_MAX_BUCKETS + 1];
+
+    HotPathLatency _flush;
+    HotPathLatency _render;
+    HotPathLatency _update;
+
+    void runTargets();
+    void finishWindow();
+
+    static void blendFill();
+    static void blendMap();
+};
+
+// Global instance
+extern HotPathBench hotPathBench;
+
+#endif // HOT_PATH_BENCH_H
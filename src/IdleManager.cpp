@@ -0,0 +1,325 @@
+#include "IdleManager.h"
+#include "HardwareControl.h"
+#include "OTAManager.h"
+#include "LvglTask.h"
+#include "display_driver.h"
+#include "Log.h"
+#include <esp_idf_version.h>
+#include <ArduinoJson.h>
+
+// Global instance
+IdleManager idleManager;
+
+static const char* idleStateNames[IDLE_STATE_COUNT] = { "active", "dimmed", "off" };
+static const char* wakeSourceNames[IDLE_WAKE_SOURCE_COUNT] = { "touch", "dispense" };
+static const char* powerLockNames[PM_LOCK_COUNT] = { "dispense", "render", "http", "ota" };
+
+IdleManager::IdleManager() {
+    _mutex = nullptr;
+    _state = IDLE_ACTIVE;
+    _lastActivity = 0;
+    _lastHttp = 0;
+    _stateSince = 0;
+    memset(_residencyMs, 0, sizeof(_residencyMs));
+    memset(_wakes, 0, sizeof(_wakes));
+    _swallowTouch = false;
+    _refreshPaused = false;
+    _wakeStartUs = 0;
+    _pmEnabled = false;
+    _lightSleep = false;
+    memset(_locks, 0, sizeof(_locks));
+    _displayLock = nullptr;
+    memset(_held, 0, sizeof(_held));
+    memset((void*)_lockCounts, 0, sizeof(_lockCounts));
+    _stateCallback = nullptr;
+}
+
+void IdleManager::begin() {
+    _mutex = xSemaphoreCreateMutex();
+    _lastActivity = millis();
+    _stateSince = millis();
+
+    configurePM();
+    if (_displayLock != nullptr) {
+        esp_pm_lock_acquire(_displayLock);
+    }
+
+    metrics.addCollector(collect);
+}
+
+void IdleManager::configurePM() {
+#if ESP_IDF_VERSION_MAJOR >= 5
+    esp_pm_config_t pm = {};
+#else
+    esp_pm_config_esp32s3_t pm = {};
+#endif
+    pm.max_freq_mhz = PM_MAX_FREQ_MHZ;
+    pm.min_freq_mhz = PM_MIN_FREQ_MHZ;
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+    // Without tickless idle esp_pm_configure() rejects light sleep outright
+    pm.light_sleep_enable = PM_LIGHT_SLEEP;
+#endif
+
+    esp_err_t err = esp_pm_configure(&pm);
+    if (err != ESP_OK) {
+        // Core built without CONFIG_PM_ENABLE: locks are no-ops, clock stays fixed
+        LOG_WARN("Power management unavailable (%s), CPU stays at a fixed clock", esp_err_to_name(err));
+        return;
+    }
+    _pmEnabled = true;
+    _lightSleep = pm.light_sleep_enable;
+    LOG_INFO("Power management: %d-%d MHz, light sleep %s", PM_MIN_FREQ_MHZ, PM_MAX_FREQ_MHZ,
+             _lightSleep ? "on" : "off");
+
+    for (uint8_t i = 0; i < PM_LOCK_COUNT; i++) {
+        if (esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, powerLockNames[i], &_locks[i]) != ESP_OK) {
+            _locks[i] = nullptr;
+        }
+    }
+    // The RGB panel scans out of PSRAM continuously; light sleep would stop it
+    if (esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "display", &_displayLock) != ESP_OK) {
+        _displayLock = nullptr;
+    }
+}
+
+// ============================================================
+// STATE
+// ============================================================
+
+void IdleManager::update() {
+    DispensingState ds = hardwareControl.getState();
+    bool dispensing = ds == DISPENSING || ds == PAUSED || ds == STOPPING;
+
+    // A dispense started from the web interface wakes the display too
+    if (dispensing) {
+        notifyActivity(IDLE_WAKE_DISPENSE);
+    }
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+
+    hold(PM_LOCK_DISPENSE, dispensing);
+    hold(PM_LOCK_OTA, otaManager.isUpdating());
+    hold(PM_LOCK_HTTP, millis() - _lastHttp < PM_HTTP_HOLD);
+
+    // Only ever goes deeper here; waking is notifyActivity()'s job
+    unsigned long idle = millis() - _lastActivity;
+    IdleState target = IDLE_ACTIVE;
+    if (IDLE_OFF_TIMEOUT > 0 && idle >= IDLE_OFF_TIMEOUT) {
+        target = IDLE_OFF;
+    } else if (IDLE_DIM_TIMEOUT > 0 && idle >= IDLE_DIM_TIMEOUT) {
+        target = IDLE_DIMMED;
+    }
+    if (target > _state) {
+        setState(target);
+    }
+
+    xSemaphoreGive(_mutex);
+}
+
+void IdleManager::notifyActivity(IdleWakeSource source) {
+    _lastActivity = millis();
+    if (_state == IDLE_ACTIVE || _mutex == nullptr) return;
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    IdleState from = _state;
+    if (from != IDLE_ACTIVE) {
+        if (from == IDLE_OFF) {
+            _wakeStartUs = micros() | 1;    // Never 0, which means "not waking"
+        }
+        if (source == IDLE_WAKE_TOUCH) {
+            _swallowTouch = true;
+        }
+        _wakes[source]++;
+        setState(IDLE_ACTIVE);
+    }
+    xSemaphoreGive(_mutex);
+
+    if (from != IDLE_ACTIVE) {
+        LOG_DEBUG("Idle: woken from %s by %s", idleStateNames[from], wakeSourceNames[source]);
+        // Resume rendering now rather than after the LVGL task's idle sleep
+        lvglTask.wake();
+    }
+}
+
+void IdleManager::notifyHttp() {
+    _lastHttp = millis();
+    if (_held[PM_LOCK_HTTP] || _mutex == nullptr) return;
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    hold(PM_LOCK_HTTP, true);
+    xSemaphoreGive(_mutex);
+}
+
+// Called with _mutex held
+void IdleManager::setState(IdleState state) {
+    if (state == _state) return;
+
+    unsigned long now = millis();
+    _residencyMs[_state] += now - _stateSince;
+    _stateSince = now;
+
+    // Keep the panel running before it is lit, stop it only once it is dark
+    if (_state == IDLE_OFF && _displayLock != nullptr) {
+        esp_pm_lock_acquire(_displayLock);
+    }
+    switch (state) {
+        case IDLE_ACTIVE: setBacklight(DEFAULT_BRIGHTNESS); break;
+        case IDLE_DIMMED: setBacklight(DIMMED_BRIGHTNESS); break;
+        case IDLE_OFF:    setBacklight(0); break;
+        default: break;
+    }
+    if (state == IDLE_OFF && _displayLock != nullptr) {
+        esp_pm_lock_release(_displayLock);
+    }
+
+    _state = state;
+    if (_stateCallback != nullptr) {
+        _stateCallback(state);
+    }
+}
+
+// Called with _mutex held
+void IdleManager::hold(PowerLock lock, bool held) {
+    if (_held[lock] == held) return;
+    _held[lock] = held;
+    if (held) {
+        this->lock(lock);
+    } else {
+        unlock(lock);
+    }
+}
+
+void IdleManager::lock(PowerLock lock) {
+    _lockCounts[lock]++;
+    if (_locks[lock] != nullptr) {
+        esp_pm_lock_acquire(_locks[lock]);
+    }
+}
+
+void IdleManager::unlock(PowerLock lock) {
+    if (_locks[lock] != nullptr) {
+        esp_pm_lock_release(_locks[lock]);
+    }
+}
+
+uint32_t IdleManager::getLoopDelay() const {
+    // Nothing in loop() needs attention while dark and idle; the control
+    // loop still runs well inside CONTROL_PERIOD_BUDGET_US
+    if (_state == IDLE_OFF && !_held[PM_LOCK_DISPENSE] && !_held[PM_LOCK_OTA]) {
+        return IDLE_LOOP_DELAY;
+    }
+    return 5;
+}
+
+// ============================================================
+// LVGL SIDE
+// ============================================================
+
+void IdleManager::applyDisplayState() {
+    lv_disp_t* disp = lv_disp_get_default();
+    if (disp == nullptr) return;
+    lv_indev_t* indev = lv_indev_get_next(nullptr);
+
+    bool off = _state == IDLE_OFF;
+    if (off != _refreshPaused) {
+        _refreshPaused = off;
+        lv_timer_t* refr = _lv_disp_get_refr_timer(disp);
+        lv_timer_t* read = indev != nullptr ? indev->driver->read_timer : nullptr;
+        if (off) {
+            lv_timer_pause(refr);
+            if (read != nullptr) lv_timer_pause(read);
+        } else {
+            // Redraw everything so the first frame after waking is current
+            // and marks the end of the wake for the latency measurement
+            lv_timer_resume(refr);
+            if (read != nullptr) lv_timer_resume(read);
+            lv_obj_invalidate(lv_scr_act());
+        }
+    }
+
+    // The touch that woke the display must not also press a button
+    if (_swallowTouch && indev != nullptr) {
+        _swallowTouch = false;
+        lv_indev_wait_release(indev);
+    }
+}
+
+void IdleManager::onFrameRendered() {
+    uint32_t start = _wakeStartUs;
+    if (start == 0) return;
+    _wakeStartUs = 0;
+    _wakeLatency.observe(micros() - start);
+}
+
+// ============================================================
+// REPORTING
+// ============================================================
+
+String IdleManager::getStatusJSON() {
+    StaticJsonDocument<1024> doc;
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    IdleState state = _state;
+    uint32_t residency[IDLE_STATE_COUNT];
+    memcpy(residency, _residencyMs, sizeof(residency));
+    residency[state] += millis() - _stateSince;
+    xSemaphoreGive(_mutex);
+
+    doc["state"] = idleStateNames[state];
+    doc["idleMs"] = millis() - _lastActivity;
+    doc["dimTimeoutMs"] = IDLE_DIM_TIMEOUT;
+    doc["offTimeoutMs"] = IDLE_OFF_TIMEOUT;
+
+    JsonObject res = doc.createNestedObject("residencyMs");
+    for (uint8_t i = 0; i < IDLE_STATE_COUNT; i++) {
+        res[idleStateNames[i]] = residency[i];
+    }
+    JsonObject wakes = doc.createNestedObject("wakes");
+    for (uint8_t i = 0; i < IDLE_WAKE_SOURCE_COUNT; i++) {
+        wakes[wakeSourceNames[i]] = _wakes[i];
+    }
+    JsonObject latency = doc.createNestedObject("wakeLatency");
+    latency["count"] = _wakeLatency.count();
+    latency["p50Us"] = _wakeLatency.percentile(50);
+    latency["p99Us"] = _wakeLatency.percentile(99);
+    latency["maxUs"] = _wakeLatency.max();
+
+    JsonObject pm = doc.createNestedObject("pm");
+    pm["enabled"] = _pmEnabled;
+    pm["lightSleep"] = _lightSleep;
+    pm["minMHz"] = PM_MIN_FREQ_MHZ;
+    pm["maxMHz"] = PM_MAX_FREQ_MHZ;
+    JsonObject locks = pm.createNestedObject("locks");
+    for (uint8_t i = 0; i < PM_LOCK_COUNT; i++) {
+        JsonObject l = locks.createNestedObject(powerLockNames[i]);
+        l["acquired"] = _lockCounts[i];
+        if (i != PM_LOCK_RENDER) {
+            l["held"] = _held[i];
+        }
+    }
+
+    String output;
+    serializeJson(doc, output);
+    return output;
+}
+
+void IdleManager::collect(PrometheusWriter& w) {
+    IdleManager& m = idleManager;
+
+    w.gauge("waterdisp_idle_state", "Display power state (0 active, 1 dimmed, 2 off)", m._state);
+
+    w.header("waterdisp_idle_wakes_total", "counter", "Display wakes from dimmed or off");
+    for (uint8_t i = 0; i < IDLE_WAKE_SOURCE_COUNT; i++) {
+        w.printf("waterdisp_idle_wakes_total{source=\"%s\"} %u\n", wakeSourceNames[i], m._wakes[i]);
+    }
+
+    w.histogram("waterdisp_idle_wake_latency_microseconds",
+                "From the waking touch or dispense to the first frame with the display back on",
+                m._wakeLatency);
+
+    w.header("waterdisp_pm_lock_acquired_total", "counter", "Full-speed power lock acquisitions");
+    for (uint8_t i = 0; i < PM_LOCK_COUNT; i++) {
+        w.printf("waterdisp_pm_lock_acquired_total{lock=\"%s\"} %u\n", powerLockNames[i],
+                 (unsigned)m._lockCounts[i]);
+    }
+}
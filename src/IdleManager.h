@@ -0,0 +1,112 @@
+#ifndef IDLE_MANAGER_H
+#define IDLE_MANAGER_H
+
+#include <Arduino.h>
+#include <esp_pm.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "config.h"
+#include "Metrics.h"
+
+enum IdleState : uint8_t {
+    IDLE_ACTIVE,        // Backlight on, normal refresh
+    IDLE_DIMMED,        // Backlight dimmed, still refreshing
+    IDLE_OFF,           // Backlight off, LVGL refresh and touch input paused
+    IDLE_STATE_COUNT
+};
+
+enum IdleWakeSource : uint8_t {
+    IDLE_WAKE_TOUCH,
+    IDLE_WAKE_DISPENSE,
+    IDLE_WAKE_SOURCE_COUNT
+};
+
+// Reasons to run at full CPU speed. Each has its own esp_pm lock so
+// esp_pm_dump_locks() shows who is keeping the chip awake.
+enum PowerLock : uint8_t {
+    PM_LOCK_DISPENSE,
+    PM_LOCK_RENDER,
+    PM_LOCK_HTTP,
+    PM_LOCK_OTA,
+    PM_LOCK_COUNT
+};
+
+// Dims and then switches off the display when nobody is using the device,
+// and runs the chip under esp_pm dynamic frequency scaling (plus light sleep
+// with the display off, when the core supports it). Full speed is only held
+// while dispensing, rendering a frame, or serving HTTP/OTA. A touch or a
+// dispense wakes the display.
+class IdleManager {
+public:
+    IdleManager();
+
+    // Configure esp_pm and create the locks. Call after the display is up.
+    void begin();
+
+    // Timeouts and dispense/OTA locks. Call from loop().
+    void update();
+
+    // User activity; wakes the display. Safe to call from any task.
+    void notifyActivity(IdleWakeSource source);
+
+    // An HTTP request is being served: full speed for PM_HTTP_HOLD ms,
+    // without waking the display (status polling must not keep it on)
+    void notifyHttp();
+
+    // Apply display state changes to LVGL. Call from the LVGL task with the lock held.
+    void applyDisplayState();
+
+    // A frame was rendered (LVGL monitor callback); completes a wake measurement
+    void onFrameRendered();
+
+    void lock(PowerLock lock);
+    void unlock(PowerLock lock);
+
+    // Called with the new state on whichever task changed it
+    void onStateChange(void (*callback)(IdleState state)) { _stateCallback = callback; }
+
+    IdleState getState() const { return _state; }
+    bool isDisplayOff() const { return _state == IDLE_OFF; }
+
+    // How long loop() should sleep between iterations
+    uint32_t getLoopDelay() const;
+
+    String getStatusJSON();
+
+private:
+    SemaphoreHandle_t _mutex;
+    volatile IdleState _state;
+    volatile unsigned long _lastActivity;
+    volatile unsigned long _lastHttp;
+    unsigned long _stateSince;
+    uint32_t _residencyMs[IDLE_STATE_COUNT];
+    uint32_t _wakes[IDLE_WAKE_SOURCE_COUNT];
+
+    // Touch that woke the display is not passed on to the UI
+    volatile bool _swallowTouch;
+    bool _refreshPaused;
+
+    // Set on wake from IDLE_OFF, cleared by the first frame after it
+    volatile uint32_t _wakeStartUs;
+    MetricHistogram _wakeLatency;
+
+    bool _pmEnabled;
+    bool _lightSleep;
+    esp_pm_lock_handle_t _locks[PM_LOCK_COUNT];
+    esp_pm_lock_handle_t _displayLock;      // No light sleep while the panel is lit
+    bool _held[PM_LOCK_COUNT];              // Dispense/HTTP/OTA, owned by update()
+    volatile uint32_t _lockCounts[PM_LOCK_COUNT];
+
+    void (*_stateCallback)(IdleState state);
+
+    void configurePM();
+    void setState(IdleState state);
+    void hold(PowerLock lock, bool held);
+
+    static void collect(PrometheusWriter& writer);
+};
+
+// Global instance
+extern IdleManager idleManager;
+
+#endif // IDLE_MANAGER_H
@@ -0,0 +1,177 @@
+#include "Log.h"
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <stdarg.h>
+
+// Global instance
+Logger logger;
+
+// Serialises the consumer side (drain task vs. flush()) and the history buffer
+static SemaphoreHandle_t drainMutex = nullptr;
+
+static const char logLevelChars[] = { '-', 'E', 'W', 'I', 'D' };
+
+Logger::Logger() {
+    for (uint32_t i = 0; i < LOG_QUEUE_SLOTS; i++) {
+        _slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+    _head.store(0, std::memory_order_relaxed);
+    _tail = 0;
+    _dropped.store(0, std::memory_order_relaxed);
+    _reportedDropped = 0;
+    _history = nullptr;
+    _historyPos = 0;
+}
+
+void Logger::begin() {
+    _history = (char*)ps_malloc(LOG_HISTORY_SIZE);
+    if (_history == nullptr) {
+        _history = (char*)malloc(LOG_HISTORY_SIZE);
+    }
+
+    drainMutex = xSemaphoreCreateMutex();
+
+    // Priority 1: UART output only runs when nothing else wants the CPU
+    xTaskCreate(drainTask, "log_drain", 3072, this, 1, nullptr);
+}
+
+// ============================================================
+// PRODUCER SIDE (any task, never blocks)
+// ============================================================
+
+void Logger::write(uint8_t level, const char* fmt, ...) {
+    uint32_t pos = _head.load(std::memory_order_relaxed);
+    LogSlot* slot;
+
+    // Reserve a slot: claim position 'pos' if its slot has been released
+    for (;;) {
+        slot = &_slots[pos % LOG_QUEUE_SLOTS];
+        uint32_t seq = slot->seq.load(std::memory_order_acquire);
+        int32_t diff = (int32_t)(seq - pos);
+
+        if (diff == 0) {
+            if (_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Queue full: drop rather than wait for the UART
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = _head.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->timestamp = millis();
+    slot->level = level;
+
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(slot->text, LOG_LINE_MAX, fmt, args);
+    va_end(args);
+
+    // Publish to the drain side
+    slot->seq.store(pos + 1, std::memory_order_release);
+}
+
+// ============================================================
+// CONSUMER SIDE (drain task or flush())
+// ============================================================
+
+bool Logger::drainOne() {
+    LogSlot* slot = &_slots[_tail % LOG_QUEUE_SLOTS];
+    if (slot->seq.load(std::memory_order_acquire) != _tail + 1) {
+        return false;   // Empty, or the producer is still formatting
+    }
+
+    char line[LOG_LINE_MAX + 24];
+    int prefix = snprintf(line, sizeof(line), "%c (%lu) ",
+                          logLevelChars[slot->level < sizeof(logLevelChars) ? slot->level : 0],
+                          (unsigned long)slot->timestamp);
+
+    // Callers may or may not end their format with a newline; normalise to one
+    size_t textLen = strnlen(slot->text, LOG_LINE_MAX);
+    while (textLen > 0 && (slot->text[textLen - 1] == '\n' || slot->text[textLen - 1] == '\r')) {
+        textLen--;
+    }
+    memcpy(line + prefix, slot->text, textLen);
+    line[prefix + textLen] = '\n';
+
+    // Release the slot for the producer LOG_QUEUE_SLOTS positions ahead
+    slot->seq.store(_tail + LOG_QUEUE_SLOTS, std::memory_order_release);
+    _tail++;
+
+    emit(line, prefix + textLen + 1);
+    return true;
+}
+
+void Logger::emit(const char* line, size_t len) {
+    Serial.write((const uint8_t*)line, len);
+
+    if (_history == nullptr) return;
+    for (size_t i = 0; i < len; i++) {
+        _history[(_historyPos + i) % LOG_HISTORY_SIZE] = line[i];
+    }
+    _historyPos += len;
+}
+
+void Logger::flush() {
+    if (drainMutex != nullptr) {
+        xSemaphoreTake(drainMutex, portMAX_DELAY);
+    }
+
+    while (drainOne()) {
+    }
+    Serial.flush();
+
+    if (drainMutex != nullptr) {
+        xSemaphoreGive(drainMutex);
+    }
+}
+
+void Logger::drainTask(void* arg) {
+    Logger* self = (Logger*)arg;
+
+    for (;;) {
+        xSemaphoreTake(drainMutex, portMAX_DELAY);
+        while (self->drainOne()) {
+        }
+
+        uint32_t dropped = self->dropped();
+        if (dropped != self->_reportedDropped) {
+            char line[64];
+            size_t len = snprintf(line, sizeof(line), "W (%lu) Log queue full, %u line(s) dropped\n",
+                                  millis(), dropped - self->_reportedDropped);
+            self->emit(line, len);
+            self->_reportedDropped = dropped;
+        }
+        xSemaphoreGive(drainMutex);
+
+        vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_INTERVAL));
+    }
+}
+
+String Logger::getHistory() {
+    String output;
+    if (_history == nullptr || drainMutex == nullptr) return output;
+
+    xSemaphoreTake(drainMutex, portMAX_DELAY);
+
+    uint32_t len = _historyPos < LOG_HISTORY_SIZE ? _historyPos : LOG_HISTORY_SIZE;
+    uint32_t start = _historyPos - len;
+    output.reserve(len);
+
+    // Once the ring has wrapped, skip the partial first line
+    bool skipping = _historyPos > LOG_HISTORY_SIZE;
+    for (uint32_t i = 0; i < len; i++) {
+        char c = _history[(start + i) % LOG_HISTORY_SIZE];
+        if (skipping) {
+            skipping = (c != '\n');
+            continue;
+        }
+        output += c;
+    }
+
+    xSemaphoreGive(drainMutex);
+    return output;
+}
@@ -0,0 +1,94 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include "config.h"
+
+// Log levels, lowest number = most severe
+#define LOG_LVL_NONE    0
+#define LOG_LVL_ERROR   1
+#define LOG_LVL_WARN    2
+#define LOG_LVL_INFO    3
+#define LOG_LVL_DEBUG   4
+
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LVL_INFO
+#endif
+
+// Calls above LOG_COMPILE_LEVEL are removed by the preprocessor, arguments
+// included. Not for use from ISRs (formatting is done by the caller).
+#if LOG_COMPILE_LEVEL >= LOG_LVL_ERROR
+#define LOG_ERROR(fmt, ...) logger.write(LOG_LVL_ERROR, fmt, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(fmt, ...) do {} while (0)
+#endif
+
+#if LOG_COMPILE_LEVEL >= LOG_LVL_WARN
+#define LOG_WARN(fmt, ...) logger.write(LOG_LVL_WARN, fmt, ##__VA_ARGS__)
+#else
+#define LOG_WARN(fmt, ...) do {} while (0)
+#endif
+
+#if LOG_COMPILE_LEVEL >= LOG_LVL_INFO
+#define LOG_INFO(fmt, ...) logger.write(LOG_LVL_INFO, fmt, ##__VA_ARGS__)
+#else
+#define LOG_INFO(fmt, ...) do {} while (0)
+#endif
+
+#if LOG_COMPILE_LEVEL >= LOG_LVL_DEBUG
+#define LOG_DEBUG(fmt, ...) logger.write(LOG_LVL_DEBUG, fmt, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(fmt, ...) do {} while (0)
+#endif
+
+// One queued line. seq implements the bounded MPMC sequence protocol: a slot
+// is free for position p when seq == p and readable when seq == p + 1.
+struct LogSlot {
+    std::atomic<uint32_t> seq;
+    uint32_t timestamp;
+    uint8_t level;
+    char text[LOG_LINE_MAX];
+};
+
+class Logger {
+public:
+    Logger();
+
+    // Start the drain task. Lines written before this are kept in the queue.
+    void begin();
+
+    // Format one line into the queue. Never blocks; drops the line when the
+    // queue is full.
+    void write(uint8_t level, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+
+    // Drain everything queued so far on the calling task (e.g. before a restart)
+    void flush();
+
+    // Lines dropped because the queue was full
+    uint32_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+    // Copy of the most recent output (up to LOG_HISTORY_SIZE bytes), oldest first
+    String getHistory();
+
+private:
+    LogSlot _slots[LOG_QUEUE_SLOTS];
+    std::atomic<uint32_t> _head;    // Next position to reserve (producers)
+    uint32_t _tail;                 // Next position to read (drain side only)
+    std::atomic<uint32_t> _dropped;
+    uint32_t _reportedDropped;
+
+    char* _history;
+    uint32_t _historyPos;           // Total bytes ever appended
+
+    bool drainOne();
+    void emit(const char* line, size_t len);
+
+    static void drainTask(void* arg);
+};
+
+// Global instance
+extern Logger logger;
+
+#endif // LOG_H
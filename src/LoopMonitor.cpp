@@ -0,0 +1,209 @@
+#include "LoopMonitor.h"
+#include "config.h"
+#include "Log.h"
+#include <ArduinoJson.h>
+
+// Global instance
+LoopMonitor loopMonitor;
+
+static const char* const loopPhaseNames[LOOP_PHASE_COUNT] = {
+    "ota",
+    "hardware",
+    "web"
+};
+
+static const uint32_t loopPhaseBudgets[LOOP_PHASE_COUNT] = {
+    LOOP_BUDGET_OTA_US,
+    LOOP_BUDGET_HARDWARE_US,
+    LOOP_BUDGET_WEB_US
+};
+
+LoopMonitor::LoopMonitor() {
+    _currentPhase = LOOP_PHASE_OTA;
+    _inPhase = false;
+    _phaseStart = 0;
+    _iterationStart = 0;
+    _lastControlStart = 0;
+    _resetRequested = false;
+    _pendingPhase = LOOP_PHASE_COUNT;
+    _pendingUs = 0;
+    _pendingCount = 0;
+    _lastOverrunLog = 0;
+}
+
+void LoopMonitor::begin() {
+    metrics.addCollector(collect);
+}
+
+void LoopMonitor::beginIteration() {
+    if (_resetRequested.exchange(false)) {
+        applyReset();
+    }
+    _iterationStart = micros();
+}
+
+void LoopMonitor::endIteration() {
+    uint32_t elapsed = micros() - _iterationStart;
+    _iterationTime.observe(elapsed);
+    if (elapsed > LOOP_BUDGET_ITERATION_US) {
+        _iterationOverruns.inc();
+    }
+    flushOverrunLog();
+}
+
+void LoopMonitor::beginPhase(LoopPhase phase) {
+    _currentPhase = phase;
+    _inPhase = true;
+    _phaseStart = micros();
+
+    if (phase == LOOP_PHASE_HARDWARE) {
+        if (_lastControlStart != 0) {
+            uint32_t period = _phaseStart - _lastControlStart;
+            _controlPeriod.observe(period);
+            if (period > CONTROL_PERIOD_BUDGET_US) {
+                _controlOverruns.inc();
+            }
+        }
+        _lastControlStart = _phaseStart;
+    }
+}
+
+void LoopMonitor::endPhase() {
+    if (!_inPhase) return;
+    _inPhase = false;
+
+    uint32_t elapsed = micros() - _phaseStart;
+    _phaseTime[_currentPhase].observe(elapsed);
+
+    if (elapsed > loopPhaseBudgets[_currentPhase]) {
+        _phaseOverruns[_currentPhase].inc();
+        noteOverrun(_currentPhase, elapsed);
+    }
+}
+
+void LoopMonitor::noteOverrun(LoopPhase phase, uint32_t elapsedUs) {
+    _pendingCount++;
+    if (elapsedUs > _pendingUs) {
+        _pendingUs = elapsedUs;
+        _pendingPhase = phase;
+    }
+}
+
+void LoopMonitor::flushOverrunLog() {
+    if (_pendingCount == 0 || millis() - _lastOverrunLog < LOOP_OVERRUN_LOG_INTERVAL) {
+        return;
+    }
+
+    // Only the worst offender is printed; the rest is in the counters
+    LOG_WARN("Loop overrun: phase '%s' took %u us (budget %u us), %u overrun(s) since last report",
+             loopPhaseNames[_pendingPhase], _pendingUs,
+             loopPhaseBudgets[_pendingPhase], _pendingCount);
+
+    _lastOverrunLog = millis();
+    _pendingCount = 0;
+    _pendingUs = 0;
+    _pendingPhase = LOOP_PHASE_COUNT;
+}
+
+LoopPhaseStats LoopMonitor::getPhaseStats(LoopPhase phase) {
+    const MetricHistogram& h = _phaseTime[phase];
+    LoopPhaseStats stats;
+    stats.name = loopPhaseNames[phase];
+    stats.budgetUs = loopPhaseBudgets[phase];
+    stats.count = h.count();
+    stats.maxUs = h.max();
+    stats.p50Us = h.percentile(50);
+    stats.p90Us = h.percentile(90);
+    stats.p99Us = h.percentile(99);
+    stats.overruns = _phaseOverruns[phase].value();
+    return stats;
+}
+
+void LoopMonitor::reset() {
+    _resetRequested = true;
+}
+
+// On the loop task, between iterations, so no observe() runs concurrently
+void LoopMonitor::applyReset() {
+    for (uint8_t i = 0; i < LOOP_PHASE_COUNT; i++) {
+        _phaseTime[i].reset();
+    }
+    _iterationTime.reset();
+    _controlPeriod.reset();
+    _lastControlStart = 0;
+}
+
+void LoopMonitor::printReport(Print& out) {
+    out.println("Phase      budget    p50     p90     p99     max     overruns");
+    for (uint8_t i = 0; i < LOOP_PHASE_COUNT; i++) {
+        LoopPhaseStats s = getPhaseStats((LoopPhase)i);
+        out.printf("%-9s %7u %7u %7u %7u %7u %8u\n",
+                   s.name, s.budgetUs, s.p50Us, s.p90Us, s.p99Us, s.maxUs, s.overruns);
+    }
+    out.printf("%-9s %7u %7u %7u %7u %7u %8u\n", "iteration",
+               (uint32_t)LOOP_BUDGET_ITERATION_US, _iterationTime.percentile(50),
+               _iterationTime.percentile(90), _iterationTime.percentile(99),
+               _iterationTime.max(), _iterationOverruns.value());
+    out.printf("%-9s %7u %7u %7u %7u %7u %8u\n", "control",
+               (uint32_t)CONTROL_PERIOD_BUDGET_US, _controlPeriod.percentile(50),
+               _controlPeriod.percentile(90), _controlPeriod.percentile(99),
+               _controlPeriod.max(), _controlOverruns.value());
+    out.println("(all times in microseconds, percentiles are bucket upper bounds)");
+}
+
+String LoopMonitor::getStatusJSON() {
+    StaticJsonDocument<1536> doc;
+
+    JsonArray phases = doc.createNestedArray("phases");
+    for (uint8_t i = 0; i < LOOP_PHASE_COUNT; i++) {
+        LoopPhaseStats s = getPhaseStats((LoopPhase)i);
+        JsonObject p = phases.createNestedObject();
+        p["name"] = s.name;
+        p["budgetUs"] = s.budgetUs;
+        p["count"] = s.count;
+        p["p50Us"] = s.p50Us;
+        p["p90Us"] = s.p90Us;
+        p["p99Us"] = s.p99Us;
+        p["maxUs"] = s.maxUs;
+        p["overruns"] = s.overruns;
+    }
+
+    doc["iteration"]["budgetUs"] = LOOP_BUDGET_ITERATION_US;
+    doc["iteration"]["p99Us"] = _iterationTime.percentile(99);
+    doc["iteration"]["maxUs"] = _iterationTime.max();
+    doc["iteration"]["overruns"] = _iterationOverruns.value();
+
+    doc["controlPeriod"]["budgetUs"] = CONTROL_PERIOD_BUDGET_US;
+    doc["controlPeriod"]["p50Us"] = _controlPeriod.percentile(50);
+    doc["controlPeriod"]["p99Us"] = _controlPeriod.percentile(99);
+    doc["controlPeriod"]["maxUs"] = _controlPeriod.max();
+    doc["controlPeriod"]["overruns"] = _controlOverruns.value();
+
+    String output;
+    serializeJson(doc, output);
+    return output;
+}
+
+void LoopMonitor::collect(PrometheusWriter& w) {
+    LoopMonitor& m = loopMonitor;
+    char labels[24];
+
+    w.header("waterdisp_loop_phase_duration_microseconds", "histogram", "Duration of each loop() phase");
+    for (uint8_t i = 0; i < LOOP_PHASE_COUNT; i++) {
+        snprintf(labels, sizeof(labels), "phase=\"%s\"", loopPhaseNames[i]);
+        w.histogramSeries("waterdisp_loop_phase_duration_microseconds", labels, m._phaseTime[i]);
+    }
+
+    w.header("waterdisp_loop_phase_overruns_total", "counter", "loop() phases that exceeded their budget");
+    for (uint8_t i = 0; i < LOOP_PHASE_COUNT; i++) {
+        w.printf("waterdisp_loop_phase_overruns_total{phase=\"%s\"} %u\n",
+                 loopPhaseNames[i], m._phaseOverruns[i].value());
+    }
+
+    w.counter("waterdisp_loop_iteration_overruns_total", "loop() iterations that exceeded their budget",
+              m._iterationOverruns.value());
+    w.histogram("waterdisp_control_period_microseconds", "Time between HardwareControl::update() calls",
+                m._controlPeriod);
+    w.counter("waterdisp_control_period_overruns_total", "Control periods that exceeded their budget",
+              m._controlOverruns.value());
+}
@@ -0,0 +1,90 @@
+#ifndef LOOP_MONITOR_H
+#define LOOP_MONITOR_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "Metrics.h"
+
+// Phases of the Arduino loop(), in execution order
+enum LoopPhase {
+    LOOP_PHASE_OTA,
+    LOOP_PHASE_HARDWARE,
+    LOOP_PHASE_WEB,
+    LOOP_PHASE_COUNT
+};
+
+struct LoopPhaseStats {
+    const char* name;
+    uint32_t budgetUs;
+    uint32_t count;
+    uint32_t maxUs;
+    uint32_t p50Us;
+    uint32_t p90Us;
+    uint32_t p99Us;
+    uint32_t overruns;
+};
+
+class LoopMonitor {
+public:
+    LoopMonitor();
+
+    // Registers the /metrics collector
+    void begin();
+
+    // Call at the top and bottom of loop()
+    void beginIteration();
+    void endIteration();
+
+    // Bracket one phase of the loop
+    void beginPhase(LoopPhase phase);
+    void endPhase();
+
+    // Snapshot of one phase's counters
+    LoopPhaseStats getPhaseStats(LoopPhase phase);
+
+    // Time between consecutive HardwareControl::update() calls
+    const MetricHistogram& controlPeriod() const { return _controlPeriod; }
+    uint32_t controlPeriodOverruns() const { return _controlOverruns.value(); }
+
+    // Forget collected timing samples (overrun counters stay monotonic).
+    // Safe from any task: applied by loop() at its next beginIteration().
+    void reset();
+
+    // Print a one-table summary to the given stream
+    void printReport(Print& out);
+
+    // JSON summary for /api/loop
+    String getStatusJSON();
+
+private:
+    MetricHistogram _phaseTime[LOOP_PHASE_COUNT];
+    MetricCounter _phaseOverruns[LOOP_PHASE_COUNT];
+    MetricHistogram _iterationTime;
+    MetricCounter _iterationOverruns;
+    MetricHistogram _controlPeriod;
+    MetricCounter _controlOverruns;
+
+    LoopPhase _currentPhase;
+    bool _inPhase;
+    uint32_t _phaseStart;
+    uint32_t _iterationStart;
+    uint32_t _lastControlStart;
+    std::atomic<bool> _resetRequested;
+
+    // Worst overrun since the last log line, reported at most once per interval
+    LoopPhase _pendingPhase;
+    uint32_t _pendingUs;
+    uint32_t _pendingCount;
+    unsigned long _lastOverrunLog;
+
+    void applyReset();
+    void noteOverrun(LoopPhase phase, uint32_t elapsedUs);
+    void flushOverrunLog();
+
+    static void collect(PrometheusWriter& writer);
+};
+
+// Global instance
+extern LoopMonitor loopMonitor;
+
+#endif // LOOP_MONITOR_H
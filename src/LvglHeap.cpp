@@ -0,0 +1,352 @@
+#include "LvglHeap.h"
+#include "config.h"
+#include "Log.h"
+#include "LvglTask.h"
+#include <esp_heap_caps.h>
+
+// Global instance
+LvglHeap lvglHeap;
+
+static const char* const poolNames[LVGL_POOL_COUNT] = { "psram", "small", "scratch" };
+
+// Size class of a small allocation, and the block size it gets
+static inline uint8_t sizeClass(size_t size) {
+    return (size - 1) / LVGL_MEM_SMALL_STEP;
+}
+
+static inline size_t classSize(uint8_t cls) {
+    return ((size_t)cls + 1) * LVGL_MEM_SMALL_STEP;
+}
+
+LvglHeap::LvglHeap() {
+    for (uint8_t i = 0; i < LVGL_POOL_COUNT; i++) {
+        _heaps[i] = nullptr;
+        _regions[i] = nullptr;
+        _sizes[i] = 0;
+        _allocations[i] = 0;
+    }
+    memset(_freeLists, 0, sizeof(_freeLists));
+    memset(_pageClass, 0, sizeof(_pageClass));
+    memset(_pageLive, 0, sizeof(_pageLive));
+    _freePageCount = 0;
+    _smallListBytes = 0;
+    _initialized = false;
+    _liveBytes = 0;
+    _peakBytes = 0;
+    _liveBlocks = 0;
+    _failures = 0;
+    _spills = 0;
+}
+
+void LvglHeap::begin() {
+    if (_initialized) return;
+    _initialized = true;
+
+    // Main pool: PSRAM, or internal RAM on boards without it
+    _regions[LVGL_POOL_PSRAM] = (uint8_t*)heap_caps_malloc(LVGL_MEM_POOL_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (_regions[LVGL_POOL_PSRAM] == nullptr) {
+        LOG_WARN("LVGL heap: no PSRAM, main pool in internal RAM");
+        _regions[LVGL_POOL_PSRAM] = (uint8_t*)heap_caps_malloc(LVGL_MEM_POOL_SIZE, MALLOC_CAP_8BIT);
+    }
+
+#if LVGL_SMALL_PAGES > 0
+    _regions[LVGL_POOL_SMALL] = (uint8_t*)heap_caps_malloc(LVGL_SMALL_PAGES * LVGL_MEM_SMALL_PAGE,
+                                                           MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#endif
+#if LVGL_MEM_SCRATCH_SIZE > 0
+    _regions[LVGL_POOL_SCRATCH] = (uint8_t*)heap_caps_malloc(LVGL_MEM_SCRATCH_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#endif
+
+    const uint32_t sizes[LVGL_POOL_COUNT] = {
+        LVGL_MEM_POOL_SIZE, LVGL_SMALL_PAGES * LVGL_MEM_SMALL_PAGE, LVGL_MEM_SCRATCH_SIZE
+    };
+    for (uint8_t i = 0; i < LVGL_POOL_COUNT; i++) {
+        if (_regions[i] == nullptr) continue;
+        _sizes[i] = sizes[i];
+        // The small pool manages its own pages. No multi_heap lock: every
+        // caller already holds the LVGL lock.
+        if (i != LVGL_POOL_SMALL) {
+            _heaps[i] = multi_heap_register(_regions[i], sizes[i]);
+        }
+    }
+    if (_regions[LVGL_POOL_SMALL] != nullptr) {
+        // Hand out the lowest pages first
+        for (uint16_t page = LVGL_SMALL_PAGES; page > 0; page--) {
+            _freePages[_freePageCount++] = page - 1;
+        }
+    }
+
+    if (_heaps[LVGL_POOL_PSRAM] == nullptr) {
+        LOG_ERROR("LVGL heap: failed to allocate %u byte pool", (unsigned)LVGL_MEM_POOL_SIZE);
+    }
+    LOG_INFO("LVGL heap: %u bytes main pool, %u bytes small pool (<= %u bytes), %u bytes scratch pool (>= %u bytes)",
+             _sizes[LVGL_POOL_PSRAM], _sizes[LVGL_POOL_SMALL], (unsigned)LVGL_MEM_SMALL_MAX,
+             _sizes[LVGL_POOL_SCRATCH], (unsigned)LVGL_MEM_SCRATCH_MIN);
+}
+
+int8_t LvglHeap::poolOf(void* ptr) {
+    for (uint8_t i = 0; i < LVGL_POOL_COUNT; i++) {
+        if (_regions[i] != nullptr && (uint8_t*)ptr >= _regions[i] && (uint8_t*)ptr < _regions[i] + _sizes[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Pool an allocation of this size belongs in
+uint8_t LvglHeap::poolFor(size_t size) {
+    if (size <= LVGL_MEM_SMALL_MAX && _regions[LVGL_POOL_SMALL] != nullptr) return LVGL_POOL_SMALL;
+    if (size >= LVGL_MEM_SCRATCH_MIN && _heaps[LVGL_POOL_SCRATCH] != nullptr) return LVGL_POOL_SCRATCH;
+    return LVGL_POOL_PSRAM;
+}
+
+size_t LvglHeap::blockSize(uint8_t pool, void* ptr) {
+    if (pool == LVGL_POOL_SMALL) {
+        uint16_t page = ((uint8_t*)ptr - _regions[LVGL_POOL_SMALL]) / LVGL_MEM_SMALL_PAGE;
+        return classSize(_pageClass[page]);
+    }
+    return multi_heap_get_allocated_size(_heaps[pool], ptr);
+}
+
+void* LvglHeap::smallAlloc(size_t size) {
+    if (_regions[LVGL_POOL_SMALL] == nullptr) return nullptr;
+
+    uint8_t cls = sizeClass(size);
+    size_t bytes = classSize(cls);
+    if (_freeLists[cls] == nullptr) {
+        // Carve a free page into blocks of this class
+        if (_freePageCount == 0) return nullptr;
+        uint16_t page = _freePages[--_freePageCount];
+        _pageClass[page] = cls;
+        uint8_t* start = _regions[LVGL_POOL_SMALL] + (size_t)page * LVGL_MEM_SMALL_PAGE;
+        for (size_t offset = 0; offset + bytes <= LVGL_MEM_SMALL_PAGE; offset += bytes) {
+            *(void**)(start + offset) = _freeLists[cls];
+            _freeLists[cls] = start + offset;
+            _smallListBytes += bytes;
+        }
+    }
+
+    void* ptr = _freeLists[cls];
+    _freeLists[cls] = *(void**)ptr;
+    _smallListBytes -= bytes;
+    _pageLive[((uint8_t*)ptr - _regions[LVGL_POOL_SMALL]) / LVGL_MEM_SMALL_PAGE]++;
+    return ptr;
+}
+
+void LvglHeap::smallFree(void* ptr) {
+    uint16_t page = ((uint8_t*)ptr - _regions[LVGL_POOL_SMALL]) / LVGL_MEM_SMALL_PAGE;
+    uint8_t cls = _pageClass[page];
+    *(void**)ptr = _freeLists[cls];
+    _freeLists[cls] = ptr;
+    _smallListBytes += classSize(cls);
+    if (--_pageLive[page] > 0) return;
+
+    // Last block of the page: take its blocks off the class list and give
+    // the page back, so another class can use it
+    uint8_t* start = _regions[LVGL_POOL_SMALL] + (size_t)page * LVGL_MEM_SMALL_PAGE;
+    void** link = &_freeLists[cls];
+    while (*link != nullptr) {
+        uint8_t* block = (uint8_t*)*link;
+        if (block >= start && block < start + LVGL_MEM_SMALL_PAGE) {
+            *link = *(void**)block;
+            _smallListBytes -= classSize(cls);
+        } else {
+            link = (void**)block;
+        }
+    }
+    _freePages[_freePageCount++] = page;
+}
+
+void LvglHeap::accountAlloc(uint8_t pool, void* ptr) {
+    _liveBytes += blockSize(pool, ptr);
+    _liveBlocks++;
+    _allocations[pool]++;
+    if (_liveBytes > _peakBytes) {
+        _peakBytes = _liveBytes;
+    }
+}
+
+void LvglHeap::accountFree(uint8_t pool, void* ptr) {
+    _liveBytes -= blockSize(pool, ptr);
+    _liveBlocks--;
+}
+
+void* LvglHeap::allocFrom(uint8_t pool, size_t size) {
+    void* ptr;
+    if (pool == LVGL_POOL_SMALL) {
+        ptr = smallAlloc(size);
+    } else {
+        if (_heaps[pool] == nullptr) return nullptr;
+        ptr = multi_heap_malloc(_heaps[pool], size);
+    }
+    if (ptr != nullptr) {
+        accountAlloc(pool, ptr);
+    }
+    return ptr;
+}
+
+void* LvglHeap::allocate(size_t size) {
+    if (!_initialized) begin();
+    if (size == 0) return nullptr;
+
+    uint8_t pool = poolFor(size);
+    void* ptr = allocFrom(pool, size);
+    if (ptr == nullptr && pool != LVGL_POOL_PSRAM) {
+        ptr = allocFrom(LVGL_POOL_PSRAM, size);
+        if (ptr != nullptr) _spills++;
+    }
+
+    if (ptr == nullptr) {
+        // Pool exhausted: fail here rather than spill into the system heap
+        _failures++;
+        LOG_ERROR("LVGL heap exhausted: %u byte allocation failed (%u live)", (unsigned)size, _liveBytes);
+    }
+    return ptr;
+}
+
+void LvglHeap::release(void* ptr) {
+    if (ptr == nullptr) return;
+
+    int8_t pool = poolOf(ptr);
+    if (pool < 0) {
+        LOG_ERROR("LVGL heap: free of foreign pointer %p", ptr);
+        return;
+    }
+    accountFree(pool, ptr);
+    if (pool == LVGL_POOL_SMALL) {
+        smallFree(ptr);
+    } else {
+        multi_heap_free(_heaps[pool], ptr);
+    }
+}
+
+void* LvglHeap::reallocate(void* ptr, size_t size) {
+    if (ptr == nullptr) return allocate(size);
+    if (size == 0) {
+        release(ptr);
+        return nullptr;
+    }
+
+    int8_t pool = poolOf(ptr);
+    if (pool < 0) return nullptr;
+
+    size_t oldSize = blockSize(pool, ptr);
+
+    uint8_t target = poolFor(size);
+
+    // A small block keeps its place while the size stays in its class
+    if (pool == LVGL_POOL_SMALL && target == LVGL_POOL_SMALL && sizeClass(size) == sizeClass(oldSize)) {
+        return ptr;
+    }
+
+    // Move to the pool the new size belongs in. A block that spilled to
+    // PSRAM while an internal pool was full comes back here.
+    void* moved = target != pool ? allocFrom(target, size) : nullptr;
+    if (moved == nullptr && pool != LVGL_POOL_SMALL) {
+        // Otherwise grow or shrink in place
+        moved = multi_heap_realloc(_heaps[pool], ptr, size);
+        if (moved != nullptr) {
+            _allocations[pool]++;
+            _liveBytes = _liveBytes - oldSize + multi_heap_get_allocated_size(_heaps[pool], moved);
+            if (_liveBytes > _peakBytes) {
+                _peakBytes = _liveBytes;
+            }
+            return moved;
+        }
+    }
+    if (moved == nullptr) {
+        moved = allocate(size);
+        if (moved == nullptr) return nullptr;
+    }
+
+    memcpy(moved, ptr, oldSize < size ? oldSize : size);
+    release(ptr);
+    return moved;
+}
+
+LvglHeapStats LvglHeap::getStats() {
+    LvglHeapStats stats;
+    memset(&stats, 0, sizeof(stats));
+    stats.liveBytes = _liveBytes;
+    stats.peakBytes = _peakBytes;
+    stats.liveBlocks = _liveBlocks;
+    stats.failures = _failures;
+    stats.spills = _spills;
+
+    for (uint8_t i = 0; i < LVGL_POOL_COUNT; i++) {
+        if (_regions[i] == nullptr) continue;
+
+        LvglHeapPoolStats& p = stats.pools[i];
+        p.size = _sizes[i];
+        p.allocations = _allocations[i];
+        if (i == LVGL_POOL_SMALL) {
+            // Free pages serve any class, so they count as one block;
+            // blocks in the free lists only serve their own size class
+            uint32_t pageBytes = (uint32_t)_freePageCount * LVGL_MEM_SMALL_PAGE;
+            p.freeBytes = pageBytes + _smallListBytes;
+            p.largestFree = pageBytes;
+            for (uint8_t cls = 0; cls < LVGL_SMALL_CLASSES && pageBytes == 0; cls++) {
+                if (_freeLists[cls] != nullptr) p.largestFree = classSize(cls);
+            }
+        } else {
+            multi_heap_info_t info;
+            multi_heap_get_info(_heaps[i], &info);
+            p.freeBytes = info.total_free_bytes;
+            p.largestFree = info.largest_free_block;
+        }
+        p.fragmentation = p.freeBytes > 0
+            ? 100 - (uint8_t)((uint64_t)p.largestFree * 100 / p.freeBytes)
+            : 0;
+    }
+    return stats;
+}
+
+void LvglHeap::registerMetrics() {
+    metrics.addCollector(collect);
+}
+
+void LvglHeap::collect(PrometheusWriter& w) {
+    // Don't hold up a scrape for long if LVGL is mid-frame
+    if (!lvglTask.lock(20)) return;
+    LvglHeapStats s = lvglHeap.getStats();
+    lvglTask.unlock();
+
+    w.gauge("waterdisp_lvgl_heap_live_bytes", "Bytes allocated by LVGL", s.liveBytes);
+    w.gauge("waterdisp_lvgl_heap_peak_bytes", "Highest LVGL allocation total since boot", s.peakBytes);
+    w.gauge("waterdisp_lvgl_heap_live_blocks", "Live LVGL allocations", s.liveBlocks);
+    w.counter("waterdisp_lvgl_heap_failures_total", "LVGL allocations that failed because a pool was full",
+              s.failures);
+    w.counter("waterdisp_lvgl_heap_spills_total",
+              "LVGL allocations that went to PSRAM because their internal pool was full", s.spills);
+
+    w.header("waterdisp_lvgl_heap_free_bytes", "gauge", "Free bytes per LVGL pool");
+    for (uint8_t i = 0; i < LVGL_POOL_COUNT; i++) {
+        w.printf("waterdisp_lvgl_heap_free_bytes{pool=\"%s\"} %u\n", poolNames[i], s.pools[i].freeBytes);
+    }
+    w.header("waterdisp_lvgl_heap_allocations_total", "counter", "LVGL allocations served per pool");
+    for (uint8_t i = 0; i < LVGL_POOL_COUNT; i++) {
+        w.printf("waterdisp_lvgl_heap_allocations_total{pool=\"%s\"} %u\n", poolNames[i], s.pools[i].allocations);
+    }
+    w.header("waterdisp_lvgl_heap_fragmentation_percent", "gauge",
+             "100 minus the largest free block as a percentage of free bytes");
+    for (uint8_t i = 0; i < LVGL_POOL_COUNT; i++) {
+        w.printf("waterdisp_lvgl_heap_fragmentation_percent{pool=\"%s\"} %u\n", poolNames[i],
+                 s.pools[i].fragmentation);
+    }
+}
+
+// ============================================================
+// LVGL HOOKS
+// ============================================================
+
+extern "C" void* lvgl_heap_alloc(size_t size) {
+    return lvglHeap.allocate(size);
+}
+
+extern "C" void lvgl_heap_free(void* ptr) {
+    lvglHeap.release(ptr);
+}
+
+extern "C" void* lvgl_heap_realloc(void* ptr, size_t size) {
+    return lvglHeap.reallocate(ptr, size);
+}
@@ -0,0 +1,124 @@
+#ifndef LVGL_HEAP_H
+#define LVGL_HEAP_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LVGL allocator hooks (LV_MEM_CUSTOM_* in lv_conf.h). Called with the LVGL
+// lock held, like every other lv_* call.
+void* lvgl_heap_alloc(size_t size);
+void lvgl_heap_free(void* ptr);
+void* lvgl_heap_realloc(void* ptr, size_t size);
+
+#ifdef __cplusplus
+}
+
+#include <Arduino.h>
+#include <multi_heap.h>
+#include "Metrics.h"
+#include "config.h"
+
+enum LvglHeapPoolId {
+    LVGL_POOL_PSRAM,
+    LVGL_POOL_SMALL,
+    LVGL_POOL_SCRATCH,
+    LVGL_POOL_COUNT
+};
+
+#define LVGL_SMALL_CLASSES  (LVGL_MEM_SMALL_MAX / LVGL_MEM_SMALL_STEP)
+#define LVGL_SMALL_PAGES    (LVGL_MEM_SMALL_SIZE / LVGL_MEM_SMALL_PAGE)
+
+struct LvglHeapPoolStats {
+    uint32_t size;
+    uint32_t freeBytes;
+    uint32_t largestFree;
+    uint32_t allocations;       // Blocks handed out from this pool since boot
+    uint8_t fragmentation;      // 100 - largest free block as % of free bytes
+};
+
+struct LvglHeapStats {
+    uint32_t liveBytes;
+    uint32_t peakBytes;
+    uint32_t liveBlocks;
+    uint32_t failures;
+    uint32_t spills;            // Allocations meant for an internal pool that went to PSRAM
+    LvglHeapPoolStats pools[LVGL_POOL_COUNT];
+};
+
+// Private heaps for LVGL, so it never competes with WiFi and AsyncTCP for
+// the system heap; an exhausted pool fails the allocation (and is counted).
+//   small    internal RAM, segregated size classes of LVGL_MEM_SMALL_STEP
+//            bytes up to LVGL_MEM_SMALL_MAX (objects, styles, short strings).
+//            A page holds blocks of one class and goes back to the pool
+//            once all of them are free, so freeing never leaves holes
+//            another size can't use.
+//   scratch  internal RAM multi_heap for blocks of LVGL_MEM_SCRATCH_MIN bytes
+//            and up: lv_mem_buf draw scratch and layer buffers, which are
+//            touched on every frame.
+//   psram    multi_heap for everything else, and whatever the others can't fit.
+// multi_heap is first-fit on ESP-IDF 4.4 (the pinned core) and TLSF only from
+// ESP-IDF 5; keeping the many small, short-lived blocks out of it is what
+// limits its fragmentation.
+class LvglHeap {
+public:
+    LvglHeap();
+
+    // Allocate the pools. Called on first use; call before lv_init() to log
+    // placement early.
+    void begin();
+
+    void* allocate(size_t size);
+    void release(void* ptr);
+    void* reallocate(void* ptr, size_t size);
+
+    uint32_t getLiveBytes() const { return _liveBytes; }
+
+    // Walks the pools: call with the LVGL lock held
+    LvglHeapStats getStats();
+
+    // Registers the /metrics collector
+    void registerMetrics();
+
+private:
+    multi_heap_handle_t _heaps[LVGL_POOL_COUNT];     // nullptr for the small pool
+    uint8_t* _regions[LVGL_POOL_COUNT];
+    uint32_t _sizes[LVGL_POOL_COUNT];
+    bool _initialized;
+
+    // Small pool: free block list per size class, the class and live block
+    // count of each page, and the pages not given to any class
+    void* _freeLists[LVGL_SMALL_CLASSES];
+    uint8_t _pageClass[LVGL_SMALL_PAGES + 1];
+    uint8_t _pageLive[LVGL_SMALL_PAGES + 1];
+    uint16_t _freePages[LVGL_SMALL_PAGES + 1];
+    uint16_t _freePageCount;
+    uint32_t _smallListBytes;       // Bytes sitting in the free lists
+
+    uint32_t _liveBytes;
+    uint32_t _peakBytes;
+    uint32_t _liveBlocks;
+    uint32_t _failures;
+    uint32_t _spills;
+    uint32_t _allocations[LVGL_POOL_COUNT];
+
+    int8_t poolOf(void* ptr);
+    uint8_t poolFor(size_t size);
+    size_t blockSize(uint8_t pool, void* ptr);
+    void* smallAlloc(size_t size);
+    void smallFree(void* ptr);
+    void* allocFrom(uint8_t pool, size_t size);
+    void accountAlloc(uint8_t pool, void* ptr);
+    void accountFree(uint8_t pool, void* ptr);
+
+    static void collect(PrometheusWriter& writer);
+};
+
+// Global instance
+extern LvglHeap lvglHeap;
+
+#endif // __cplusplus
+
+#endif // LVGL_HEAP_H
@@ -0,0 +1,116 @@
+#include "LvglTask.h"
+#include "config.h"
+#include "UIManager.h"
+#include "DisplayBench.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include "IdleManager.h"
+#include "DrawBufferTuner.h"
+#include "HotPathBench.h"
+
+// Global instance
+LvglTask lvglTask;
+
+LvglTask::LvglTask() {
+    _mutex = nullptr;
+    _tickTimer = nullptr;
+    _task = nullptr;
+    _refrPeriod = LV_DISP_DEF_REFR_PERIOD;
+}
+
+void LvglTask::begin() {
+    _mutex = xSemaphoreCreateRecursiveMutex();
+    metrics.lvglRefrPeriod.set(_refrPeriod);
+
+    // LVGL time base, independent of how busy any task is
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = tickCallback;
+    timerArgs.name = "lv_tick";
+    esp_timer_create(&timerArgs, &_tickTimer);
+    esp_timer_start_periodic(_tickTimer, LVGL_TICK_PERIOD * 1000);
+
+    xTaskCreatePinnedToCore(taskMain, "lvgl", LVGL_TASK_STACK, this, LVGL_TASK_PRIORITY, &_task, LVGL_TASK_CORE);
+}
+
+bool LvglTask::lock(uint32_t timeoutMs) {
+    if (_mutex == nullptr) return true;   // Single-threaded during setup()
+    TickType_t ticks = (timeoutMs == portMAX_DELAY) ? portMAX_DELAY : pdMS_TO_TICKS(timeoutMs);
+    return xSemaphoreTakeRecursive(_mutex, ticks) == pdTRUE;
+}
+
+void LvglTask::unlock() {
+    if (_mutex == nullptr) return;
+    xSemaphoreGiveRecursive(_mutex);
+}
+
+void LvglTask::wake() {
+    if (_task != nullptr) {
+        xTaskNotifyGive(_task);
+    }
+}
+
+void LvglTask::tickCallback(void* arg) {
+    lv_tick_inc(LVGL_TICK_PERIOD);
+}
+
+void LvglTask::taskMain(void* arg) {
+    LvglTask* self = (LvglTask*)arg;
+
+    for (;;) {
+        self->lock();
+        idleManager.applyDisplayState();
+
+        // Full CPU speed only for passes that will actually draw
+        lv_disp_t* disp = lv_disp_get_default();
+        bool rendering = disp != nullptr && (disp->inv_p > 0 || lv_anim_count_running() > 0);
+        if (rendering) idleManager.lock(PM_LOCK_RENDER);
+
+        uint32_t start = micros();
+        tracer.spanBegin(TRACE_LV_TIMER);
+        uint32_t nextMs = lv_timer_handler();
+        tracer.spanEnd(TRACE_LV_TIMER);
+        metrics.lvglTimerTime.observe(micros() - start);
+
+        if (rendering) idleManager.unlock(PM_LOCK_RENDER);
+
+        // Apply updates posted by other tasks
+        uiManager.processMessages();
+        displayBench.update();
+        drawBufferTuner.update();
+        hotPathBench.update();
+        self->adaptRefreshPeriod();
+
+        self->unlock();
+
+        // Sleep until LVGL's next timer is due, but stay responsive to touch.
+        // With the display off only wake() or the idle sleep ends it.
+        uint32_t maxSleep = idleManager.isDisplayOff() ? LVGL_TASK_IDLE_SLEEP : LVGL_TASK_MAX_SLEEP;
+        if (nextMs < 1) nextMs = 1;
+        if (nextMs > maxSleep) nextMs = maxSleep;
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(nextMs));
+    }
+}
+
+void LvglTask::adaptRefreshPeriod() {
+    lv_disp_t* disp = lv_disp_get_default();
+    if (disp == nullptr) return;
+
+    bool active = uiManager.wantsFastRefresh() ||
+                  lv_anim_count_running() > 0 ||
+                  lv_disp_get_inactive_time(disp) < DISPLAY_ACTIVE_HOLD;
+    uint32_t period = active ? DISPLAY_REFR_PERIOD_ACTIVE : DISPLAY_REFR_PERIOD_IDLE;
+
+    if (period != _refrPeriod) {
+        lv_timer_set_period(_lv_disp_get_refr_timer(disp), period);
+        _refrPeriod = period;
+        metrics.lvglRefrPeriod.set(period);
+    }
+}
+
+LvglLock::LvglLock() {
+    lvglTask.lock();
+}
+
+LvglLock::~LvglLock() {
+    lvglTask.unlock();
+}
@@ -0,0 +1,51 @@
+#ifndef LVGL_TASK_H
+#define LVGL_TASK_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+// Runs lv_timer_handler() in its own task, ticked by an esp_timer.
+// Any other task that touches lv_* objects must hold the lock.
+class LvglTask {
+public:
+    LvglTask();
+
+    // Start the tick timer and the LVGL task. Call after the UI is built.
+    void begin();
+
+    // Recursive, so event handlers running inside the task may lock again.
+    // Returns false if the lock was not obtained within timeoutMs.
+    bool lock(uint32_t timeoutMs = portMAX_DELAY);
+    void unlock();
+
+    bool isRunning() const { return _task != nullptr; }
+
+    // Cut the current sleep short, e.g. to resume refresh on wake
+    void wake();
+
+private:
+    SemaphoreHandle_t _mutex;
+    esp_timer_handle_t _tickTimer;
+    TaskHandle_t _task;
+    uint32_t _refrPeriod;
+
+    void adaptRefreshPeriod();
+
+    static void tickCallback(void* arg);
+    static void taskMain(void* arg);
+};
+
+// Scoped lock for code outside the LVGL task
+class LvglLock {
+public:
+    LvglLock();
+    ~LvglLock();
+};
+
+// Global instance
+extern LvglTask lvglTask;
+
+#endif // LVGL_TASK_H
@@ -0,0 +1,285 @@
+#include "Metrics.h"
+#include "HotPath.h"
+#include "Log.h"
+#include <esp_heap_caps.h>
+#include <stdarg.h>
+
+// Global instance
+Metrics metrics;
+
+const uint32_t METRIC_LATENCY_BUCKETS_US[] = {
+    50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 1000000
+};
+const uint8_t METRIC_LATENCY_BUCKET_COUNT = sizeof(METRIC_LATENCY_BUCKETS_US) / sizeof(uint32_t);
+
+const uint32_t METRIC_DEPTH_BUCKETS[] = { 0, 1, 2, 4, 8, 16, 32 };
+const uint8_t METRIC_DEPTH_BUCKET_COUNT = sizeof(METRIC_DEPTH_BUCKETS) / sizeof(uint32_t);
+
+const uint32_t METRIC_AREA_BUCKETS_PX[] = { 1024, 4096, 16384, 32768, 65536, 131072, 262144, 384000 };
+const uint8_t METRIC_AREA_BUCKET_COUNT = sizeof(METRIC_AREA_BUCKETS_PX) / sizeof(uint32_t);
+
+// ============================================================
+// HISTOGRAM
+// ============================================================
+
+MetricHistogram::MetricHistogram()
+    : MetricHistogram(METRIC_LATENCY_BUCKETS_US, METRIC_LATENCY_BUCKET_COUNT) {
+}
+
+MetricHistogram::MetricHistogram(const uint32_t* bounds, uint8_t count) {
+    _bounds = bounds;
+    _numBounds = count > METRIC_MAX_BUCKETS ? METRIC_MAX_BUCKETS : count;
+    reset();
+}
+
+void HOT_PATH_ATTR MetricHistogram::observe(uint32_t value) {
+    uint8_t i = 0;
+    while (i < _numBounds && value > _bounds[i]) {
+        i++;
+    }
+    _buckets[i].fetch_add(1, std::memory_order_relaxed);
+    _count.fetch_add(1, std::memory_order_relaxed);
+
+    uint32_t oldLow = _sumLow.fetch_add(value, std::memory_order_relaxed);
+    if (oldLow + value < oldLow) {
+        _sumHigh.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint32_t prevMax = _max.load(std::memory_order_relaxed);
+    while (value > prevMax &&
+           !_max.compare_exchange_weak(prevMax, value, std::memory_order_relaxed)) {
+    }
+}
+
+uint32_t MetricHistogram::bucket(uint8_t i) const {
+    if (i > _numBounds) return 0;
+    return _buckets[i].load(std::memory_order_relaxed);
+}
+
+uint32_t MetricHistogram::count() const {
+    return _count.load(std::memory_order_relaxed);
+}
+
+uint64_t MetricHistogram::sum() const {
+    uint32_t high, low;
+    do {
+        high = _sumHigh.load(std::memory_order_relaxed);
+        low = _sumLow.load(std::memory_order_relaxed);
+    } while (high != _sumHigh.load(std::memory_order_relaxed));
+    return ((uint64_t)high << 32) | low;
+}
+
+uint32_t MetricHistogram::max() const {
+    return _max.load(std::memory_order_relaxed);
+}
+
+uint32_t MetricHistogram::percentile(uint8_t pct) const {
+    uint32_t total = count();
+    if (total == 0) return 0;
+
+    // Rank of the requested sample (1-based, rounded up)
+    uint32_t rank = (uint32_t)(((uint64_t)total * pct + 99) / 100);
+    if (rank == 0) rank = 1;
+
+    uint32_t seen = 0;
+    for (uint8_t i = 0; i < _numBounds; i++) {
+        seen += bucket(i);
+        if (seen >= rank) {
+            return _bounds[i];
+        }
+    }
+    return max();
+}
+
+void MetricHistogram::reset() {
+    for (uint8_t i = 0; i <= METRIC_MAX_BUCKETS; i++) {
+        _buckets[i].store(0, std::memory_order_relaxed);
+    }
+    _count.store(0, std::memory_order_relaxed);
+    _sumLow.store(0, std::memory_order_relaxed);
+    _sumHigh.store(0, std::memory_order_relaxed);
+    _max.store(0, std::memory_order_relaxed);
+}
+
+// ============================================================
+// REGISTRY
+// ============================================================
+
+Metrics::Metrics()
+    : loopTime(METRIC_LATENCY_BUCKETS_US, METRIC_LATENCY_BUCKET_COUNT),
+      hardwareUpdateTime(METRIC_LATENCY_BUCKETS_US, METRIC_LATENCY_BUCKET_COUNT),
+      lvglFlushTime(METRIC_LATENCY_BUCKETS_US, METRIC_LATENCY_BUCKET_COUNT),
+      lvglFlushArea(METRIC_AREA_BUCKETS_PX, METRIC_AREA_BUCKET_COUNT),
+      lvglTimerTime(METRIC_LATENCY_BUCKETS_US, METRIC_LATENCY_BUCKET_COUNT),
+      lvglRenderTime(METRIC_LATENCY_BUCKETS_US, METRIC_LATENCY_BUCKET_COUNT),
+      wsQueueDepthHist(METRIC_DEPTH_BUCKETS, METRIC_DEPTH_BUCKET_COUNT) {
+    _numCollectors = 0;
+}
+
+bool Metrics::addCollector(MetricCollector collector) {
+    if (_numCollectors >= METRIC_MAX_COLLECTORS) {
+        return false;
+    }
+    _collectors[_numCollectors++] = collector;
+    return true;
+}
+
+// Built-in metrics, split so that no section comes near the render buffer size
+enum BuiltinSection {
+    SECTION_FLOW,
+    SECTION_LOOP_TIME,
+    SECTION_HW_UPDATE_TIME,
+    SECTION_FLUSH_TIME,
+    SECTION_FLUSH_AREA,
+    SECTION_TIMER_TIME,
+    SECTION_RENDER_TIME,
+    SECTION_LVGL,
+    SECTION_WS,
+    SECTION_SYSTEM,
+    SECTION_BUILTIN_COUNT
+};
+
+uint8_t Metrics::sectionCount() const {
+    return SECTION_BUILTIN_COUNT + _numCollectors;
+}
+
+size_t Metrics::renderSection(uint8_t section, char* buf, size_t len) {
+    if (buf == nullptr || len == 0 || section >= sectionCount()) return 0;
+
+    PrometheusWriter w(buf, len);
+    if (section < SECTION_BUILTIN_COUNT) {
+        renderBuiltin(section, w);
+    } else {
+        _collectors[section - SECTION_BUILTIN_COUNT](w);
+    }
+
+    if (w.overflowed()) {
+        _droppedSections.inc();
+        LOG_WARN("Metrics: section %u does not fit %u bytes, dropped", section, (unsigned)len);
+        buf[0] = '\0';
+        return 0;
+    }
+    return w.length();
+}
+
+void Metrics::renderBuiltin(uint8_t section, PrometheusWriter& w) {
+    switch (section) {
+    case SECTION_FLOW:
+        w.counter("waterdisp_flow_pulses_total", "Flow sensor pulses seen by the ISR", flowPulses.value());
+        break;
+
+    case SECTION_LOOP_TIME:
+        w.histogram("waterdisp_loop_duration_microseconds", "Work time of one loop() iteration", loopTime);
+        break;
+    case SECTION_HW_UPDATE_TIME:
+        w.histogram("waterdisp_hw_update_duration_microseconds", "HardwareControl::update() latency", hardwareUpdateTime);
+        break;
+    case SECTION_FLUSH_TIME:
+        w.histogram("waterdisp_lvgl_flush_duration_microseconds", "Time from flush start until the area is in the framebuffer", lvglFlushTime);
+        break;
+    case SECTION_FLUSH_AREA:
+        w.histogram("waterdisp_lvgl_flush_area_pixels", "Size of each flushed area", lvglFlushArea);
+        break;
+    case SECTION_TIMER_TIME:
+        w.histogram("waterdisp_lvgl_timer_handler_duration_microseconds", "lv_timer_handler() run time in the LVGL task", lvglTimerTime);
+        break;
+    case SECTION_RENDER_TIME:
+        w.histogram("waterdisp_lvgl_render_duration_microseconds", "Time LVGL spent rendering and flushing one frame (ms resolution)", lvglRenderTime);
+        break;
+
+    case SECTION_LVGL:
+        w.counter("waterdisp_lvgl_frames_total", "Frames LVGL actually redrew", lvglFrames.value());
+        w.gauge("waterdisp_lvgl_refresh_period_milliseconds", "Current display refresh timer period", lvglRefrPeriod.value());
+        break;
+
+    case SECTION_WS:
+        w.gauge("waterdisp_ws_clients", "Connected WebSocket clients", wsClients.value());
+        w.gauge("waterdisp_ws_queue_depth", "Messages queued across WebSocket clients", wsQueueDepth.value());
+        w.histogram("waterdisp_ws_queue_depth_samples", "WebSocket send queue depth, sampled at WebSocket events and scrapes", wsQueueDepthHist);
+        break;
+
+    case SECTION_SYSTEM:
+        w.gauge("waterdisp_heap_internal_free_bytes", "Free internal heap",
+                (int32_t)heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+        w.gauge("waterdisp_heap_internal_min_free_bytes", "Lowest free internal heap since boot",
+                (int32_t)heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL));
+        w.gauge("waterdisp_heap_psram_free_bytes", "Free PSRAM heap",
+                (int32_t)heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+        w.gauge("waterdisp_heap_psram_min_free_bytes", "Lowest free PSRAM heap since boot",
+                (int32_t)heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM));
+
+        w.counter("waterdisp_nvs_writes_total", "Preferences values written to NVS", nvsWrites.value());
+        w.counter("waterdisp_metrics_dropped_sections_total", "Scrape sections dropped for not fitting the render buffer",
+                  _droppedSections.value());
+
+        w.gauge("waterdisp_uptime_seconds", "Seconds since boot", (int32_t)(millis() / 1000));
+        break;
+    }
+}
+
+// ============================================================
+// PROMETHEUS WRITER
+// ============================================================
+
+PrometheusWriter::PrometheusWriter(char* buf, size_t len) {
+    _buf = buf;
+    _len = len;
+    _pos = 0;
+    _overflowed = false;
+    if (_len > 0) {
+        _buf[0] = '\0';
+    }
+}
+
+void PrometheusWriter::printf(const char* fmt, ...) {
+    if (_overflowed) return;
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(_buf + _pos, _len - _pos, fmt, args);
+    va_end(args);
+    if (n < 0) return;
+    if ((size_t)n >= _len - _pos) {
+        // Cut the partial line off again so the buffer only holds whole lines
+        _buf[_pos] = '\0';
+        _overflowed = true;
+        return;
+    }
+    _pos += n;
+}
+
+void PrometheusWriter::header(const char* name, const char* type, const char* help) {
+    printf("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+void PrometheusWriter::counter(const char* name, const char* help, uint32_t value) {
+    header(name, "counter", help);
+    printf("%s %u\n", name, value);
+}
+
+void PrometheusWriter::gauge(const char* name, const char* help, int32_t value) {
+    header(name, "gauge", help);
+    printf("%s %d\n", name, value);
+}
+
+void PrometheusWriter::histogram(const char* name, const char* help, const MetricHistogram& h) {
+    header(name, "histogram", help);
+    histogramSeries(name, nullptr, h);
+}
+
+void PrometheusWriter::histogramSeries(const char* name, const char* labels, const MetricHistogram& h) {
+    const char* sep = labels ? "," : "";
+    if (!labels) labels = "";
+
+    uint32_t cumulative = 0;
+    for (uint8_t i = 0; i < h.bucketCount(); i++) {
+        cumulative += h.bucket(i);
+        printf("%s_bucket{%s%sle=\"%u\"} %u\n", name, labels, sep, h.bound(i), cumulative);
+    }
+    cumulative += h.bucket(h.bucketCount());
+    printf("%s_bucket{%s%sle=\"+Inf\"} %u\n", name, labels, sep, cumulative);
+
+    const char* open = *labels ? "{" : "";
+    const char* close = *labels ? "}" : "";
+    printf("%s_sum%s%s%s %llu\n", name, open, labels, close, (unsigned long long)h.sum());
+    printf("%s_count%s%s%s %u\n", name, open, labels, close, cumulative);
+}
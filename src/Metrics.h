@@ -0,0 +1,164 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Maximum number of finite buckets per histogram (+Inf is implicit)
+#define METRIC_MAX_BUCKETS 14
+
+// Maximum number of extra collectors other modules can register
+#define METRIC_MAX_COLLECTORS 8
+
+// Monotonic event counter. Lock-free, safe to bump from ISRs and any task.
+class MetricCounter {
+public:
+    MetricCounter() : _value(0) {}
+
+    inline __attribute__((always_inline)) void inc(uint32_t n = 1) {
+        _value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint32_t value() const { return _value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint32_t> _value;
+};
+
+// Last-value gauge
+class MetricGauge {
+public:
+    MetricGauge() : _value(0) {}
+
+    void set(int32_t value) { _value.store(value, std::memory_order_relaxed); }
+    int32_t value() const { return _value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int32_t> _value;
+};
+
+// Fixed-bucket histogram. Bucket bounds are inclusive upper limits, sorted
+// ascending; values above the last bound land in the implicit +Inf bucket.
+// observe() is lock-free; the 64-bit sum assumes a single writer per histogram.
+class MetricHistogram {
+public:
+    MetricHistogram();  // Latency buckets
+    MetricHistogram(const uint32_t* bounds, uint8_t count);
+
+    void observe(uint32_t value);
+
+    uint8_t bucketCount() const { return _numBounds; }
+    uint32_t bound(uint8_t i) const { return _bounds[i]; }
+    uint32_t bucket(uint8_t i) const;     // Non-cumulative count, i == bucketCount() is +Inf
+    uint32_t count() const;
+    uint64_t sum() const;
+    uint32_t max() const;
+
+    // Upper bound of the bucket holding the given percentile (0-100).
+    // Returns max() when the percentile falls in the +Inf bucket.
+    uint32_t percentile(uint8_t pct) const;
+
+    void reset();
+
+private:
+    const uint32_t* _bounds;
+    uint8_t _numBounds;
+    std::atomic<uint32_t> _buckets[METRIC_MAX_BUCKETS + 1];
+    std::atomic<uint32_t> _count;
+    std::atomic<uint32_t> _sumLow;
+    std::atomic<uint32_t> _sumHigh;
+    std::atomic<uint32_t> _max;
+};
+
+// Shared bucket layout for latencies (microseconds)
+extern const uint32_t METRIC_LATENCY_BUCKETS_US[];
+extern const uint8_t METRIC_LATENCY_BUCKET_COUNT;
+
+// Shared bucket layout for queue depths
+extern const uint32_t METRIC_DEPTH_BUCKETS[];
+extern const uint8_t METRIC_DEPTH_BUCKET_COUNT;
+
+// Shared bucket layout for screen areas (pixels)
+extern const uint32_t METRIC_AREA_BUCKETS_PX[];
+extern const uint8_t METRIC_AREA_BUCKET_COUNT;
+
+// Bounded Prometheus text writer over a caller-provided buffer; never allocates.
+// Once a line does not fit, nothing more is written and overflowed() is set.
+class PrometheusWriter {
+public:
+    PrometheusWriter(char* buf, size_t len);
+
+    size_t length() const { return _pos; }
+    bool overflowed() const { return _overflowed; }
+
+    void printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+    void header(const char* name, const char* type, const char* help);
+    void counter(const char* name, const char* help, uint32_t value);
+    void gauge(const char* name, const char* help, int32_t value);
+    void histogram(const char* name, const char* help, const MetricHistogram& h);
+
+    // Histogram series without HELP/TYPE, for labelled families.
+    // labels is the inner label list, e.g. "phase=\"lvgl\"".
+    void histogramSeries(const char* name, const char* labels, const MetricHistogram& h);
+
+private:
+    char* _buf;
+    size_t _len;
+    size_t _pos;
+    bool _overflowed;
+};
+
+// Appends module-specific metrics to a scrape
+typedef void (*MetricCollector)(PrometheusWriter& writer);
+
+class Metrics {
+public:
+    Metrics();
+
+    // Register an extra collector, called on every scrape after the built-in metrics
+    bool addCollector(MetricCollector collector);
+
+    // Flow sensor
+    MetricCounter flowPulses;
+
+    // Timing
+    MetricHistogram loopTime;
+    MetricHistogram hardwareUpdateTime;
+    MetricHistogram lvglFlushTime;
+    MetricHistogram lvglFlushArea;
+    MetricHistogram lvglTimerTime;
+    MetricHistogram lvglRenderTime;
+    MetricCounter lvglFrames;
+    MetricGauge lvglRefrPeriod;
+
+    // Web
+    MetricGauge wsClients;
+    MetricGauge wsQueueDepth;
+    MetricHistogram wsQueueDepthHist;
+
+    // Storage
+    MetricCounter nvsWrites;
+
+    // A scrape is rendered one section at a time (built-in groups, then each
+    // collector) so it can be streamed through a buffer smaller than the whole.
+    uint8_t sectionCount() const;
+
+    // Render one section in Prometheus text exposition format into buf.
+    // Returns the number of bytes written; a section that does not fit is
+    // dropped whole (returns 0) so the scrape never contains a partial line.
+    size_t renderSection(uint8_t section, char* buf, size_t len);
+
+private:
+    MetricCollector _collectors[METRIC_MAX_COLLECTORS];
+    uint8_t _numCollectors;
+
+    // Sections dropped because they did not fit the render buffer
+    MetricCounter _droppedSections;
+
+    void renderBuiltin(uint8_t section, PrometheusWriter& w);
+};
+
+// Global instance
+extern Metrics metrics;
+
+#endif // METRICS_H
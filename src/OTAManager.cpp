@@ -1,4 +1,5 @@
 #include "OTAManager.h"
+#include "Log.h"
 #include <WiFi.h>
 
 // Global instance
@@ -30,7 +31,7 @@ void OTAManager::begin(const char* hostname, const char* password) {
         } else { // U_SPIFFS or U_FS
             type = "filesystem";
         }
-        Serial.println("OTA Update Started: " + type);
+        LOG_INFO("OTA Update Started: %s", type.c_str());
         _isUpdating = true;
         _progress = 0;
 
@@ -41,7 +42,8 @@ void OTAManager::begin(const char* hostname, const char* password) {
     });
 
     ArduinoOTA.onEnd([this]() {
-        Serial.println("\nOTA Update Complete!");
+        LOG_INFO("OTA Update Complete!");
+        logger.flush();
         _isUpdating = false;
         _progress = 100;
 
@@ -53,7 +55,7 @@ void OTAManager::begin(const char* hostname, const char* password) {
 
     ArduinoOTA.onProgress([this](unsigned int progress, unsigned int total) {
         _progress = (progress / (total / 100));
-        Serial.printf("OTA Progress: %u%%\r", _progress);
+        LOG_DEBUG("OTA Progress: %u%%", _progress);
 
         // Call user callback if set
         if (_progressCallback != nullptr) {
@@ -62,18 +64,19 @@ void OTAManager::begin(const char* hostname, const char* password) {
     });
 
     ArduinoOTA.onError([this](ota_error_t error) {
-        Serial.printf("OTA Error[%u]: ", error);
+        const char* reason = "Unknown";
         if (error == OTA_AUTH_ERROR) {
-            Serial.println("Auth Failed");
+            reason = "Auth Failed";
         } else if (error == OTA_BEGIN_ERROR) {
-            Serial.println("Begin Failed");
+            reason = "Begin Failed";
         } else if (error == OTA_CONNECT_ERROR) {
-            Serial.println("Connect Failed");
+            reason = "Connect Failed";
         } else if (error == OTA_RECEIVE_ERROR) {
-            Serial.println("Receive Failed");
+            reason = "Receive Failed";
         } else if (error == OTA_END_ERROR) {
-            Serial.println("End Failed");
+            reason = "End Failed";
         }
+        LOG_ERROR("OTA Error[%u]: %s", error, reason);
         _isUpdating = false;
 
         // Call user callback if set
@@ -0,0 +1,372 @@
+#include "Screenshot.h"
+#include "LvglTask.h"
+#include <lvgl.h>
+#include <esp_heap_caps.h>
+
+#define ROW_BYTES       (SCREEN_WIDTH * 3)
+#define RUN_DISTANCE    3                   // Previous pixel
+#define UP_DISTANCE     (ROW_BYTES + 1)     // Same pixel one row up, past its filter byte
+#define MIN_MATCH       3
+#define MAX_MATCH       258
+
+// Largest a row can get: every byte a 9-bit literal, plus the filter byte
+#define ROW_WORST_CASE  ((ROW_BYTES + 1) * 9 / 8 + 8)
+
+static uint32_t crcTable[256];
+
+static void initCrcTable() {
+    if (crcTable[1] != 0) return;
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (uint8_t k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+        }
+        crcTable[n] = c;
+    }
+}
+
+static uint32_t crc32(const uint8_t* data, size_t len) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static void put32(uint8_t* p, uint32_t v) {
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+// Deflate length codes 257..285: base length and extra bits (RFC 1951 3.2.5)
+static const uint16_t lengthBase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t lengthExtra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+// Distance codes 0..29
+static const uint16_t distBase[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t distExtra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+static void* allocBuffer(size_t size) {
+    void* p = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (p == nullptr) {
+        p = heap_caps_malloc(size, MALLOC_CAP_8BIT);
+    }
+    return p;
+}
+
+ScreenshotStream::ScreenshotStream() {
+    _row = 0;
+    _finished = false;
+    _line = nullptr;
+    _prevLine = nullptr;
+    _pixels = nullptr;
+    _strip = nullptr;
+    _stripY = -1;
+    _out = nullptr;
+    _outLen = 0;
+    _outPos = 0;
+    _bitBuf = 0;
+    _bitCount = 0;
+    _adlerA = 1;
+    _adlerB = 0;
+    _bytesSent = 0;
+}
+
+ScreenshotStream::~ScreenshotStream() {
+    release();
+}
+
+void ScreenshotStream::release() {
+    free(_line);
+    free(_prevLine);
+    free(_pixels);
+    free(_strip);
+    free(_out);
+    _line = nullptr;
+    _prevLine = nullptr;
+    _pixels = nullptr;
+    _strip = nullptr;
+    _out = nullptr;
+}
+
+bool ScreenshotStream::isAvailable() {
+    return lv_disp_get_default() != nullptr;
+}
+
+bool ScreenshotStream::begin() {
+    if (!isAvailable()) return false;
+    initCrcTable();
+
+    _line = (uint8_t*)allocBuffer(ROW_BYTES);
+    _prevLine = (uint8_t*)allocBuffer(ROW_BYTES);
+    // The row copy is read byte by byte while encoding; keep it in internal RAM
+    _pixels = (uint16_t*)heap_caps_malloc(SCREEN_WIDTH * 2, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    _strip = (uint16_t*)allocBuffer((size_t)SCREEN_WIDTH * SCREENSHOT_STRIP_LINES * 2);
+    _out = (uint8_t*)allocBuffer(SCREENSHOT_CHUNK_SIZE);
+    if (_line == nullptr || _prevLine == nullptr || _pixels == nullptr || _strip == nullptr ||
+        _out == nullptr) {
+        return false;
+    }
+
+    // Signature, IHDR and the start of the zlib stream
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    memcpy(_out, signature, 8);
+    _outLen = 8;
+
+    size_t start = beginChunk("IHDR");
+    put32(_out + _outLen, SCREEN_WIDTH);
+    put32(_out + _outLen + 4, SCREEN_HEIGHT);
+    _out[_outLen + 8] = 8;      // Bits per channel
+    _out[_outLen + 9] = 2;      // RGB
+    _out[_outLen + 10] = 0;     // Deflate
+    _out[_outLen + 11] = 0;     // Adaptive filtering (only "none" is used)
+    _out[_outLen + 12] = 0;     // Not interlaced
+    _outLen += 13;
+    endChunk(start);
+
+    start = beginChunk("IDAT");
+    _out[_outLen++] = 0x78;     // zlib: deflate, 32K window
+    _out[_outLen++] = 0x01;
+    putBits(1, 1);              // BFINAL: the whole image is one block
+    putBits(1, 2);              // BTYPE 01: fixed Huffman codes
+    endChunk(start);
+    return true;
+}
+
+size_t ScreenshotStream::read(uint8_t* buf, size_t maxLen) {
+    if (_outPos >= _outLen) {
+        if (_finished) {
+            // Complete: the response may linger until the client closes
+            release();
+            return 0;
+        }
+        fillChunk();
+    }
+
+    size_t n = _outLen - _outPos;
+    if (n > maxLen) n = maxLen;
+    memcpy(buf, _out + _outPos, n);
+    _outPos += n;
+    _bytesSent += n;
+    return n;
+}
+
+// Encode rows until the next one might not fit, as one IDAT chunk; after
+// the last row, close the stream and append IEND
+void ScreenshotStream::fillChunk() {
+    _outLen = 0;
+    _outPos = 0;
+
+    size_t start = beginChunk("IDAT");
+    while (_row < SCREEN_HEIGHT && _outLen + ROW_WORST_CASE + 16 <= SCREENSHOT_CHUNK_SIZE) {
+        encodeRow();
+    }
+
+    if (_row < SCREEN_HEIGHT) {
+        endChunk(start);
+        return;
+    }
+
+    // End of block, pad to a byte, then the Adler-32 of the raw scanlines
+    putHuffman(0, 7);
+    if (_bitCount > 0) putBits(0, 8 - _bitCount);
+    put32(_out + _outLen, (_adlerB << 16) | _adlerA);
+    _outLen += 4;
+    endChunk(start);
+
+    start = beginChunk("IEND");
+    endChunk(start);
+    _finished = true;
+}
+
+void ScreenshotStream::readRow(uint16_t y) {
+    if (_stripY < 0 || y >= _stripY + SCREENSHOT_STRIP_LINES) {
+        renderStrip(y);
+    }
+    memcpy(_pixels, _strip + (size_t)(y - _stripY) * SCREEN_WIDTH, SCREEN_WIDTH * 2);
+
+    uint8_t* p = _line;
+    for (uint16_t x = 0; x < SCREEN_WIDTH; x++) {
+        uint16_t c = _pixels[x];
+        uint8_t r = (c >> 11) & 0x1F;
+        uint8_t g = (c >> 5) & 0x3F;
+        uint8_t b = c & 0x1F;
+        *p++ = (r << 3) | (r >> 2);
+        *p++ = (g << 2) | (g >> 4);
+        *p++ = (b << 3) | (b >> 2);
+    }
+}
+
+// Render rows y .. y + SCREENSHOT_STRIP_LINES - 1 of the active screen and
+// its top/system layers into _strip. Same technique as lv_snapshot: a
+// stand-in display whose draw context covers only the strip.
+void ScreenshotStream::renderStrip(uint16_t y) {
+    LvglLock lock;
+    _stripY = y;
+
+    lv_disp_t* disp = lv_disp_get_default();
+    lv_draw_ctx_t* ctx = (lv_draw_ctx_t*)lv_mem_alloc(disp->driver->draw_ctx_size);
+    if (ctx == nullptr) {
+        memset(_strip, 0, (size_t)SCREEN_WIDTH * SCREENSHOT_STRIP_LINES * 2);
+        return;
+    }
+
+    lv_area_t area;
+    lv_area_set(&area, 0, y, SCREEN_WIDTH - 1, y + SCREENSHOT_STRIP_LINES - 1);
+
+    lv_disp_drv_t driver;
+    lv_disp_drv_init(&driver);
+    driver.hor_res = SCREEN_WIDTH;
+    driver.ver_res = SCREEN_HEIGHT;
+    lv_disp_t strip;
+    lv_memset_00(&strip, sizeof(strip));
+    strip.driver = &driver;
+
+    disp->driver->draw_ctx_init(&driver, ctx);
+    driver.draw_ctx = ctx;
+    ctx->buf = _strip;
+    ctx->buf_area = &area;
+    ctx->clip_area = &area;
+
+    lv_disp_t* refreshing = _lv_refr_get_disp_refreshing();
+    _lv_refr_set_disp_refreshing(&strip);
+    lv_obj_redraw(ctx, lv_disp_get_scr_act(disp));
+    lv_obj_redraw(ctx, lv_disp_get_layer_top(disp));
+    lv_obj_redraw(ctx, lv_disp_get_layer_sys(disp));
+    _lv_refr_set_disp_refreshing(refreshing);
+
+    disp->driver->draw_ctx_deinit(&driver, ctx);
+    lv_mem_free(ctx);
+}
+
+void ScreenshotStream::encodeRow() {
+    readRow(_row);
+
+    static const uint8_t filterNone = 0;
+    putLiteral(filterNone);
+    adler(&filterNone, 1);
+    adler(_line, ROW_BYTES);
+
+    bool hasUp = _row > 0;
+    size_t i = 0;
+    while (i < ROW_BYTES) {
+        size_t limit = ROW_BYTES - i;
+        if (limit > MAX_MATCH) limit = MAX_MATCH;
+
+        // Matches stay within the row, so both sources are in the buffers
+        size_t run = 0;
+        if (i >= RUN_DISTANCE) {
+            while (run < limit && _line[i + run] == _line[i + run - RUN_DISTANCE]) run++;
+        }
+        size_t up = 0;
+        if (hasUp) {
+            while (up < limit && _line[i + up] == _prevLine[i + up]) up++;
+        }
+
+        if (up >= MIN_MATCH && up >= run) {
+            putMatch(up, UP_DISTANCE);
+            i += up;
+        } else if (run >= MIN_MATCH) {
+            putMatch(run, RUN_DISTANCE);
+            i += run;
+        } else {
+            putLiteral(_line[i++]);
+        }
+    }
+
+    uint8_t* swap = _prevLine;
+    _prevLine = _line;
+    _line = swap;
+    _row++;
+}
+
+// ============================================================
+// BIT OUTPUT
+// ============================================================
+
+void ScreenshotStream::putBits(uint32_t bits, uint8_t count) {
+    _bitBuf |= bits << _bitCount;
+    _bitCount += count;
+    while (_bitCount >= 8) {
+        _out[_outLen++] = _bitBuf & 0xFF;
+        _bitBuf >>= 8;
+        _bitCount -= 8;
+    }
+}
+
+// Huffman codes are sent most significant bit first
+void ScreenshotStream::putHuffman(uint16_t code, uint8_t length) {
+    uint16_t reversed = 0;
+    for (uint8_t i = 0; i < length; i++) {
+        reversed = (reversed << 1) | ((code >> i) & 1);
+    }
+    putBits(reversed, length);
+}
+
+void ScreenshotStream::putLiteral(uint8_t value) {
+    if (value < 144) {
+        putHuffman(0x30 + value, 8);
+    } else {
+        putHuffman(0x190 + value - 144, 9);
+    }
+}
+
+void ScreenshotStream::putMatch(uint16_t length, uint16_t distance) {
+    uint8_t lc = 28;
+    while (lengthBase[lc] > length) lc--;
+    uint16_t symbol = 257 + lc;
+    if (symbol < 280) {
+        putHuffman(symbol - 256, 7);
+    } else {
+        putHuffman(0xC0 + symbol - 280, 8);
+    }
+    putBits(length - lengthBase[lc], lengthExtra[lc]);
+
+    uint8_t dc = 29;
+    while (distBase[dc] > distance) dc--;
+    putHuffman(dc, 5);
+    putBits(distance - distBase[dc], distExtra[dc]);
+}
+
+void ScreenshotStream::adler(const uint8_t* data, size_t len) {
+    // One row (2401 bytes) is too short for the 32-bit sums to overflow
+    for (size_t i = 0; i < len; i++) {
+        _adlerA += data[i];
+        _adlerB += _adlerA;
+    }
+    _adlerA %= 65521;
+    _adlerB %= 65521;
+}
+
+// ============================================================
+// PNG CHUNKS
+// ============================================================
+
+size_t ScreenshotStream::beginChunk(const char* type) {
+    size_t start = _outLen;
+    _outLen += 4;   // Length, filled in by endChunk()
+    memcpy(_out + _outLen, type, 4);
+    _outLen += 4;
+    return start;
+}
+
+void ScreenshotStream::endChunk(size_t start) {
+    uint32_t dataLen = _outLen - start - 8;
+    put32(_out + start, dataLen);
+    put32(_out + _outLen, crc32(_out + start + 4, dataLen + 4));
+    _outLen += 4;
+}
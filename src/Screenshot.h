@@ -0,0 +1,75 @@
+#ifndef SCREENSHOT_H
+#define SCREENSHOT_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Streams what the panel is showing as a 24-bit PNG, a few rows at a time,
+// for a chunked HTTP response. The panel driver on ESP-IDF 4.4 does not
+// expose its framebuffer, so LVGL re-renders the active screen
+// SCREENSHOT_STRIP_LINES rows at a time into a strip buffer, holding the LVGL
+// lock for one strip at a time. Only one row of history, the strip and one
+// output chunk are held.
+//
+// Deflate uses one fixed-Huffman block whose only matches are "same as the
+// pixel to the left" and "same as the row above". That finds the long flat
+// runs a UI consists of at a fraction of the cost of a real LZ77 search.
+//
+// Each strip is rendered from the screen state current when it is reached,
+// so a change during the transfer shows up from that strip down.
+class ScreenshotStream {
+public:
+    ScreenshotStream();
+    ~ScreenshotStream();
+
+    // False when there is no display to read or memory is short
+    bool begin();
+
+    // Fill buf with up to maxLen bytes of PNG. Returns 0 once it is complete,
+    // and frees the buffers then.
+    size_t read(uint8_t* buf, size_t maxLen);
+
+    // True when LVGL has a display to render rows from
+    static bool isAvailable();
+
+    uint32_t getBytesSent() const { return _bytesSent; }
+
+private:
+    uint16_t _row;              // Next row to encode
+    bool _finished;             // IEND queued
+
+    uint8_t* _line;             // Current row as RGB888
+    uint8_t* _prevLine;         // Previous row, for "up" matches
+    uint16_t* _pixels;          // Row copied out of the strip
+    uint16_t* _strip;           // LVGL-rendered rows
+    int32_t _stripY;            // First row in _strip, -1 before the first render
+
+    // Output: one complete PNG chunk at a time
+    uint8_t* _out;
+    size_t _outLen;
+    size_t _outPos;
+
+    // Deflate state
+    uint32_t _bitBuf;
+    uint8_t _bitCount;
+    uint32_t _adlerA;
+    uint32_t _adlerB;
+    uint32_t _bytesSent;
+
+    void release();
+    void fillChunk();
+    void encodeRow();
+    void readRow(uint16_t y);
+    void renderStrip(uint16_t y);
+
+    void putBits(uint32_t bits, uint8_t count);
+    void putHuffman(uint16_t code, uint8_t length);
+    void putLiteral(uint8_t value);
+    void putMatch(uint16_t length, uint16_t distance);
+    void adler(const uint8_t* data, size_t len);
+
+    size_t beginChunk(const char* type);
+    void endChunk(size_t start);
+};
+
+#endif // SCREENSHOT_H
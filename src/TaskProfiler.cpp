@@ -0,0 +1,233 @@
+#include "TaskProfiler.h"
+#include "config.h"
+#include "Log.h"
+#include <ArduinoJson.h>
+#include <freertos/semphr.h>
+
+// Global instance
+TaskProfiler taskProfiler;
+
+static SemaphoreHandle_t profilerMutex = nullptr;
+
+#if configUSE_TRACE_FACILITY
+// Scratch buffer for uxTaskGetSystemState, only touched by sample()
+static TaskStatus_t statusBuffer[TASK_PROFILER_MAX_TASKS];
+#else
+// Without the trace facility tasks cannot be enumerated; watch the known ones
+static const char* const knownTasks[] = {
+    "loopTask", "lvgl", "touch", "log_drain", "async_tcp", "wifi", "tiT", "sys_evt", "arduino_events",
+    "esp_timer", "ipc0", "ipc1", "IDLE", "Tmr Svc"
+};
+#endif
+
+TaskProfiler::TaskProfiler() {
+    _numTasks = 0;
+    _coreLoad[0] = 0;
+    _coreLoad[1] = 0;
+    _lastTotalRuntime = 0;
+    _lastLogReport = 0;
+}
+
+void TaskProfiler::begin() {
+    profilerMutex = xSemaphoreCreateMutex();
+    metrics.addCollector(collect);
+
+    // Lowest priority above idle so sampling never preempts real work
+    xTaskCreate(samplerTask, "task_prof", 4096, this, 1, nullptr);
+
+    if (!hasRuntimeStats()) {
+        LOG_INFO("Task profiler: run time stats disabled, reporting stack watermarks only");
+    }
+}
+
+bool TaskProfiler::hasRuntimeStats() const {
+#if configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+void TaskProfiler::samplerTask(void* arg) {
+    TaskProfiler* self = (TaskProfiler*)arg;
+
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(TASK_PROFILER_INTERVAL));
+        self->sample();
+
+        if (TASK_PROFILER_LOG_INTERVAL > 0 &&
+            millis() - self->_lastLogReport >= TASK_PROFILER_LOG_INTERVAL) {
+            self->logReport();
+            self->_lastLogReport = millis();
+        }
+    }
+}
+
+void TaskProfiler::sample() {
+    TaskProfile fresh[TASK_PROFILER_MAX_TASKS];
+    uint8_t count = 0;
+    float coreLoad[2] = { 0, 0 };
+    uint32_t totalRuntime = 0;
+
+#if configUSE_TRACE_FACILITY
+    UBaseType_t n = uxTaskGetSystemState(statusBuffer, TASK_PROFILER_MAX_TASKS, &totalRuntime);
+
+    for (UBaseType_t i = 0; i < n && count < TASK_PROFILER_MAX_TASKS; i++) {
+        TaskProfile& t = fresh[count++];
+        strlcpy(t.name, statusBuffer[i].pcTaskName, sizeof(t.name));
+        t.handle = statusBuffer[i].xHandle;
+        t.priority = statusBuffer[i].uxCurrentPriority;
+        t.stackFreeMin = statusBuffer[i].usStackHighWaterMark;
+#if configGENERATE_RUN_TIME_STATS
+        t.runtime = statusBuffer[i].ulRunTimeCounter;
+#else
+        t.runtime = 0;
+#endif
+    }
+#else
+    for (size_t i = 0; i < sizeof(knownTasks) / sizeof(knownTasks[0]) && count < TASK_PROFILER_MAX_TASKS; i++) {
+        TaskHandle_t handle = xTaskGetHandle(knownTasks[i]);
+        if (handle == nullptr) continue;
+
+        TaskProfile& t = fresh[count++];
+        strlcpy(t.name, knownTasks[i], sizeof(t.name));
+        t.handle = handle;
+        t.priority = uxTaskPriorityGet(handle);
+        t.stackFreeMin = uxTaskGetStackHighWaterMark(handle);
+        t.runtime = 0;
+    }
+#endif
+
+    xSemaphoreTake(profilerMutex, portMAX_DELAY);
+
+    uint32_t elapsed = totalRuntime - _lastTotalRuntime;
+    for (uint8_t i = 0; i < count; i++) {
+        TaskProfile& t = fresh[i];
+        BaseType_t affinity = xTaskGetAffinity(t.handle);
+        t.core = (affinity == tskNO_AFFINITY) ? 2 : (uint8_t)affinity;
+        t.cpuPercent = 0;
+
+        // Per-interval CPU share: delta against the previous sample of the same task
+        if (elapsed > 0 && _lastTotalRuntime != 0) {
+            for (uint8_t j = 0; j < _numTasks; j++) {
+                if (_tasks[j].handle == t.handle) {
+                    t.cpuPercent = (t.runtime - _tasks[j].runtime) * 100.0f / elapsed;
+                    break;
+                }
+            }
+        }
+
+        // Core load is whatever the pinned idle task did not get; without
+        // run time stats there is nothing to derive it from
+        if (hasRuntimeStats() && strncmp(t.name, "IDLE", 4) == 0 && t.core < 2) {
+            coreLoad[t.core] = 100.0f - t.cpuPercent;
+        }
+    }
+
+    memcpy(_tasks, fresh, sizeof(TaskProfile) * count);
+    _numTasks = count;
+    _coreLoad[0] = coreLoad[0];
+    _coreLoad[1] = coreLoad[1];
+    _lastTotalRuntime = totalRuntime;
+
+    xSemaphoreGive(profilerMutex);
+}
+
+void TaskProfiler::logReport() {
+    if (profilerMutex == nullptr) return;
+    xSemaphoreTake(profilerMutex, portMAX_DELAY);
+
+    bool stats = hasRuntimeStats();
+    if (stats) {
+        LOG_INFO("Tasks: %u   core0 %.1f%%   core1 %.1f%%", _numTasks, _coreLoad[0], _coreLoad[1]);
+    } else {
+        LOG_INFO("Tasks: %u   (no run time stats, CPU load unknown)", _numTasks);
+    }
+    LOG_INFO("Name              Core  Prio   CPU%%   StackFree");
+    for (uint8_t i = 0; i < _numTasks; i++) {
+        const TaskProfile& t = _tasks[i];
+        char core[4];
+        if (t.core < 2) {
+            snprintf(core, sizeof(core), "%u", t.core);
+        } else {
+            strcpy(core, "-");
+        }
+        char cpu[8];
+        if (stats) {
+            snprintf(cpu, sizeof(cpu), "%.1f", t.cpuPercent);
+        } else {
+            strcpy(cpu, "-");
+        }
+        LOG_INFO("%-16s  %4s  %4u  %5s  %9u%s", t.name, core, t.priority, cpu,
+                   t.stackFreeMin, t.stackFreeMin < TASK_STACK_WARN_BYTES ? "  LOW" : "");
+    }
+
+    xSemaphoreGive(profilerMutex);
+}
+
+String TaskProfiler::getStatusJSON() {
+    // Heap-allocated on purpose: this runs on the async_tcp stack
+    DynamicJsonDocument doc(4096);
+
+    if (profilerMutex != nullptr) {
+        xSemaphoreTake(profilerMutex, portMAX_DELAY);
+
+        bool stats = hasRuntimeStats();
+        doc["runtimeStats"] = stats;
+        doc["intervalMs"] = TASK_PROFILER_INTERVAL;
+        doc["stackWarnBytes"] = TASK_STACK_WARN_BYTES;
+        if (stats) {
+            JsonArray cores = doc.createNestedArray("coreLoad");
+            cores.add(_coreLoad[0]);
+            cores.add(_coreLoad[1]);
+        } else {
+            doc["coreLoad"] = nullptr;      // Unknown without run time stats
+        }
+
+        JsonArray tasks = doc.createNestedArray("tasks");
+        for (uint8_t i = 0; i < _numTasks; i++) {
+            const TaskProfile& t = _tasks[i];
+            JsonObject o = tasks.createNestedObject();
+            o["name"] = (const char*)t.name;
+            o["core"] = t.core < 2 ? (int)t.core : -1;
+            o["priority"] = t.priority;
+            if (stats) {
+                o["cpu"] = serialized(String(t.cpuPercent, 1));
+            } else {
+                o["cpu"] = nullptr;
+            }
+            o["stackFree"] = t.stackFreeMin;
+        }
+
+        xSemaphoreGive(profilerMutex);
+    }
+
+    String output;
+    serializeJson(doc, output);
+    return output;
+}
+
+void TaskProfiler::collect(PrometheusWriter& w) {
+    TaskProfiler& p = taskProfiler;
+    if (profilerMutex == nullptr) return;
+    xSemaphoreTake(profilerMutex, portMAX_DELAY);
+
+    // CPU figures only exist with run time stats; absent beats a fake 0/100%
+    if (p.hasRuntimeStats()) {
+        w.header("waterdisp_core_load_percent", "gauge", "CPU load per core over the last sample interval");
+        w.printf("waterdisp_core_load_percent{core=\"0\"} %.1f\n", p._coreLoad[0]);
+        w.printf("waterdisp_core_load_percent{core=\"1\"} %.1f\n", p._coreLoad[1]);
+
+        w.header("waterdisp_task_cpu_percent", "gauge", "Share of one core used by each task over the last interval");
+        for (uint8_t i = 0; i < p._numTasks; i++) {
+            w.printf("waterdisp_task_cpu_percent{task=\"%s\"} %.1f\n", p._tasks[i].name, p._tasks[i].cpuPercent);
+        }
+    }
+
+    w.header("waterdisp_task_stack_free_min_bytes", "gauge", "Stack high water mark (never used bytes) per task");
+    for (uint8_t i = 0; i < p._numTasks; i++) {
+        w.printf("waterdisp_task_stack_free_min_bytes{task=\"%s\"} %u\n", p._tasks[i].name, p._tasks[i].stackFreeMin);
+    }
+
+    xSemaphoreGive(profilerMutex);
+}
@@ -0,0 +1,53 @@
+#ifndef TASK_PROFILER_H
+#define TASK_PROFILER_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "Metrics.h"
+
+// Maximum number of tasks tracked per sample
+#define TASK_PROFILER_MAX_TASKS 32
+
+struct TaskProfile {
+    char name[configMAX_TASK_NAME_LEN];
+    TaskHandle_t handle;
+    uint8_t core;               // 0, 1, or 2 for "not pinned"
+    uint8_t priority;
+    uint32_t stackFreeMin;      // Stack high water mark (bytes never used)
+    uint32_t runtime;           // Run time counter at the last sample
+    float cpuPercent;           // Share of one core over the last interval
+};
+
+class TaskProfiler {
+public:
+    TaskProfiler();
+
+    // Start the low-priority sampler task
+    void begin();
+
+    // Take one sample now (also called by the sampler task)
+    void sample();
+
+    // True when FreeRTOS run time stats are compiled in (CPU percentages)
+    bool hasRuntimeStats() const;
+
+    // Write the task table to the log, one LOG_INFO line per task
+    void logReport();
+    String getStatusJSON();
+
+private:
+    TaskProfile _tasks[TASK_PROFILER_MAX_TASKS];
+    uint8_t _numTasks;
+    float _coreLoad[2];
+    uint32_t _lastTotalRuntime;
+    unsigned long _lastLogReport;
+
+    static void samplerTask(void* arg);
+    static void collect(PrometheusWriter& writer);
+};
+
+// Global instance
+extern TaskProfiler taskProfiler;
+
+#endif // TASK_PROFILER_H
@@ -0,0 +1,163 @@
+#include "Trace.h"
+#include <esp_heap_caps.h>
+
+// Global instance
+Tracer tracer;
+
+static const char* const traceSpanNames[TRACE_SPAN_COUNT] = {
+    "lv_timer_handler",
+    "my_disp_flush",
+    "HardwareControl::update",
+    "webServer.update",
+    "touch_read",
+    "flow_isr"
+};
+
+Tracer::Tracer() {
+    _events = nullptr;
+    _mask = 0;
+    _head.store(0);
+    _enabled = false;
+    _exportStage = EXPORT_DONE;
+    _exportPos = 0;
+    _exportEnd = 0;
+    _exportWasEnabled = false;
+    _exportFirst = true;
+    _cyclesPerUs = 240;
+}
+
+bool Tracer::begin(uint32_t capacity) {
+    if (_events != nullptr) {
+        return true;
+    }
+
+    // Round down to a power of two so the ring index is a simple mask
+    uint32_t size = 1;
+    while ((size << 1) <= capacity) {
+        size <<= 1;
+    }
+
+    _events = (TraceEvent*)heap_caps_malloc(size * sizeof(TraceEvent), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (_events == nullptr) {
+        Serial.println("ERROR: Failed to allocate trace buffer in PSRAM");
+        return false;
+    }
+
+    _mask = size - 1;
+    _head.store(0);
+    Serial.printf("Trace buffer allocated: %u events (%u bytes)\n",
+                  size, size * sizeof(TraceEvent));
+    return true;
+}
+
+void Tracer::setEnabled(bool enabled) {
+    _enabled = enabled && _events != nullptr;
+}
+
+void Tracer::clear() {
+    _head.store(0);
+}
+
+uint32_t Tracer::size() const {
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    return head > capacity() ? capacity() : head;
+}
+
+void IRAM_ATTR Tracer::record(TraceSpan span, TracePhase phase) {
+    uint32_t cycles = ESP.getCycleCount();
+    uint32_t slot = _head.fetch_add(1, std::memory_order_relaxed) & _mask;
+
+    TraceEvent& ev = _events[slot];
+    ev.cycles = cycles;
+    ev.span = span;
+    ev.phase = phase;
+    ev.core = (uint8_t)xPortGetCoreID();
+}
+
+size_t Tracer::exportChunk(uint8_t* buffer, size_t maxLen, size_t index) {
+    if (index == 0) {
+        // Freeze the ring while it is being streamed out
+        _exportWasEnabled = _enabled;
+        _enabled = false;
+
+        uint32_t head = _head.load();
+        _exportEnd = head;
+        _exportPos = head > capacity() ? head - capacity() : 0;
+        _exportStage = EXPORT_HEADER;
+        _exportFirst = true;
+        _coreSeen[0] = _coreSeen[1] = false;
+        _cyclesPerUs = getCpuFrequencyMhz();
+        if (_cyclesPerUs == 0) _cyclesPerUs = 240;
+    }
+
+    char* out = (char*)buffer;
+    size_t written = 0;
+
+    if (_exportStage == EXPORT_HEADER) {
+        static const char header[] = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        if (maxLen < sizeof(header)) return 0;
+        memcpy(out, header, sizeof(header) - 1);
+        written += sizeof(header) - 1;
+        _exportStage = EXPORT_EVENTS;
+    }
+
+    while (_exportStage == EXPORT_EVENTS) {
+        if (_events == nullptr || _exportPos >= _exportEnd) {
+            _exportStage = EXPORT_FOOTER;
+            break;
+        }
+
+        const TraceEvent& ev = _events[_exportPos & _mask];
+        uint8_t core = ev.core & 1;
+
+        // Extend the 32-bit cycle counter per core. Signed deltas tolerate
+        // both counter wrap and the small reordering caused by an ISR
+        // recording between a task's counter read and its slot reservation.
+        int64_t ext;
+        if (!_coreSeen[core]) {
+            ext = 0;
+        } else {
+            ext = _extCycles[core] + (int32_t)(ev.cycles - _lastCycles[core]);
+        }
+
+        char line[128];
+        uint64_t us = ext < 0 ? 0 : (uint64_t)ext / _cyclesPerUs;
+        uint32_t frac = ext < 0 ? 0 : (uint32_t)(((uint64_t)ext % _cyclesPerUs) * 1000 / _cyclesPerUs);
+        const char* name = ev.span < TRACE_SPAN_COUNT ? traceSpanNames[ev.span] : "unknown";
+        int n = snprintf(line, sizeof(line),
+                         "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%llu.%03u,\"pid\":1,\"tid\":%u}",
+                         _exportFirst ? "" : ",\n",
+                         name, ev.phase == TRACE_PHASE_BEGIN ? 'B' : 'E',
+                         (unsigned long long)us, frac, core);
+        if (n < 0 || written + n > maxLen) {
+            break;  // Retry this event in the next chunk
+        }
+
+        memcpy(out + written, line, n);
+        written += n;
+        _coreSeen[core] = true;
+        _lastCycles[core] = ev.cycles;
+        _extCycles[core] = ext;
+        _exportFirst = false;
+        _exportPos++;
+    }
+
+    if (_exportStage == EXPORT_FOOTER) {
+        static const char footer[] = "\n]}\n";
+        if (written + sizeof(footer) - 1 <= maxLen) {
+            memcpy(out + written, footer, sizeof(footer) - 1);
+            written += sizeof(footer) - 1;
+            _exportStage = EXPORT_DONE;
+            _enabled = _exportWasEnabled;
+        }
+    }
+
+    return written;
+}
+
+void Tracer::abortExport() {
+    if (_exportStage != EXPORT_DONE) {
+        _exportStage = EXPORT_DONE;
+        _enabled = _exportWasEnabled;
+    }
+}
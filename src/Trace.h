@@ -0,0 +1,113 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Traced code regions. Names are listed in Trace.cpp (traceSpanNames).
+enum TraceSpan : uint8_t {
+    TRACE_LV_TIMER,
+    TRACE_DISP_FLUSH,
+    TRACE_HW_UPDATE,
+    TRACE_WEB_UPDATE,
+    TRACE_TOUCH_READ,
+    TRACE_FLOW_ISR,
+    TRACE_SPAN_COUNT
+};
+
+enum TracePhase : uint8_t {
+    TRACE_PHASE_BEGIN,
+    TRACE_PHASE_END
+};
+
+// One recorded event (8 bytes). Timestamps are raw CPU cycle counts of the
+// core that recorded the event.
+struct TraceEvent {
+    uint32_t cycles;
+    uint8_t span;
+    uint8_t phase;
+    uint8_t core;
+    uint8_t reserved;
+};
+
+class Tracer {
+public:
+    Tracer();
+
+    // Allocate the ring buffer in PSRAM. Capacity is rounded down to a power of two.
+    bool begin(uint32_t capacity);
+
+    // Runtime toggle. When disabled, recording costs a single load and branch.
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return _enabled; }
+
+    // Drop everything recorded so far
+    void clear();
+
+    inline __attribute__((always_inline)) void spanBegin(TraceSpan span) {
+        if (_enabled) record(span, TRACE_PHASE_BEGIN);
+    }
+
+    inline __attribute__((always_inline)) void spanEnd(TraceSpan span) {
+        if (_enabled) record(span, TRACE_PHASE_END);
+    }
+
+    // Number of events currently held in the ring
+    uint32_t size() const;
+    uint32_t capacity() const { return _mask ? _mask + 1 : 0; }
+
+    // Chrome trace-event JSON export, streamed in chunks. Call with index 0
+    // to start a new export; returns 0 once the document is complete.
+    // Recording is paused for the duration of the export.
+    size_t exportChunk(uint8_t* buffer, size_t maxLen, size_t index);
+
+    // Restore recording if an export was cut short (client disconnected)
+    void abortExport();
+
+private:
+    void IRAM_ATTR record(TraceSpan span, TracePhase phase);
+
+    TraceEvent* _events;
+    uint32_t _mask;
+    std::atomic<uint32_t> _head;
+    volatile bool _enabled;
+
+    // Export cursor
+    enum ExportStage : uint8_t { EXPORT_HEADER, EXPORT_EVENTS, EXPORT_FOOTER, EXPORT_DONE };
+    ExportStage _exportStage;
+    uint32_t _exportPos;
+    uint32_t _exportEnd;
+    bool _exportWasEnabled;
+    bool _exportFirst;
+    uint32_t _lastCycles[2];
+    int64_t _extCycles[2];
+    bool _coreSeen[2];
+    uint32_t _cyclesPerUs;
+};
+
+// Records a begin/end pair around the enclosing scope
+class TraceScope {
+public:
+    explicit TraceScope(TraceSpan span);
+    ~TraceScope();
+
+private:
+    TraceSpan _span;
+};
+
+// Global instance
+extern Tracer tracer;
+
+inline __attribute__((always_inline)) TraceScope::TraceScope(TraceSpan span) : _span(span) {
+    tracer.spanBegin(span);
+}
+
+inline __attribute__((always_inline)) TraceScope::~TraceScope() {
+    tracer.spanEnd(_span);
+}
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(span) TraceScope TRACE_CONCAT(_traceScope, __LINE__)(span)
+
+#endif // TRACE_H
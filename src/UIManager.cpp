@@ -1,13 +1,22 @@
 #include "UIManager.h"
 #include "HardwareControl.h"
 #include "config.h"
+#include "Metrics.h"
+#include "Log.h"
 #include <WiFi.h>
+#include "WiFiService.h"
+#include "UITheme.h"
+#include "LvglHeap.h"
 #include <Preferences.h>
 #include <ESPmDNS.h>
 
 // Global instance
 UIManager uiManager;
 
+static const char* const screenNames[SCREEN_COUNT] = {
+    "main", "keypad", "dispensing", "config", "calibration"
+};
+
 UIManager::UIManager() {
     _currentScreen = SCREEN_MAIN;
     _screen_main = nullptr;
@@ -15,45 +24,193 @@ UIManager::UIManager() {
     _screen_dispensing = nullptr;
     _screen_config = nullptr;
     _screen_calibration = nullptr;
+    _queue = nullptr;
+    _wifiConnected = false;
+    memset(&_posted, 0, sizeof(_posted));
+    _posted.state = IDLE;
+    _lastStatusPost = 0;
+    invalidateDispenseView();
+    _screenTimer = nullptr;
+    _label_disp_unit = nullptr;
+    _chart_flow = nullptr;
+    _ser_flow_max = nullptr;
+    _ser_flow_min = nullptr;
+    _flowRange = FLOW_CHART_RANGE * 10;
+    _flowVersion = 0;
+    _flowChartTimer = nullptr;
+    _scheduledScreen = SCREEN_MAIN;
+    _wifiConnectTimer = nullptr;
+    _wifiConnectStart = 0;
+    memset(_screenStats, 0, sizeof(_screenStats));
+    _bootBuildUs = 0;
+    _bootHeapBytes = 0;
 }
 
 void UIManager::begin() {
-    // Create all screens
-    Serial.println("Main screen");
-    Serial.flush();
-    createMainScreen();
-    Serial.println("keypad screen");
-    Serial.flush();
-    createKeypadScreen();
-    Serial.println("Dispensing screen");
-    Serial.flush();
-    createDispensingScreen();
-    Serial.println("Config screen");
-    Serial.flush();
-    createConfigScreen();
-    Serial.println("Calibration screen");
-    Serial.flush();
-    createCalibrationScreen();
-
-    Serial.println("Showing main screen");
-    Serial.flush();
+    _queue = xQueueCreate(UI_QUEUE_LENGTH, sizeof(UIMessage));
+    _wifiConnected = (WiFi.status() == WL_CONNECTED);
+
+    // WiFi events arrive on the Arduino event task; hand them over as messages
+    WiFi.onEvent([](arduino_event_id_t event, arduino_event_info_t info) {
+        uiManager.postWifiStatus(true);
+    }, ARDUINO_EVENT_WIFI_STA_GOT_IP);
+    WiFi.onEvent([](arduino_event_id_t event, arduino_event_info_t info) {
+        uiManager.postWifiStatus(false);
+    }, ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+    wifiService.onScanDone([]() {
+        UIMessage msg;
+        msg.type = UI_MSG_WIFI_SCAN_DONE;
+        uiManager.post(msg);
+    });
+
+    uiTheme.begin();
+
+    // Create persistent screens; the rest are built when first shown
+    uint32_t buildStart = micros();
+    uint32_t heapBefore = lvglHeap.getLiveBytes();
+    for (uint8_t i = 0; i < SCREEN_COUNT; i++) {
+        if (lifetimeOf((UIScreen)i) == LIFETIME_PERSISTENT) {
+            ensureScreen((UIScreen)i);
+        }
+    }
+    _bootBuildUs = micros() - buildStart;
+    _bootHeapBytes = (int32_t)(lvglHeap.getLiveBytes() - heapBefore);
+    LOG_INFO("UI screens built in %lu us, %ld bytes heap (lazy screens %s)",
+             (unsigned long)_bootBuildUs, (long)_bootHeapBytes, UI_LAZY_SCREENS ? "on" : "off");
+
+    metrics.addCollector(collect);
+
     // Show main screen
     showScreen(SCREEN_MAIN);
 }
 
-void UIManager::update() {
-    // Update dispensing screen if active
-    if (_currentScreen == SCREEN_DISPENSING) {
-        updateDispensingScreen();
+bool UIManager::post(const UIMessage& msg) {
+    if (_queue == nullptr) return false;
+    return xQueueSend(_queue, &msg, 0) == pdTRUE;
+}
+
+void UIManager::postWifiStatus(bool connected) {
+    UIMessage msg;
+    msg.type = UI_MSG_WIFI_STATUS;
+    msg.wifi.connected = connected;
+    post(msg);
+}
+
+void UIManager::postShowScreen(UIScreen screen) {
+    UIMessage msg;
+    msg.type = UI_MSG_SHOW_SCREEN;
+    msg.show.screen = screen;
+    post(msg);
+}
+
+void UIManager::postGesture(const Gesture& gesture) {
+    UIMessage msg;
+    msg.type = UI_MSG_GESTURE;
+    msg.gesture = gesture;
+    post(msg);
+}
+
+void UIManager::postDispenseStatus() {
+    DispensingState state = hardwareControl.getState();
+
+    // State changes go out immediately, value changes at most every interval
+    if (state == _posted.state && millis() - _lastStatusPost < UI_STATUS_POST_INTERVAL) {
+        return;
     }
 
-    // Update main screen status
-    if (_currentScreen == SCREEN_MAIN) {
-        updateMainStatus();
+    UIMessage msg;
+    msg.type = UI_MSG_DISPENSE_STATUS;
+    msg.dispense.dispensedML = hardwareControl.getDispensedAmount();
+    msg.dispense.targetML = hardwareControl.getTargetAmount();
+    msg.dispense.progress = hardwareControl.getProgress();
+    msg.dispense.state = state;
+
+    // Nothing visible changed since the last snapshot: don't post at all
+    int32_t dispensedTenths = lroundf(msg.dispense.dispensedML * 10);
+    int32_t targetTenths = lroundf(msg.dispense.targetML * 10);
+    if (state == _posted.state && dispensedTenths == _posted.dispensedTenths &&
+        targetTenths == _posted.targetTenths && msg.dispense.progress == _posted.progress) {
+        return;
+    }
+
+    msg.dispense.version = _posted.version + 1;
+    if (post(msg)) {
+        _posted.version = msg.dispense.version;
+        _posted.dispensedTenths = dispensedTenths;
+        _posted.targetTenths = targetTenths;
+        _posted.progress = msg.dispense.progress;
+        _posted.state = state;
+        _lastStatusPost = millis();
+    }
+}
+
+bool UIManager::wantsFastRefresh() {
+    return _currentScreen == SCREEN_DISPENSING;
+}
+
+void UIManager::processMessages() {
+    if (_queue == nullptr) return;
+
+    UIMessage msg;
+    while (xQueueReceive(_queue, &msg, 0) == pdTRUE) {
+        switch (msg.type) {
+            case UI_MSG_DISPENSE_STATUS:
+                if (_currentScreen == SCREEN_DISPENSING) {
+                    updateDispensingScreen(msg);
+                }
+                break;
+            case UI_MSG_WIFI_STATUS:
+                if (msg.wifi.connected != _wifiConnected) {
+                    _wifiConnected = msg.wifi.connected;
+                    updateWifiStatus();
+                }
+                break;
+            case UI_MSG_SHOW_SCREEN:
+                showScreen(msg.show.screen);
+                break;
+            case UI_MSG_WIFI_SCAN_DONE:
+                showScanResults(true);
+                break;
+            case UI_MSG_GESTURE:
+                handleGesture(msg.gesture);
+                break;
+        }
+    }
+}
+
+// Swipes move between the screens that have no state of their own to lose;
+// dispensing and calibration only react to their buttons
+void UIManager::handleGesture(const Gesture& gesture) {
+    LOG_DEBUG("Gesture %s at %u,%u on %s", GestureDetector::name(gesture.type),
+              gesture.x, gesture.y, screenNames[_currentScreen]);
+
+    switch (gesture.type) {
+        case GESTURE_SWIPE_LEFT:
+            if (_currentScreen == SCREEN_MAIN) {
+                showScreen(SCREEN_CONFIG);
+            }
+            break;
+
+        case GESTURE_SWIPE_RIGHT:
+        case GESTURE_TWO_FINGER_TAP:
+            // Same as the screen's Back / Cancel button
+            if (_currentScreen == SCREEN_CONFIG) {
+                saveConfigScreen();
+                showScreen(SCREEN_MAIN);
+            } else if (_currentScreen == SCREEN_KEYPAD) {
+                showScreen(SCREEN_MAIN);
+            }
+            break;
+
+        default:
+            break;
     }
 }
 
 void UIManager::showScreen(UIScreen screen) {
+    cancelScheduledScreen();
+    UIScreen previous = _currentScreen;
+    ensureScreen(screen);
     _currentScreen = screen;
 
     switch (screen) {
@@ -82,16 +239,143 @@ void UIManager::showScreen(UIScreen screen) {
             break;
         case SCREEN_DISPENSING:
             lv_scr_load(_screen_dispensing);
+            // Repaint every widget from the next status message
+            invalidateDispenseView();
             break;
         case SCREEN_CONFIG:
             lv_scr_load(_screen_config);
+            // Offer networks from an earlier scan (boot, web UI) right away
+            if (!wifiService.isScanning()) {
+                showScanResults(false);
+            }
+            if (_wifiConnectTimer != nullptr) {
+                lv_label_set_text(_label_wifi_status, "Connecting...");
+                lv_obj_set_style_text_color(_label_wifi_status, lv_color_hex(0xF39C12), 0);
+            }
             break;
         case SCREEN_CALIBRATION:
             lv_scr_load(_screen_calibration);
             break;
+        default:
+            break;
+    }
+
+    if (previous != screen && lifetimeOf(previous) == LIFETIME_DESTROY_ON_LEAVE) {
+        releaseScreen(previous);
+    }
+}
+
+ScreenLifetime UIManager::lifetimeOf(UIScreen screen) {
+#if UI_LAZY_SCREENS
+    switch (screen) {
+        case SCREEN_KEYPAD:
+            return LIFETIME_CACHED;
+        case SCREEN_CONFIG:
+        case SCREEN_CALIBRATION:
+            return LIFETIME_DESTROY_ON_LEAVE;
+        default:
+            // Main is home; dispensing must appear without delay
+            return LIFETIME_PERSISTENT;
+    }
+#else
+    return LIFETIME_PERSISTENT;
+#endif
+}
+
+lv_obj_t*& UIManager::screenObject(UIScreen screen) {
+    switch (screen) {
+        case SCREEN_KEYPAD:      return _screen_keypad;
+        case SCREEN_DISPENSING:  return _screen_dispensing;
+        case SCREEN_CONFIG:      return _screen_config;
+        case SCREEN_CALIBRATION: return _screen_calibration;
+        default:                 return _screen_main;
     }
 }
 
+void UIManager::ensureScreen(UIScreen screen) {
+    if (screenObject(screen) != nullptr) return;
+
+    // LVGL has its own pools, so the delta is exactly what the screen took
+    uint32_t start = micros();
+    uint32_t heapBefore = lvglHeap.getLiveBytes();
+
+    switch (screen) {
+        case SCREEN_MAIN:        createMainScreen(); break;
+        case SCREEN_KEYPAD:      createKeypadScreen(); break;
+        case SCREEN_DISPENSING:  createDispensingScreen(); break;
+        case SCREEN_CONFIG:      createConfigScreen(); break;
+        case SCREEN_CALIBRATION: createCalibrationScreen(); break;
+        default: break;
+    }
+
+    ScreenStats& stats = _screenStats[screen];
+    stats.buildUs = micros() - start;
+    stats.heapBytes = (int32_t)(lvglHeap.getLiveBytes() - heapBefore);
+    stats.builds++;
+    LOG_DEBUG("UI: built %s screen in %lu us, %ld bytes", screenNames[screen],
+              (unsigned long)stats.buildUs, (long)stats.heapBytes);
+}
+
+void UIManager::releaseScreen(UIScreen screen) {
+    lv_obj_t*& obj = screenObject(screen);
+    if (obj == nullptr) return;
+
+    // Deferred: we are usually inside an event handler of one of its widgets
+    lv_obj_del_async(obj);
+    obj = nullptr;
+}
+
+void UIManager::collect(PrometheusWriter& w) {
+    w.gauge("waterdisp_ui_boot_build_microseconds", "Time spent building screens at boot",
+            uiManager._bootBuildUs);
+    w.gauge("waterdisp_ui_boot_heap_bytes", "Heap taken by the screens built at boot",
+            uiManager._bootHeapBytes);
+
+    w.header("waterdisp_ui_screen_heap_bytes", "gauge", "Heap taken by the last build of each screen");
+    for (uint8_t i = 0; i < SCREEN_COUNT; i++) {
+        w.printf("waterdisp_ui_screen_heap_bytes{screen=\"%s\"} %ld\n",
+                 screenNames[i], (long)uiManager._screenStats[i].heapBytes);
+    }
+    w.header("waterdisp_ui_screen_build_microseconds", "gauge", "Duration of the last build of each screen");
+    for (uint8_t i = 0; i < SCREEN_COUNT; i++) {
+        w.printf("waterdisp_ui_screen_build_microseconds{screen=\"%s\"} %lu\n",
+                 screenNames[i], (unsigned long)uiManager._screenStats[i].buildUs);
+    }
+    w.header("waterdisp_ui_screen_builds_total", "counter", "Times each screen has been built");
+    for (uint8_t i = 0; i < SCREEN_COUNT; i++) {
+        w.printf("waterdisp_ui_screen_builds_total{screen=\"%s\"} %u\n",
+                 screenNames[i], uiManager._screenStats[i].builds);
+    }
+}
+
+void UIManager::scheduleScreen(UIScreen screen, uint32_t delayMs) {
+    cancelScheduledScreen();
+    _scheduledScreen = screen;
+    _screenTimer = lv_timer_create(screenTimerCallback, delayMs, nullptr);
+    lv_timer_set_repeat_count(_screenTimer, 1);
+}
+
+void UIManager::cancelScheduledScreen() {
+    if (_screenTimer != nullptr) {
+        lv_timer_del(_screenTimer);
+        _screenTimer = nullptr;
+    }
+}
+
+void UIManager::screenTimerCallback(lv_timer_t* timer) {
+    // One-shot: LVGL deletes the timer after this returns
+    uiManager._screenTimer = nullptr;
+    uiManager.showScreen(uiManager._scheduledScreen);
+}
+
+void UIManager::invalidateDispenseView() {
+    _rendered.version = 0;
+    _rendered.dispensedTenths = -1;
+    _rendered.targetTenths = -1;
+    _rendered.progress = 0xFF;
+    _rendered.state = (DispensingState)-1;
+}
+
 UIScreen UIManager::getCurrentScreen() {
     return _currentScreen;
 }
@@ -102,13 +386,12 @@ UIScreen UIManager::getCurrentScreen() {
 
 void UIManager::createMainScreen() {
     _screen_main = lv_obj_create(NULL);
-    lv_obj_set_style_bg_color(_screen_main, lv_color_hex(0x2C3E50), 0);
+    lv_obj_add_style(_screen_main, &uiTheme.screen, 0);
 
     // Title
     lv_obj_t* title = lv_label_create(_screen_main);
     lv_label_set_text(title, "Water Dispenser");
-    lv_obj_set_style_text_font(title, &lv_font_montserrat_24, 0);
-    lv_obj_set_style_text_color(title, lv_color_white(), 0);
+    lv_obj_add_style(title, &uiTheme.title, 0);
     lv_obj_align(title, LV_ALIGN_TOP_MID, 0, 20);
 
     // Load preset volumes from preferences
@@ -142,7 +425,7 @@ void UIManager::createMainScreen() {
     lv_obj_add_event_cb(_btn_preset1, mainScreenEventHandler, LV_EVENT_CLICKED, (void*)preset1_ml);
     lv_obj_t* label1 = lv_label_create(_btn_preset1);
     lv_label_set_text(label1, (unit->format(preset1_ml) + " " + unit->getSuffix()).c_str());
-    lv_obj_set_style_text_font(label1, &lv_font_montserrat_24, 0);
+    lv_obj_add_style(label1, &uiTheme.textLarge, 0);
     lv_obj_center(label1);
 
     _btn_preset2 = lv_btn_create(_screen_main);
@@ -151,7 +434,7 @@ void UIManager::createMainScreen() {
     lv_obj_add_event_cb(_btn_preset2, mainScreenEventHandler, LV_EVENT_CLICKED, (void*)preset2_ml);
     lv_obj_t* label2 = lv_label_create(_btn_preset2);
     lv_label_set_text(label2, (unit->format(preset2_ml) + " " + unit->getSuffix()).c_str());
-    lv_obj_set_style_text_font(label2, &lv_font_montserrat_24, 0);
+    lv_obj_add_style(label2, &uiTheme.textLarge, 0);
     lv_obj_center(label2);
 
     _btn_preset3 = lv_btn_create(_screen_main);
@@ -160,7 +443,7 @@ void UIManager::createMainScreen() {
     lv_obj_add_event_cb(_btn_preset3, mainScreenEventHandler, LV_EVENT_CLICKED, (void*)preset3_ml);
     lv_obj_t* label3 = lv_label_create(_btn_preset3);
     lv_label_set_text(label3, (unit->format(preset3_ml) + " " + unit->getSuffix()).c_str());
-    lv_obj_set_style_text_font(label3, &lv_font_montserrat_24, 0);
+    lv_obj_add_style(label3, &uiTheme.textLarge, 0);
     lv_obj_center(label3);
 
     _btn_preset4 = lv_btn_create(_screen_main);
@@ -169,38 +452,38 @@ void UIManager::createMainScreen() {
     lv_obj_add_event_cb(_btn_preset4, mainScreenEventHandler, LV_EVENT_CLICKED, (void*)preset4_ml);
     lv_obj_t* label4 = lv_label_create(_btn_preset4);
     lv_label_set_text(label4, (unit->format(preset4_ml) + " " + unit->getSuffix()).c_str());
-    lv_obj_set_style_text_font(label4, &lv_font_montserrat_24, 0);
+    lv_obj_add_style(label4, &uiTheme.textLarge, 0);
     lv_obj_center(label4);
 
     // WiFi button (top right, WiFi icon)
     _btn_wifi = lv_btn_create(_screen_main);
     lv_obj_set_size(_btn_wifi, 60, 60);
     lv_obj_align(_btn_wifi, LV_ALIGN_TOP_RIGHT, -80, 10);
-    lv_obj_set_style_radius(_btn_wifi, 30, 0);  // Make it circular
+    lv_obj_add_style(_btn_wifi, &uiTheme.btnRound, 0);  // Make it circular
     lv_obj_add_event_cb(_btn_wifi, mainScreenEventHandler, LV_EVENT_CLICKED, (void*)-3);
     lv_obj_t* label_wifi = lv_label_create(_btn_wifi);
     lv_label_set_text(label_wifi, LV_SYMBOL_WIFI);
-    lv_obj_set_style_text_font(label_wifi, &lv_font_montserrat_24, 0);
+    lv_obj_add_style(label_wifi, &uiTheme.textLarge, 0);
     lv_obj_center(label_wifi);
 
     // Settings button (top right, gear icon)
     _btn_settings = lv_btn_create(_screen_main);
     lv_obj_set_size(_btn_settings, 60, 60);
     lv_obj_align(_btn_settings, LV_ALIGN_TOP_RIGHT, -10, 10);
-    lv_obj_set_style_bg_color(_btn_settings, lv_color_hex(0x7F8C8D), 0);
-    lv_obj_set_style_radius(_btn_settings, 30, 0);  // Make it circular
+    lv_obj_add_style(_btn_settings, &uiTheme.btnNeutral, 0);
+    lv_obj_add_style(_btn_settings, &uiTheme.btnRound, 0);  // Make it circular
     lv_obj_add_event_cb(_btn_settings, mainScreenEventHandler, LV_EVENT_CLICKED, (void*)-2);
     lv_obj_t* label_settings = lv_label_create(_btn_settings);
     lv_label_set_text(label_settings, LV_SYMBOL_SETTINGS);
-    lv_obj_set_style_text_font(label_settings, &lv_font_montserrat_24, 0);
+    lv_obj_add_style(label_settings, &uiTheme.textLarge, 0);
     lv_obj_center(label_settings);
 
     // Custom amount section
     _label_custom_amount = lv_label_create(_screen_main);
     String customLabel = "Custom Amount (" + String(unit->getSuffix()) + "):";
     lv_label_set_text(_label_custom_amount, customLabel.c_str());
-    lv_obj_set_style_text_color(_label_custom_amount, lv_color_white(), 0);
-    lv_obj_set_style_text_font(_label_custom_amount, &lv_font_montserrat_20, 0);
+    lv_obj_add_style(_label_custom_amount, &uiTheme.label, 0);
+    lv_obj_add_style(_label_custom_amount, &uiTheme.textMedium, 0);
     lv_obj_align(_label_custom_amount, LV_ALIGN_BOTTOM_LEFT, 20, -120);
 
     // Custom amount textarea
@@ -217,11 +500,11 @@ void UIManager::createMainScreen() {
     _btn_dispense_custom = lv_btn_create(_screen_main);
     lv_obj_set_size(_btn_dispense_custom, 150, 60);
     lv_obj_align(_btn_dispense_custom, LV_ALIGN_BOTTOM_RIGHT, -20, -50);
-    lv_obj_set_style_bg_color(_btn_dispense_custom, lv_color_hex(0x27AE60), 0);
+    lv_obj_add_style(_btn_dispense_custom, &uiTheme.btnPrimary, 0);
     lv_obj_add_event_cb(_btn_dispense_custom, mainScreenEventHandler, LV_EVENT_CLICKED, (void*)-1);
     lv_obj_t* label_dispense = lv_label_create(_btn_dispense_custom);
     lv_label_set_text(label_dispense, "Dispense");
-    lv_obj_set_style_text_font(label_dispense, &lv_font_montserrat_20, 0);
+    lv_obj_add_style(label_dispense, &uiTheme.textMedium, 0);
     lv_obj_center(label_dispense);
 
     // Create numeric keyboard (initially hidden)
@@ -286,19 +569,16 @@ void UIManager::mainScreenEventHandler(lv_event_t* e) {
     }
 }
 
-void UIManager::updateMainStatus() {
-    // Update WiFi button color
-    updateWifiStatus();
-}
-
 void UIManager::updateWifiStatus() {
     // Update WiFi button color based on connection status
-    if (WiFi.status() == WL_CONNECTED) {
+    lv_obj_remove_style(_btn_wifi, &uiTheme.btnPrimary, 0);
+    lv_obj_remove_style(_btn_wifi, &uiTheme.btnMuted, 0);
+    if (_wifiConnected) {
         // Green when connected
-        lv_obj_set_style_bg_color(_btn_wifi, lv_color_hex(0x27AE60), 0);
+        lv_obj_add_style(_btn_wifi, &uiTheme.btnPrimary, 0);
     } else {
         // Gray when not connected
-        lv_obj_set_style_bg_color(_btn_wifi, lv_color_hex(0x95A5A6), 0);
+        lv_obj_add_style(_btn_wifi, &uiTheme.btnMuted, 0);
     }
 }
 
@@ -308,13 +588,12 @@ void UIManager::updateWifiStatus() {
 
 void UIManager::createKeypadScreen() {
     _screen_keypad = lv_obj_create(NULL);
-    lv_obj_set_style_bg_color(_screen_keypad, lv_color_hex(0x2C3E50), 0);
+    lv_obj_add_style(_screen_keypad, &uiTheme.screen, 0);
 
     // Title
     lv_obj_t* title = lv_label_create(_screen_keypad);
     lv_label_set_text(title, "Enter Amount (ml)");
-    lv_obj_set_style_text_font(title, &lv_font_montserrat_24, 0);
-    lv_obj_set_style_text_color(title, lv_color_white(), 0);
+    lv_obj_add_style(title, &uiTheme.title, 0);
     lv_obj_align(title, LV_ALIGN_TOP_MID, 0, 20);
 
     // Text area for amount input
@@ -323,7 +602,7 @@ void UIManager::createKeypadScreen() {
     lv_obj_align(_textarea_amount, LV_ALIGN_TOP_MID, 0, 70);
     lv_textarea_set_one_line(_textarea_amount, true);
     lv_textarea_set_max_length(_textarea_amount, 6);
-    lv_obj_set_style_text_font(_textarea_amount, &lv_font_montserrat_24, 0);
+    lv_obj_add_style(_textarea_amount, &uiTheme.textLarge, 0);
 
     // Numeric keypad
     static const char* btnm_map[] = {"1", "2", "3", "\n",
@@ -341,22 +620,22 @@ void UIManager::createKeypadScreen() {
     _btn_keypad_ok = lv_btn_create(_screen_keypad);
     lv_obj_set_size(_btn_keypad_ok, 200, 60);
     lv_obj_align(_btn_keypad_ok, LV_ALIGN_BOTTOM_RIGHT, -20, -20);
-    lv_obj_set_style_bg_color(_btn_keypad_ok, lv_color_hex(0x27AE60), 0);
+    lv_obj_add_style(_btn_keypad_ok, &uiTheme.btnPrimary, 0);
     lv_obj_add_event_cb(_btn_keypad_ok, keypadEventHandler, LV_EVENT_CLICKED, (void*)1);
     lv_obj_t* label_ok = lv_label_create(_btn_keypad_ok);
     lv_label_set_text(label_ok, "Start");
-    lv_obj_set_style_text_font(label_ok, &lv_font_montserrat_24, 0);
+    lv_obj_add_style(label_ok, &uiTheme.textLarge, 0);
     lv_obj_center(label_ok);
 
     // Cancel button
     _btn_keypad_cancel = lv_btn_create(_screen_keypad);
     lv_obj_set_size(_btn_keypad_cancel, 200, 60);
     lv_obj_align(_btn_keypad_cancel, LV_ALIGN_BOTTOM_LEFT, 20, -20);
-    lv_obj_set_style_bg_color(_btn_keypad_cancel, lv_color_hex(0xE74C3C), 0);
+    lv_obj_add_style(_btn_keypad_cancel, &uiTheme.btnDanger, 0);
     lv_obj_add_event_cb(_btn_keypad_cancel, keypadEventHandler, LV_EVENT_CLICKED, (void*)0);
     lv_obj_t* label_cancel = lv_label_create(_btn_keypad_cancel);
     lv_label_set_text(label_cancel, "Cancel");
-    lv_obj_set_style_text_font(label_cancel, &lv_font_montserrat_24, 0);
+    lv_obj_add_style(label_cancel, &uiTheme.textLarge, 0);
     lv_obj_center(label_cancel);
 }
 
@@ -400,64 +679,91 @@ void UIManager::keypadEventHandler(lv_event_t* e) {
 
 void UIManager::createDispensingScreen() {
     _screen_dispensing = lv_obj_create(NULL);
-    lv_obj_set_style_bg_color(_screen_dispensing, lv_color_hex(0x2C3E50), 0);
+    lv_obj_add_style(_screen_dispensing, &uiTheme.screen, 0);
 
     // Title
     _label_disp_title = lv_label_create(_screen_dispensing);
     lv_label_set_text(_label_disp_title, "Dispensing...");
-    lv_obj_set_style_text_font(_label_disp_title, &lv_font_montserrat_24, 0);
-    lv_obj_set_style_text_color(_label_disp_title, lv_color_white(), 0);
-    lv_obj_align(_label_disp_title, LV_ALIGN_TOP_MID, 0, 30);
+    lv_obj_add_style(_label_disp_title, &uiTheme.title, 0);
+    lv_obj_align(_label_disp_title, LV_ALIGN_TOP_MID, 0, 20);
+
+    // Dispensed amount: big fixed-cell digits, up to 99999.9 ml
+    lv_obj_t* amount = _digits_disp_amount.create(_screen_dispensing, 5, 1);
+    lv_obj_add_style(amount, &uiTheme.value, 0);
+    lv_obj_align(amount, LV_ALIGN_TOP_MID, -20, 60);
 
-    // Current amount label
-    _label_disp_amount = lv_label_create(_screen_dispensing);
-    lv_label_set_text(_label_disp_amount, "0 ml");
-    lv_obj_set_style_text_font(_label_disp_amount, &lv_font_montserrat_24, 0);
-    lv_obj_set_style_text_color(_label_disp_amount, lv_color_hex(0x3498DB), 0);
-    lv_obj_align(_label_disp_amount, LV_ALIGN_CENTER, 0, -80);
+    _label_disp_unit = lv_label_create(_screen_dispensing);
+    lv_label_set_text(_label_disp_unit, "ml");
+    lv_obj_add_style(_label_disp_unit, &uiTheme.value, 0);
+    lv_obj_align_to(_label_disp_unit, amount, LV_ALIGN_OUT_RIGHT_BOTTOM, 10, -4);
 
     // Target amount label
     _label_disp_target = lv_label_create(_screen_dispensing);
     lv_label_set_text(_label_disp_target, "/ 0 ml");
-    lv_obj_set_style_text_font(_label_disp_target, &lv_font_montserrat_24, 0);
-    lv_obj_set_style_text_color(_label_disp_target, lv_color_hex(0x95A5A6), 0);
-    lv_obj_align(_label_disp_target, LV_ALIGN_CENTER, 0, -30);
+    lv_obj_add_style(_label_disp_target, &uiTheme.textLarge, 0);
+    lv_obj_add_style(_label_disp_target, &uiTheme.textMuted, 0);
+    lv_obj_align(_label_disp_target, LV_ALIGN_CENTER, 0, -70);
 
     // Progress bar
     _bar_progress = lv_bar_create(_screen_dispensing);
-    lv_obj_set_size(_bar_progress, 600, 40);
-    lv_obj_align(_bar_progress, LV_ALIGN_CENTER, 0, 40);
+    lv_obj_set_size(_bar_progress, 600, 26);
+    lv_obj_align(_bar_progress, LV_ALIGN_CENTER, 0, -35);
     lv_bar_set_value(_bar_progress, 0, LV_ANIM_OFF);
-    lv_obj_set_style_bg_color(_bar_progress, lv_color_hex(0x34495E), 0);
-    lv_obj_set_style_bg_color(_bar_progress, lv_color_hex(0x27AE60), LV_PART_INDICATOR);
+    lv_obj_add_style(_bar_progress, &uiTheme.panel, 0);
+    lv_obj_add_style(_bar_progress, &uiTheme.btnPrimary, LV_PART_INDICATOR);
 
     // Progress percentage label
     _label_progress = lv_label_create(_screen_dispensing);
     lv_label_set_text(_label_progress, "0%");
-    lv_obj_set_style_text_font(_label_progress, &lv_font_montserrat_24, 0);
-    lv_obj_set_style_text_color(_label_progress, lv_color_white(), 0);
-    lv_obj_align(_label_progress, LV_ALIGN_CENTER, 0, 90);
+    lv_obj_add_style(_label_progress, &uiTheme.title, 0);
+    lv_obj_align(_label_progress, LV_ALIGN_CENTER, 0, 0);
+
+    // Flow rate over this dispense: highest and lowest rate per column
+    _chart_flow = lv_chart_create(_screen_dispensing);
+    lv_obj_set_size(_chart_flow, 600, 100);
+    lv_obj_align(_chart_flow, LV_ALIGN_CENTER, 0, 75);
+    lv_obj_add_style(_chart_flow, &uiTheme.panel, 0);
+    lv_obj_add_style(_chart_flow, &uiTheme.chart, 0);
+    lv_obj_add_style(_chart_flow, &uiTheme.chartSeries, LV_PART_ITEMS);
+    lv_obj_add_style(_chart_flow, &uiTheme.chartSeries, LV_PART_INDICATOR);
+    lv_chart_set_type(_chart_flow, LV_CHART_TYPE_LINE);
+    lv_chart_set_div_line_count(_chart_flow, 3, 0);
+    lv_chart_set_point_count(_chart_flow, FLOW_HISTORY_COLUMNS);
+    lv_chart_set_range(_chart_flow, LV_CHART_AXIS_PRIMARY_Y, 0, _flowRange);
+
+    for (uint16_t i = 0; i < FLOW_HISTORY_COLUMNS; i++) {
+        _flowMax[i] = LV_CHART_POINT_NONE;
+        _flowMin[i] = LV_CHART_POINT_NONE;
+    }
+    _ser_flow_max = lv_chart_add_series(_chart_flow, lv_color_hex(0x3498DB), LV_CHART_AXIS_PRIMARY_Y);
+    _ser_flow_min = lv_chart_add_series(_chart_flow, lv_color_hex(0x1F618D), LV_CHART_AXIS_PRIMARY_Y);
+    lv_chart_set_ext_y_array(_chart_flow, _ser_flow_max, _flowMax);
+    lv_chart_set_ext_y_array(_chart_flow, _ser_flow_min, _flowMin);
+
+    if (_flowChartTimer == nullptr) {
+        _flowChartTimer = lv_timer_create(flowChartTimerCallback, FLOW_CHART_REFRESH_INTERVAL, nullptr);
+    }
 
     // Pause button (left side, toggles to Resume)
     _btn_pause = lv_btn_create(_screen_dispensing);
     lv_obj_set_size(_btn_pause, 250, 70);
     lv_obj_align(_btn_pause, LV_ALIGN_BOTTOM_LEFT, 100, -30);
-    lv_obj_set_style_bg_color(_btn_pause, lv_color_hex(0xF39C12), 0);
+    lv_obj_add_style(_btn_pause, &uiTheme.btnWarning, 0);
     lv_obj_add_event_cb(_btn_pause, dispensingEventHandler, LV_EVENT_CLICKED, (void*)1);
     lv_obj_t* label_pause = lv_label_create(_btn_pause);
     lv_label_set_text(label_pause, "PAUSE");
-    lv_obj_set_style_text_font(label_pause, &lv_font_montserrat_24, 0);
+    lv_obj_add_style(label_pause, &uiTheme.textLarge, 0);
     lv_obj_center(label_pause);
 
     // Resume button (same position as pause, hidden initially)
     _btn_resume = lv_btn_create(_screen_dispensing);
     lv_obj_set_size(_btn_resume, 250, 70);
     lv_obj_align(_btn_resume, LV_ALIGN_BOTTOM_LEFT, 100, -30);
-    lv_obj_set_style_bg_color(_btn_resume, lv_color_hex(0x27AE60), 0);
+    lv_obj_add_style(_btn_resume, &uiTheme.btnPrimary, 0);
     lv_obj_add_event_cb(_btn_resume, dispensingEventHandler, LV_EVENT_CLICKED, (void*)2);
     lv_obj_t* label_resume = lv_label_create(_btn_resume);
     lv_label_set_text(label_resume, "RESUME");
-    lv_obj_set_style_text_font(label_resume, &lv_font_montserrat_24, 0);
+    lv_obj_add_style(label_resume, &uiTheme.textLarge, 0);
     lv_obj_center(label_resume);
     lv_obj_add_flag(_btn_resume, LV_OBJ_FLAG_HIDDEN);  // Hidden by default
 
@@ -465,11 +771,11 @@ void UIManager::createDispensingScreen() {
     _btn_stop = lv_btn_create(_screen_dispensing);
     lv_obj_set_size(_btn_stop, 250, 70);
     lv_obj_align(_btn_stop, LV_ALIGN_BOTTOM_RIGHT, -100, -30);
-    lv_obj_set_style_bg_color(_btn_stop, lv_color_hex(0xE74C3C), 0);
+    lv_obj_add_style(_btn_stop, &uiTheme.btnDanger, 0);
     lv_obj_add_event_cb(_btn_stop, dispensingEventHandler, LV_EVENT_CLICKED, (void*)3);
     lv_obj_t* label_stop = lv_label_create(_btn_stop);
     lv_label_set_text(label_stop, "STOP");
-    lv_obj_set_style_text_font(label_stop, &lv_font_montserrat_24, 0);
+    lv_obj_add_style(label_stop, &uiTheme.textLarge, 0);
     lv_obj_center(label_stop);
 }
 
@@ -485,30 +791,122 @@ void UIManager::dispensingEventHandler(lv_event_t* e) {
     } else if (action == 3) {
         // Stop
         hardwareControl.stopDispensing();
-        delay(500);  // Give time for valve to close
-        uiManager.showScreen(SCREEN_MAIN);
+        // Give time for valve to close
+        uiManager.scheduleScreen(SCREEN_MAIN, 500);
     }
 }
 
-void UIManager::updateDispensingScreen() {
-    float dispensed = hardwareControl.getDispensedAmount();
-    float target = hardwareControl.getTargetAmount();
-    uint8_t progress = hardwareControl.getProgress();
-    DispensingState state = hardwareControl.getState();
+void UIManager::flowChartTimerCallback(lv_timer_t* timer) {
+    if (uiManager._currentScreen == SCREEN_DISPENSING) {
+        uiManager.updateFlowChart();
+    }
+}
+
+// Copies new samples into the chart's arrays and invalidates only the
+// stretch of line that moved. lv_chart_set_value_by_id() would redraw the
+// whole chart for every point.
+void UIManager::updateFlowChart() {
+    uint32_t version = flowHistory.getVersion();
+    if (version == _flowVersion || _chart_flow == nullptr) return;
+    _flowVersion = version;
+
+    FlowColumn columns[FLOW_HISTORY_COLUMNS];
+    uint8_t count = flowHistory.copy(columns);
+
+    int16_t first = -1;
+    int16_t last = -1;
+    lv_coord_t peak = 0;
+    for (uint16_t i = 0; i < FLOW_HISTORY_COLUMNS; i++) {
+        lv_coord_t hi = i < count ? columns[i].maxTenths : LV_CHART_POINT_NONE;
+        lv_coord_t lo = i < count ? columns[i].minTenths : LV_CHART_POINT_NONE;
+        if (i < count && hi > peak) peak = hi;
+
+        if (hi != _flowMax[i] || lo != _flowMin[i]) {
+            _flowMax[i] = hi;
+            _flowMin[i] = lo;
+            if (first < 0) first = i;
+            last = i;
+        }
+    }
+
+    // Grow the range rather than clip; it starts over with each dispense
+    lv_coord_t range = FLOW_CHART_RANGE * 10;
+    while (peak > range) range *= 2;
+    if (range != _flowRange) {
+        _flowRange = range;
+        lv_chart_set_range(_chart_flow, LV_CHART_AXIS_PRIMARY_Y, 0, range);    // Redraws everything
+        return;
+    }
+    if (first < 0) return;
 
-    // Update labels
-    lv_label_set_text_fmt(_label_disp_amount, "%.1f ml", dispensed);
-    lv_label_set_text_fmt(_label_disp_target, "/ %.1f ml", target);
-    lv_label_set_text_fmt(_label_progress, "%d%%", progress);
+    // New dispense or columns merged: most of the chart moved anyway
+    if (last - first >= FLOW_HISTORY_COLUMNS / 2) {
+        lv_chart_refresh(_chart_flow);
+        return;
+    }
+
+    // A point moves the line segments on both sides of it; the margin covers
+    // the line width
+    const lv_coord_t margin = 4;
+    int16_t from = first > 0 ? first - 1 : 0;
+    int16_t to = last < FLOW_HISTORY_COLUMNS - 1 ? last + 1 : last;
+
+    lv_area_t content;
+    lv_obj_get_content_coords(_chart_flow, &content);
+    int32_t w = lv_area_get_width(&content);
+
+    lv_area_t dirty;
+    dirty.x1 = content.x1 + w * from / (FLOW_HISTORY_COLUMNS - 1) - margin;
+    dirty.x2 = content.x1 + w * to / (FLOW_HISTORY_COLUMNS - 1) + margin;
+    dirty.y1 = content.y1 - margin;
+    dirty.y2 = content.y2 + margin;
+    lv_obj_invalidate_area(_chart_flow, &dirty);
+}
 
-    // Update progress bar
-    lv_bar_set_value(_bar_progress, progress, LV_ANIM_ON);
+void UIManager::updateDispensingScreen(const UIMessage& msg) {
+    float dispensed = msg.dispense.dispensedML;
+    float target = msg.dispense.targetML;
+    uint8_t progress = msg.dispense.progress;
+    DispensingState state = msg.dispense.state;
+
+    // Same snapshot as last time: nothing to redraw
+    if (msg.dispense.version == _rendered.version) {
+        return;
+    }
+    _rendered.version = msg.dispense.version;
+
+    // Only touch widgets whose displayed value changes; every setter
+    // invalidates its area and lv_bar_set_value restarts the animation.
+    // The amount readout invalidates just the digit cells that changed.
+    int32_t dispensedTenths = lroundf(dispensed * 10);
+    if (dispensedTenths != _rendered.dispensedTenths) {
+        _digits_disp_amount.setValue(dispensedTenths);
+        _rendered.dispensedTenths = dispensedTenths;
+    }
+
+    int32_t targetTenths = lroundf(target * 10);
+    if (targetTenths != _rendered.targetTenths) {
+        lv_label_set_text_fmt(_label_disp_target, "/ %.1f ml", target);
+        _rendered.targetTenths = targetTenths;
+    }
+
+    if (progress != _rendered.progress) {
+        lv_label_set_text_fmt(_label_progress, "%d%%", progress);
+        lv_bar_set_value(_bar_progress, progress, LV_ANIM_ON);
+        _rendered.progress = progress;
+    }
+
+    if (state == _rendered.state) {
+        return;
+    }
+    _rendered.state = state;
 
     // Update title and button visibility based on state
     if (state == DISPENSING) {
         // Show pause button, stop button always visible
         lv_label_set_text(_label_disp_title, "Dispensing...");
-        lv_obj_set_style_text_color(_label_disp_title, lv_color_white(), 0);
+        // Back to the theme's white after "Paused"
+        lv_obj_remove_local_style_prop(_label_disp_title, LV_STYLE_TEXT_COLOR, 0);
         lv_obj_clear_flag(_btn_pause, LV_OBJ_FLAG_HIDDEN);
         lv_obj_add_flag(_btn_resume, LV_OBJ_FLAG_HIDDEN);
     } else if (state == PAUSED) {
@@ -523,13 +921,11 @@ void UIManager::updateDispensingScreen() {
     if (state == COMPLETED) {
         lv_label_set_text(_label_progress, "Complete!");
         lv_obj_set_style_text_color(_label_progress, lv_color_hex(0x27AE60), 0);
-        delay(2000);
-        uiManager.showScreen(SCREEN_MAIN);
+        scheduleScreen(SCREEN_MAIN, UI_RESULT_SCREEN_TIME);
     } else if (state == ERROR_TIMEOUT || state == ERROR_NO_FLOW) {
         lv_label_set_text(_label_progress, "Error!");
         lv_obj_set_style_text_color(_label_progress, lv_color_hex(0xE74C3C), 0);
-        delay(2000);
-        uiManager.showScreen(SCREEN_MAIN);
+        scheduleScreen(SCREEN_MAIN, UI_RESULT_SCREEN_TIME);
     }
 }
 
@@ -539,20 +935,19 @@ void UIManager::updateDispensingScreen() {
 
 void UIManager::createConfigScreen() {
     _screen_config = lv_obj_create(NULL);
-    lv_obj_set_style_bg_color(_screen_config, lv_color_hex(0x2C3E50), 0);
+    lv_obj_add_style(_screen_config, &uiTheme.screen, 0);
 
     // Title (fixed at top)
     lv_obj_t* title = lv_label_create(_screen_config);
     lv_label_set_text(title, "Settings");
-    lv_obj_set_style_text_font(title, &lv_font_montserrat_24, 0);
-    lv_obj_set_style_text_color(title, lv_color_white(), 0);
+    lv_obj_add_style(title, &uiTheme.title, 0);
     lv_obj_align(title, LV_ALIGN_TOP_MID, 0, 10);
 
     // Back button (fixed at bottom)
     _btn_config_back = lv_btn_create(_screen_config);
     lv_obj_set_size(_btn_config_back, 150, 50);
     lv_obj_align(_btn_config_back, LV_ALIGN_BOTTOM_MID, 0, -10);
-    lv_obj_set_style_bg_color(_btn_config_back, lv_color_hex(0x7F8C8D), 0);
+    lv_obj_add_style(_btn_config_back, &uiTheme.btnNeutral, 0);
     lv_obj_add_event_cb(_btn_config_back, configEventHandler, LV_EVENT_CLICKED, (void*)0);
     lv_obj_t* label_back = lv_label_create(_btn_config_back);
     lv_label_set_text(label_back, "Back");
@@ -562,24 +957,22 @@ void UIManager::createConfigScreen() {
     _config_scroll_container = lv_obj_create(_screen_config);
     lv_obj_set_size(_config_scroll_container, SCREEN_WIDTH - 20, SCREEN_HEIGHT - 130);
     lv_obj_align(_config_scroll_container, LV_ALIGN_TOP_MID, 0, 50);
-    lv_obj_set_style_bg_color(_config_scroll_container, lv_color_hex(0x34495E), 0);
+    lv_obj_add_style(_config_scroll_container, &uiTheme.panel, 0);
     lv_obj_set_flex_flow(_config_scroll_container, LV_FLEX_FLOW_COLUMN);
     lv_obj_set_flex_align(_config_scroll_container, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_START);
-    lv_obj_set_style_pad_all(_config_scroll_container, 15, 0);
-    lv_obj_set_style_pad_row(_config_scroll_container, 10, 0);
+    lv_obj_add_style(_config_scroll_container, &uiTheme.form, 0);
 
     int y_pos = 0;
 
     // ========== WiFi Section ==========
     lv_obj_t* wifi_section_title = lv_label_create(_config_scroll_container);
     lv_label_set_text(wifi_section_title, "WiFi Configuration");
-    lv_obj_set_style_text_font(wifi_section_title, &lv_font_montserrat_20, 0);
-    lv_obj_set_style_text_color(wifi_section_title, lv_color_hex(0x3498DB), 0);
+    lv_obj_add_style(wifi_section_title, &uiTheme.sectionTitle, 0);
 
     // WiFi SSID label and field
     lv_obj_t* label_ssid = lv_label_create(_config_scroll_container);
     lv_label_set_text(label_ssid, "WiFi SSID:");
-    lv_obj_set_style_text_color(label_ssid, lv_color_white(), 0);
+    lv_obj_add_style(label_ssid, &uiTheme.label, 0);
 
     _textarea_ssid = lv_textarea_create(_config_scroll_container);
     lv_obj_set_width(_textarea_ssid, SCREEN_WIDTH - 80);
@@ -591,7 +984,7 @@ void UIManager::createConfigScreen() {
     // Scan button
     _btn_wifi_scan = lv_btn_create(_config_scroll_container);
     lv_obj_set_size(_btn_wifi_scan, 200, 45);
-    lv_obj_set_style_bg_color(_btn_wifi_scan, lv_color_hex(0x3498DB), 0);
+    lv_obj_add_style(_btn_wifi_scan, &uiTheme.btnInfo, 0);
     lv_obj_add_event_cb(_btn_wifi_scan, configEventHandler, LV_EVENT_CLICKED, (void*)3);
     lv_obj_t* label_scan = lv_label_create(_btn_wifi_scan);
     lv_label_set_text(label_scan, "Scan Networks");
@@ -607,7 +1000,7 @@ void UIManager::createConfigScreen() {
     // WiFi Password label and field
     lv_obj_t* label_password = lv_label_create(_config_scroll_container);
     lv_label_set_text(label_password, "WiFi Password:");
-    lv_obj_set_style_text_color(label_password, lv_color_white(), 0);
+    lv_obj_add_style(label_password, &uiTheme.label, 0);
 
     _textarea_password = lv_textarea_create(_config_scroll_container);
     lv_obj_set_width(_textarea_password, SCREEN_WIDTH - 80);
@@ -620,14 +1013,12 @@ void UIManager::createConfigScreen() {
     // Connect button and status
     lv_obj_t* connect_container = lv_obj_create(_config_scroll_container);
     lv_obj_set_size(connect_container, SCREEN_WIDTH - 80, 60);
-    lv_obj_set_style_bg_opa(connect_container, LV_OPA_0, 0);
-    lv_obj_set_style_border_width(connect_container, 0, 0);
-    lv_obj_set_style_pad_all(connect_container, 0, 0);
+    lv_obj_add_style(connect_container, &uiTheme.transparent, 0);
 
     _btn_wifi_connect = lv_btn_create(connect_container);
     lv_obj_set_size(_btn_wifi_connect, 150, 50);
     lv_obj_align(_btn_wifi_connect, LV_ALIGN_LEFT_MID, 0, 0);
-    lv_obj_set_style_bg_color(_btn_wifi_connect, lv_color_hex(0x27AE60), 0);
+    lv_obj_add_style(_btn_wifi_connect, &uiTheme.btnPrimary, 0);
     lv_obj_add_event_cb(_btn_wifi_connect, configEventHandler, LV_EVENT_CLICKED, (void*)1);
     lv_obj_t* label_connect = lv_label_create(_btn_wifi_connect);
     lv_label_set_text(label_connect, "Connect");
@@ -635,7 +1026,7 @@ void UIManager::createConfigScreen() {
 
     _label_wifi_status = lv_label_create(connect_container);
     lv_label_set_text(_label_wifi_status, "Not connected");
-    lv_obj_set_style_text_color(_label_wifi_status, lv_color_hex(0x95A5A6), 0);
+    lv_obj_add_style(_label_wifi_status, &uiTheme.textMuted, 0);
     lv_obj_align(_label_wifi_status, LV_ALIGN_RIGHT_MID, 0, 0);
     lv_label_set_long_mode(_label_wifi_status, LV_LABEL_LONG_SCROLL_CIRCULAR);
     lv_obj_set_width(_label_wifi_status, 450);
@@ -643,13 +1034,12 @@ void UIManager::createConfigScreen() {
     // ========== Hostname Section ==========
     lv_obj_t* hostname_section_title = lv_label_create(_config_scroll_container);
     lv_label_set_text(hostname_section_title, "Network Hostname");
-    lv_obj_set_style_text_font(hostname_section_title, &lv_font_montserrat_20, 0);
-    lv_obj_set_style_text_color(hostname_section_title, lv_color_hex(0x3498DB), 0);
-    lv_obj_set_style_pad_top(hostname_section_title, 20, 0);
+    lv_obj_add_style(hostname_section_title, &uiTheme.sectionTitle, 0);
+    lv_obj_add_style(hostname_section_title, &uiTheme.sectionGap, 0);
 
     lv_obj_t* label_hostname = lv_label_create(_config_scroll_container);
     lv_label_set_text(label_hostname, "mDNS Hostname (device.local):");
-    lv_obj_set_style_text_color(label_hostname, lv_color_white(), 0);
+    lv_obj_add_style(label_hostname, &uiTheme.label, 0);
 
     _textarea_hostname = lv_textarea_create(_config_scroll_container);
     lv_obj_set_width(_textarea_hostname, SCREEN_WIDTH - 80);
@@ -662,13 +1052,12 @@ void UIManager::createConfigScreen() {
     // ========== OTA Security Section ==========
     lv_obj_t* ota_section_title = lv_label_create(_config_scroll_container);
     lv_label_set_text(ota_section_title, "OTA Update Security");
-    lv_obj_set_style_text_font(ota_section_title, &lv_font_montserrat_20, 0);
-    lv_obj_set_style_text_color(ota_section_title, lv_color_hex(0x3498DB), 0);
-    lv_obj_set_style_pad_top(ota_section_title, 20, 0);
+    lv_obj_add_style(ota_section_title, &uiTheme.sectionTitle, 0);
+    lv_obj_add_style(ota_section_title, &uiTheme.sectionGap, 0);
 
     lv_obj_t* label_ota_password = lv_label_create(_config_scroll_container);
     lv_label_set_text(label_ota_password, "OTA Password (optional, leave empty to disable):");
-    lv_obj_set_style_text_color(label_ota_password, lv_color_white(), 0);
+    lv_obj_add_style(label_ota_password, &uiTheme.label, 0);
 
     _textarea_ota_password = lv_textarea_create(_config_scroll_container);
     lv_obj_set_width(_textarea_ota_password, SCREEN_WIDTH - 80);
@@ -682,13 +1071,12 @@ void UIManager::createConfigScreen() {
     // ========== Volume Configuration Section ==========
     lv_obj_t* volume_section_title = lv_label_create(_config_scroll_container);
     lv_label_set_text(volume_section_title, "Volume Configuration");
-    lv_obj_set_style_text_font(volume_section_title, &lv_font_montserrat_20, 0);
-    lv_obj_set_style_text_color(volume_section_title, lv_color_hex(0x3498DB), 0);
-    lv_obj_set_style_pad_top(volume_section_title, 20, 0);
+    lv_obj_add_style(volume_section_title, &uiTheme.sectionTitle, 0);
+    lv_obj_add_style(volume_section_title, &uiTheme.sectionGap, 0);
 
     lv_obj_t* label_unit = lv_label_create(_config_scroll_container);
     lv_label_set_text(label_unit, "Display Unit:");
-    lv_obj_set_style_text_color(label_unit, lv_color_white(), 0);
+    lv_obj_add_style(label_unit, &uiTheme.label, 0);
 
     _dropdown_unit = lv_dropdown_create(_config_scroll_container);
     lv_obj_set_width(_dropdown_unit, SCREEN_WIDTH - 80);
@@ -698,13 +1086,13 @@ void UIManager::createConfigScreen() {
     // Preset volumes
     lv_obj_t* label_presets = lv_label_create(_config_scroll_container);
     lv_label_set_text(label_presets, "Quick Dispense Presets:");
-    lv_obj_set_style_text_color(label_presets, lv_color_white(), 0);
-    lv_obj_set_style_pad_top(label_presets, 10, 0);
+    lv_obj_add_style(label_presets, &uiTheme.label, 0);
+    lv_obj_add_style(label_presets, &uiTheme.subsectionGap, 0);
 
     // Preset 1
     _label_preset1 = lv_label_create(_config_scroll_container);
     lv_label_set_text(_label_preset1, "Preset 1 (ml):");
-    lv_obj_set_style_text_color(_label_preset1, lv_color_white(), 0);
+    lv_obj_add_style(_label_preset1, &uiTheme.label, 0);
 
     _textarea_preset1 = lv_textarea_create(_config_scroll_container);
     lv_obj_set_width(_textarea_preset1, SCREEN_WIDTH - 80);
@@ -717,7 +1105,7 @@ void UIManager::createConfigScreen() {
     // Preset 2
     _label_preset2 = lv_label_create(_config_scroll_container);
     lv_label_set_text(_label_preset2, "Preset 2 (ml):");
-    lv_obj_set_style_text_color(_label_preset2, lv_color_white(), 0);
+    lv_obj_add_style(_label_preset2, &uiTheme.label, 0);
 
     _textarea_preset2 = lv_textarea_create(_config_scroll_container);
     lv_obj_set_width(_textarea_preset2, SCREEN_WIDTH - 80);
@@ -730,7 +1118,7 @@ void UIManager::createConfigScreen() {
     // Preset 3
     _label_preset3 = lv_label_create(_config_scroll_container);
     lv_label_set_text(_label_preset3, "Preset 3 (ml):");
-    lv_obj_set_style_text_color(_label_preset3, lv_color_white(), 0);
+    lv_obj_add_style(_label_preset3, &uiTheme.label, 0);
 
     _textarea_preset3 = lv_textarea_create(_config_scroll_container);
     lv_obj_set_width(_textarea_preset3, SCREEN_WIDTH - 80);
@@ -743,7 +1131,7 @@ void UIManager::createConfigScreen() {
     // Preset 4
     _label_preset4 = lv_label_create(_config_scroll_container);
     lv_label_set_text(_label_preset4, "Preset 4 (ml):");
-    lv_obj_set_style_text_color(_label_preset4, lv_color_white(), 0);
+    lv_obj_add_style(_label_preset4, &uiTheme.label, 0);
 
     _textarea_preset4 = lv_textarea_create(_config_scroll_container);
     lv_obj_set_width(_textarea_preset4, SCREEN_WIDTH - 80);
@@ -756,13 +1144,12 @@ void UIManager::createConfigScreen() {
     // ========== Calibration Section ==========
     lv_obj_t* calib_section_title = lv_label_create(_config_scroll_container);
     lv_label_set_text(calib_section_title, "Flow Sensor Calibration");
-    lv_obj_set_style_text_font(calib_section_title, &lv_font_montserrat_20, 0);
-    lv_obj_set_style_text_color(calib_section_title, lv_color_hex(0x3498DB), 0);
-    lv_obj_set_style_pad_top(calib_section_title, 20, 0);
+    lv_obj_add_style(calib_section_title, &uiTheme.sectionTitle, 0);
+    lv_obj_add_style(calib_section_title, &uiTheme.sectionGap, 0);
 
     lv_obj_t* label_pulses = lv_label_create(_config_scroll_container);
     lv_label_set_text(label_pulses, "Pulses per Liter:");
-    lv_obj_set_style_text_color(label_pulses, lv_color_white(), 0);
+    lv_obj_add_style(label_pulses, &uiTheme.label, 0);
 
     _textarea_pulses_per_liter = lv_textarea_create(_config_scroll_container);
     lv_obj_set_width(_textarea_pulses_per_liter, SCREEN_WIDTH - 80);
@@ -773,7 +1160,7 @@ void UIManager::createConfigScreen() {
 
     _btn_calibrate = lv_btn_create(_config_scroll_container);
     lv_obj_set_size(_btn_calibrate, 250, 50);
-    lv_obj_set_style_bg_color(_btn_calibrate, lv_color_hex(0xE67E22), 0);
+    lv_obj_add_style(_btn_calibrate, &uiTheme.btnAccent, 0);
     lv_obj_add_event_cb(_btn_calibrate, configEventHandler, LV_EVENT_CLICKED, (void*)2);
     lv_obj_t* label_calibrate = lv_label_create(_btn_calibrate);
     lv_label_set_text(label_calibrate, "Run Calibration");
@@ -788,15 +1175,15 @@ void UIManager::createConfigScreen() {
     // Add event handler for keyboard ready/ok button
     lv_obj_add_event_cb(_keyboard_config, [](lv_event_t* e) {
         lv_event_code_t code = lv_event_get_code(e);
-        Serial.printf("Keyboard event %d\n", code);
+        LOG_DEBUG("Keyboard event %d", code);
 
         if (code == LV_EVENT_READY) {
-            Serial.println("Getting text area");
+            LOG_DEBUG("Getting text area");
             // User pressed OK/checkmark - defocus the textarea to hide keyboard
             lv_obj_t* textarea = lv_keyboard_get_textarea(uiManager._keyboard_config);
             
             if (textarea) {                
-                Serial.println("Textarea not null");
+                LOG_DEBUG("Textarea not null");
                 lv_obj_clear_state(textarea, LV_STATE_FOCUSED | LV_STATE_FOCUS_KEY);
             }
         }
@@ -836,50 +1223,56 @@ void UIManager::createConfigScreen() {
     updatePresetLabelsAndValues(unit);
 }
 
-void UIManager::configEventHandler(lv_event_t* e) {
-    int action = (int)lv_event_get_user_data(e);
+// Persist the config screen's fields (leaving by Back or by swipe)
+void UIManager::saveConfigScreen() {
+    const char* pulsesText = lv_textarea_get_text(_textarea_pulses_per_liter);
+    float pulsesPerLiter = atof(pulsesText);
+    if (pulsesPerLiter > 0) {
+        Preferences prefs;
+        if (prefs.begin(PREFS_NAMESPACE, false)) {
+            prefs.putFloat("pulses_per_l", pulsesPerLiter);
 
-    if (action == 0) {
-        // Back - save pulses per liter, volume settings, and OTA password before leaving
-        const char* pulsesText = lv_textarea_get_text(uiManager._textarea_pulses_per_liter);
-        float pulsesPerLiter = atof(pulsesText);
-        if (pulsesPerLiter > 0) {
-            Preferences prefs;
-            if (prefs.begin(PREFS_NAMESPACE, false)) {
-                prefs.putFloat("pulses_per_l", pulsesPerLiter);
+            // Save OTA password
+            const char* otaPassword = lv_textarea_get_text(_textarea_ota_password);
+            prefs.putString("ota_password", otaPassword);
 
-                // Save OTA password
-                const char* otaPassword = lv_textarea_get_text(uiManager._textarea_ota_password);
-                prefs.putString("ota_password", otaPassword);
+            // Save volume settings
+            VolumeUnitType unitType = (VolumeUnitType)lv_dropdown_get_selected(_dropdown_unit);
+            prefs.putInt("volume_unit", unitType);
 
-                // Save volume settings
-                VolumeUnitType unitType = (VolumeUnitType)lv_dropdown_get_selected(uiManager._dropdown_unit);
-                prefs.putInt("volume_unit", unitType);
-
-                // Get volume unit for conversion
-                const VolumeUnit* unit = getVolumeUnit(unitType);
-
-                // Read preset values and convert to ml for storage
-                const char* preset1_text = lv_textarea_get_text(uiManager._textarea_preset1);
-                const char* preset2_text = lv_textarea_get_text(uiManager._textarea_preset2);
-                const char* preset3_text = lv_textarea_get_text(uiManager._textarea_preset3);
-                const char* preset4_text = lv_textarea_get_text(uiManager._textarea_preset4);
+            // Get volume unit for conversion
+            const VolumeUnit* unit = getVolumeUnit(unitType);
 
-                // Use unit->toMilliliters() for conversion
-                int preset1_ml = unit->toMilliliters(atof(preset1_text));
-                int preset2_ml = unit->toMilliliters(atof(preset2_text));
-                int preset3_ml = unit->toMilliliters(atof(preset3_text));
-                int preset4_ml = unit->toMilliliters(atof(preset4_text));
+            // Read preset values and convert to ml for storage
+            const char* preset1_text = lv_textarea_get_text(_textarea_preset1);
+            const char* preset2_text = lv_textarea_get_text(_textarea_preset2);
+            const char* preset3_text = lv_textarea_get_text(_textarea_preset3);
+            const char* preset4_text = lv_textarea_get_text(_textarea_preset4);
+
+            // Use unit->toMilliliters() for conversion
+            int preset1_ml = unit->toMilliliters(atof(preset1_text));
+            int preset2_ml = unit->toMilliliters(atof(preset2_text));
+            int preset3_ml = unit->toMilliliters(atof(preset3_text));
+            int preset4_ml = unit->toMilliliters(atof(preset4_text));
+
+            prefs.putInt("preset1_ml", preset1_ml);
+            prefs.putInt("preset2_ml", preset2_ml);
+            prefs.putInt("preset3_ml", preset3_ml);
+            prefs.putInt("preset4_ml", preset4_ml);
+
+            prefs.end();
+            metrics.nvsWrites.inc(7);
+        }
+        hardwareControl.setCalibrationFactor(pulsesPerLiter);
+    }
+}
 
-                prefs.putInt("preset1_ml", preset1_ml);
-                prefs.putInt("preset2_ml", preset2_ml);
-                prefs.putInt("preset3_ml", preset3_ml);
-                prefs.putInt("preset4_ml", preset4_ml);
+void UIManager::configEventHandler(lv_event_t* e) {
+    int action = (int)lv_event_get_user_data(e);
 
-                prefs.end();
-            }
-            hardwareControl.setCalibrationFactor(pulsesPerLiter);
-        }
+    if (action == 0) {
+        // Back - save pulses per liter, volume settings, and OTA password before leaving
+        uiManager.saveConfigScreen();
         uiManager.showScreen(SCREEN_MAIN);
     } else if (action == 1) {
         // WiFi Connect
@@ -890,40 +1283,17 @@ void UIManager::configEventHandler(lv_event_t* e) {
         lv_label_set_text(uiManager._label_wifi_status, "Connecting...");
         lv_obj_set_style_text_color(uiManager._label_wifi_status, lv_color_hex(0xF39C12), 0);
 
-        WiFi.begin(ssid, password);
-
-        unsigned long start = millis();
-        while (WiFi.status() != WL_CONNECTED && millis() - start < WIFI_TIMEOUT) {
-            delay(100);
-            lv_timer_handler();
-        }
+        // Keep copies: the textareas may be edited while we wait
+        uiManager._pendingSsid = ssid;
+        uiManager._pendingPassword = password;
+        uiManager._pendingHostname = hostname;
 
-        if (WiFi.status() == WL_CONNECTED) {
-            // Save credentials and hostname
-            Preferences prefs;
-            if (prefs.begin(PREFS_NAMESPACE, false)) {
-                prefs.putString("wifi_ssid", ssid);
-                prefs.putString("wifi_pass", password);
-
-                // Save and apply hostname
-                String hostnameStr = String(hostname);
-                if (hostnameStr.length() > 0 && hostnameStr.length() <= 63) {
-                    prefs.putString("mdns_hostname", hostnameStr);
-
-                    // Restart mDNS with new hostname
-                    MDNS.end();
-                    if (MDNS.begin(hostnameStr.c_str())) {
-                        MDNS.addService("http", "tcp", 80);
-                    }
-                }
-                prefs.end();
-            }
+        wifiService.connect(ssid, password);
 
-            lv_label_set_text_fmt(uiManager._label_wifi_status, "Connected! %s.local",hostname);
-            lv_obj_set_style_text_color(uiManager._label_wifi_status, lv_color_hex(0x27AE60), 0);
-        } else {
-            lv_label_set_text(uiManager._label_wifi_status, "Failed!");
-            lv_obj_set_style_text_color(uiManager._label_wifi_status, lv_color_hex(0xE74C3C), 0);
+        // Poll from an lv_timer instead of blocking the UI for up to WIFI_TIMEOUT
+        uiManager._wifiConnectStart = millis();
+        if (uiManager._wifiConnectTimer == nullptr) {
+            uiManager._wifiConnectTimer = lv_timer_create(wifiConnectTimerCallback, WIFI_CONNECT_POLL_INTERVAL, nullptr);
         }
     } else if (action == 2) {
         // Calibration - save current pulses per liter first
@@ -934,33 +1304,19 @@ void UIManager::configEventHandler(lv_event_t* e) {
             if (prefs.begin(PREFS_NAMESPACE, false)) {
                 prefs.putFloat("pulses_per_l", pulsesPerLiter);
                 prefs.end();
+                metrics.nvsWrites.inc();
             }
             hardwareControl.setCalibrationFactor(pulsesPerLiter);
         }
         uiManager.showScreen(SCREEN_CALIBRATION);
     } else if (action == 3) {
         // WiFi Scan
-        lv_label_set_text(lv_obj_get_child(uiManager._btn_wifi_scan, 0), "Scanning...");
-        lv_timer_handler();
-
-        int n = WiFi.scanNetworks();
-
-        if (n > 0) {
-            String options = "";
-            for (int i = 0; i < n; i++) {
-                if (i > 0) options += "\n";
-                options += WiFi.SSID(i);
-                options += " (";
-                options += WiFi.RSSI(i);
-                options += " dBm)";
-            }
-            lv_dropdown_set_options(uiManager._dropdown_ssid, options.c_str());
-            lv_obj_clear_flag(uiManager._dropdown_ssid, LV_OBJ_FLAG_HIDDEN);
-            lv_label_set_text(lv_obj_get_child(uiManager._btn_wifi_scan, 0), "Scan Again");
+        // Runs in the background; results arrive as UI_MSG_WIFI_SCAN_DONE
+        if (wifiService.startScan()) {
+            lv_label_set_text(lv_obj_get_child(uiManager._btn_wifi_scan, 0), "Scanning...");
         } else {
-            lv_label_set_text(lv_obj_get_child(uiManager._btn_wifi_scan, 0), "No networks found");
-            delay(2000);
-            lv_label_set_text(lv_obj_get_child(uiManager._btn_wifi_scan, 0), "Scan Networks");
+            lv_label_set_text(lv_obj_get_child(uiManager._btn_wifi_scan, 0), "Busy, try again");
+            uiManager.resetScanButtonLater();
         }
     } else if (action == 4) {
         // Dropdown selection changed
@@ -992,16 +1348,15 @@ void UIManager::configEventHandler(lv_event_t* e) {
 void UIManager::createCalibrationScreen() {
     _screen_calibration = lv_obj_create(NULL);
     if (_screen_calibration == NULL) {
-        Serial.println("ERROR: Failed to create calibration screen!");
+        LOG_ERROR("Failed to create calibration screen!");
         return;
     }
-    lv_obj_set_style_bg_color(_screen_calibration, lv_color_hex(0x2C3E50), 0);
+    lv_obj_add_style(_screen_calibration, &uiTheme.screen, 0);
 
     // Title
     lv_obj_t* title = lv_label_create(_screen_calibration);
     lv_label_set_text(title, "Flow Sensor Calibration");
-    lv_obj_set_style_text_font(title, &lv_font_montserrat_24, 0);
-    lv_obj_set_style_text_color(title, lv_color_white(), 0);
+    lv_obj_add_style(title, &uiTheme.title, 0);
     lv_obj_align(title, LV_ALIGN_TOP_MID, 0, 20);
 
     // Instructions
@@ -1011,13 +1366,13 @@ void UIManager::createCalibrationScreen() {
         "2. Press Start\n"
         "3. Dispense that volume\n"
         "4. Press Save");
-    lv_obj_set_style_text_color(_label_calib_instructions, lv_color_white(), 0);
+    lv_obj_add_style(_label_calib_instructions, &uiTheme.label, 0);
     lv_obj_align(_label_calib_instructions, LV_ALIGN_TOP_LEFT, 50, 80);
 
     // Volume input
     lv_obj_t* label_vol = lv_label_create(_screen_calibration);
     lv_label_set_text(label_vol, "Known Volume (ml):");
-    lv_obj_set_style_text_color(label_vol, lv_color_white(), 0);
+    lv_obj_add_style(label_vol, &uiTheme.label, 0);
     lv_obj_align(label_vol, LV_ALIGN_TOP_LEFT, 50, 200);
 
     _textarea_calib_volume = lv_textarea_create(_screen_calibration);
@@ -1029,15 +1384,14 @@ void UIManager::createCalibrationScreen() {
     // Pulse count label
     _label_calib_pulses = lv_label_create(_screen_calibration);
     lv_label_set_text(_label_calib_pulses, "Pulses: 0");
-    lv_obj_set_style_text_font(_label_calib_pulses, &lv_font_montserrat_24, 0);
-    lv_obj_set_style_text_color(_label_calib_pulses, lv_color_hex(0x3498DB), 0);
+    lv_obj_add_style(_label_calib_pulses, &uiTheme.value, 0);
     lv_obj_align(_label_calib_pulses, LV_ALIGN_CENTER, 0, 0);
 
     // Start button
     _btn_calib_start = lv_btn_create(_screen_calibration);
     lv_obj_set_size(_btn_calib_start, 200, 60);
     lv_obj_align(_btn_calib_start, LV_ALIGN_BOTTOM_LEFT, 50, -30);
-    lv_obj_set_style_bg_color(_btn_calib_start, lv_color_hex(0x27AE60), 0);
+    lv_obj_add_style(_btn_calib_start, &uiTheme.btnPrimary, 0);
     lv_obj_add_event_cb(_btn_calib_start, calibrationEventHandler, LV_EVENT_CLICKED, (void*)1);
     lv_obj_t* label_start = lv_label_create(_btn_calib_start);
     lv_label_set_text(label_start, "Start");
@@ -1047,7 +1401,7 @@ void UIManager::createCalibrationScreen() {
     _btn_calib_save = lv_btn_create(_screen_calibration);
     lv_obj_set_size(_btn_calib_save, 200, 60);
     lv_obj_align(_btn_calib_save, LV_ALIGN_BOTTOM_MID, 0, -30);
-    lv_obj_set_style_bg_color(_btn_calib_save, lv_color_hex(0x3498DB), 0);
+    lv_obj_add_style(_btn_calib_save, &uiTheme.btnInfo, 0);
     lv_obj_add_event_cb(_btn_calib_save, calibrationEventHandler, LV_EVENT_CLICKED, (void*)2);
     lv_obj_t* label_save = lv_label_create(_btn_calib_save);
     lv_label_set_text(label_save, "Save");
@@ -1057,13 +1411,93 @@ void UIManager::createCalibrationScreen() {
     _btn_calib_cancel = lv_btn_create(_screen_calibration);
     lv_obj_set_size(_btn_calib_cancel, 200, 60);
     lv_obj_align(_btn_calib_cancel, LV_ALIGN_BOTTOM_RIGHT, -50, -30);
-    lv_obj_set_style_bg_color(_btn_calib_cancel, lv_color_hex(0xE74C3C), 0);
+    lv_obj_add_style(_btn_calib_cancel, &uiTheme.btnDanger, 0);
     lv_obj_add_event_cb(_btn_calib_cancel, calibrationEventHandler, LV_EVENT_CLICKED, (void*)0);
     lv_obj_t* label_cancel = lv_label_create(_btn_calib_cancel);
     lv_label_set_text(label_cancel, "Cancel");
     lv_obj_center(label_cancel);
 }
 
+void UIManager::showScanResults(bool scanFinished) {
+    if (_screen_config == nullptr) return;     // Shown from the cache on next visit
+
+    WiFiScanEntry entries[WIFI_SCAN_MAX_RESULTS];
+    uint8_t count = wifiService.getScanResults(entries, WIFI_SCAN_MAX_RESULTS);
+
+    if (count > 0) {
+        String options = "";
+        for (uint8_t i = 0; i < count; i++) {
+            if (i > 0) options += "\n";
+            options += entries[i].ssid;
+            options += " (";
+            options += entries[i].rssi;
+            options += " dBm)";
+        }
+        lv_dropdown_set_options(_dropdown_ssid, options.c_str());
+        lv_obj_clear_flag(_dropdown_ssid, LV_OBJ_FLAG_HIDDEN);
+        lv_label_set_text(lv_obj_get_child(_btn_wifi_scan, 0), "Scan Again");
+    } else if (scanFinished) {
+        lv_label_set_text(lv_obj_get_child(_btn_wifi_scan, 0), "No networks found");
+        resetScanButtonLater();
+    }
+}
+
+void UIManager::resetScanButtonLater() {
+    lv_timer_t* reset = lv_timer_create([](lv_timer_t* timer) {
+        if (uiManager._screen_config == nullptr) return;
+        lv_label_set_text(lv_obj_get_child(uiManager._btn_wifi_scan, 0), "Scan Networks");
+    }, UI_RESULT_SCREEN_TIME, nullptr);
+    lv_timer_set_repeat_count(reset, 1);
+}
+
+void UIManager::wifiConnectTimerCallback(lv_timer_t* timer) {
+    if (WiFi.status() == WL_CONNECTED) {
+        uiManager.finishWifiConnect(true);
+    } else if (millis() - uiManager._wifiConnectStart >= WIFI_TIMEOUT) {
+        uiManager.finishWifiConnect(false);
+    }
+}
+
+void UIManager::finishWifiConnect(bool connected) {
+    lv_timer_del(_wifiConnectTimer);
+    _wifiConnectTimer = nullptr;
+
+    if (connected) {
+        // Save credentials and hostname
+        Preferences prefs;
+        if (prefs.begin(PREFS_NAMESPACE, false)) {
+            prefs.putString("wifi_ssid", _pendingSsid);
+            prefs.putString("wifi_pass", _pendingPassword);
+            metrics.nvsWrites.inc(2);
+
+            // Save and apply hostname
+            if (_pendingHostname.length() > 0 && _pendingHostname.length() <= 63) {
+                prefs.putString("mdns_hostname", _pendingHostname);
+                metrics.nvsWrites.inc();
+
+                // Restart mDNS with new hostname
+                MDNS.end();
+                if (MDNS.begin(_pendingHostname.c_str())) {
+                    MDNS.addService("http", "tcp", 80);
+                }
+            }
+            prefs.end();
+        }
+    }
+    _pendingPassword = "";
+
+    // The config screen may have been left (and freed) meanwhile
+    if (_screen_config == nullptr) return;
+
+    if (connected) {
+        lv_label_set_text_fmt(_label_wifi_status, "Connected! %s.local", _pendingHostname.c_str());
+        lv_obj_set_style_text_color(_label_wifi_status, lv_color_hex(0x27AE60), 0);
+    } else {
+        lv_label_set_text(_label_wifi_status, "Failed!");
+        lv_obj_set_style_text_color(_label_wifi_status, lv_color_hex(0xE74C3C), 0);
+    }
+}
+
 void UIManager::calibrationEventHandler(lv_event_t* e) {
     int action = (int)lv_event_get_user_data(e);
     static uint32_t startPulses = 0;
@@ -1096,8 +1530,7 @@ void UIManager::calibrationEventHandler(lv_event_t* e) {
         lv_label_set_text_fmt(uiManager._label_calib_instructions,
             "Saved!\nNew factor: %.2f pulses/L", newFactor);
 
-        delay(2000);
-        uiManager.showScreen(SCREEN_CONFIG);
+        uiManager.scheduleScreen(SCREEN_CONFIG, UI_RESULT_SCREEN_TIME);
     }
 
     // Update pulse count display
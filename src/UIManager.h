@@ -2,24 +2,98 @@
 #define UI_MANAGER_H
 
 #include <lvgl.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
 #include "VolumeUnit.h"
+#include "HardwareControl.h"
+#include "Metrics.h"
+#include "Gesture.h"
+#include "FlowHistory.h"
+#include "BigDigits.h"
 
 enum UIScreen {
     SCREEN_MAIN,
     SCREEN_KEYPAD,
     SCREEN_DISPENSING,
     SCREEN_CONFIG,
-    SCREEN_CALIBRATION
+    SCREEN_CALIBRATION,
+    SCREEN_COUNT
+};
+
+// What happens to a screen's LVGL objects once it is no longer shown
+enum ScreenLifetime : uint8_t {
+    LIFETIME_PERSISTENT,        // Built at boot, never freed
+    LIFETIME_CACHED,            // Built on first use, then kept
+    LIFETIME_DESTROY_ON_LEAVE   // Built on every visit, freed on leave; restored from Preferences
+};
+
+struct ScreenStats {
+    uint32_t buildUs;       // Last build time
+    int32_t heapBytes;      // Heap taken by the last build
+    uint16_t builds;
+};
+
+// Updates other tasks hand to the UI; applied by the LVGL task
+enum UIMessageType : uint8_t {
+    UI_MSG_DISPENSE_STATUS,
+    UI_MSG_WIFI_STATUS,
+    UI_MSG_SHOW_SCREEN,
+    UI_MSG_WIFI_SCAN_DONE,  // Results are read from wifiService's cache
+    UI_MSG_GESTURE
+};
+
+struct UIMessage {
+    UIMessageType type;
+    union {
+        struct {
+            uint32_t version;       // Bumped whenever the visible values change
+            float dispensedML;
+            float targetML;
+            uint8_t progress;
+            DispensingState state;
+        } dispense;
+        struct {
+            bool connected;
+        } wifi;
+        struct {
+            UIScreen screen;
+        } show;
+        Gesture gesture;
+    };
 };
 
 class UIManager {
 public:
     UIManager();
     void begin();
-    void update();
     void showScreen(UIScreen screen);
     UIScreen getCurrentScreen();
 
+    // Switch to 'screen' after delayMs without blocking (result screens).
+    // Any showScreen() before then cancels the pending switch.
+    void scheduleScreen(UIScreen screen, uint32_t delayMs);
+
+    // Thread-safe: queue an update for the LVGL task. Never blocks; returns
+    // false when the queue is full.
+    bool post(const UIMessage& msg);
+    void postWifiStatus(bool connected);
+    void postShowScreen(UIScreen screen);
+    void postGesture(const Gesture& gesture);
+
+    // Called by the control loop after HardwareControl::update(). Posts on
+    // state changes and at most every UI_STATUS_POST_INTERVAL ms otherwise.
+    void postDispenseStatus();
+
+    // LVGL task only: apply all queued messages
+    void processMessages();
+
+    // True while the current screen shows live values (keep refresh rate high)
+    bool wantsFastRefresh();
+
+    // Time spent building screens in begin() and heap in use after it
+    uint32_t getBootBuildUs() const { return _bootBuildUs; }
+    int32_t getBootHeapBytes() const { return _bootHeapBytes; }
+
 private:
     lv_obj_t* _screen_main;
     lv_obj_t* _screen_keypad;
@@ -29,6 +103,55 @@ private:
 
     UIScreen _currentScreen;
 
+    QueueHandle_t _queue;
+    bool _wifiConnected;
+
+    // Dispensing values as last posted (control loop) and as last drawn
+    // (LVGL task); widgets are only touched when their value differs
+    struct DispenseView {
+        uint32_t version;
+        int32_t dispensedTenths;
+        int32_t targetTenths;
+        uint8_t progress;
+        DispensingState state;
+    };
+    DispenseView _posted;
+    DispenseView _rendered;
+    unsigned long _lastStatusPost;
+
+    void invalidateDispenseView();
+
+    // Pending timed screen switch
+    lv_timer_t* _screenTimer;
+    UIScreen _scheduledScreen;
+
+    // WiFi connect started from the config screen, polled by _wifiConnectTimer
+    lv_timer_t* _wifiConnectTimer;
+    unsigned long _wifiConnectStart;
+    String _pendingSsid;
+    String _pendingPassword;
+    String _pendingHostname;
+
+    // Screen lifetimes
+    ScreenStats _screenStats[SCREEN_COUNT];
+    uint32_t _bootBuildUs;
+    int32_t _bootHeapBytes;
+
+    static ScreenLifetime lifetimeOf(UIScreen screen);
+    lv_obj_t*& screenObject(UIScreen screen);
+    void ensureScreen(UIScreen screen);
+    void releaseScreen(UIScreen screen);
+    static void collect(PrometheusWriter& writer);
+
+    void cancelScheduledScreen();
+    void handleGesture(const Gesture& gesture);
+    void saveConfigScreen();
+    void finishWifiConnect(bool connected);
+    void showScanResults(bool scanFinished);
+    void resetScanButtonLater();
+    static void screenTimerCallback(lv_timer_t* timer);
+    static void wifiConnectTimerCallback(lv_timer_t* timer);
+
     // Main screen elements
     lv_obj_t* _btn_preset1;
     lv_obj_t* _btn_preset2;
@@ -50,13 +173,24 @@ private:
 
     // Dispensing screen elements
     lv_obj_t* _label_disp_title;
-    lv_obj_t* _label_disp_amount;
+    BigDigits _digits_disp_amount;     // ml x 10
+    lv_obj_t* _label_disp_unit;
     lv_obj_t* _label_disp_target;
     lv_obj_t* _bar_progress;
     lv_obj_t* _label_progress;
     lv_obj_t* _btn_pause;
     lv_obj_t* _btn_resume;
     lv_obj_t* _btn_stop;
+    lv_obj_t* _chart_flow;
+    lv_chart_series_t* _ser_flow_max;
+    lv_chart_series_t* _ser_flow_min;
+
+    // Flow chart points (ml/s x 10), handed to the chart as external arrays
+    lv_coord_t _flowMax[FLOW_HISTORY_COLUMNS];
+    lv_coord_t _flowMin[FLOW_HISTORY_COLUMNS];
+    lv_coord_t _flowRange;
+    uint32_t _flowVersion;
+    lv_timer_t* _flowChartTimer;
 
     // Config screen elements
     lv_obj_t* _config_scroll_container;
@@ -101,13 +235,14 @@ private:
     static void mainScreenEventHandler(lv_event_t* e);
     static void keypadEventHandler(lv_event_t* e);
     static void dispensingEventHandler(lv_event_t* e);
+    static void flowChartTimerCallback(lv_timer_t* timer);
     static void configEventHandler(lv_event_t* e);
     static void calibrationEventHandler(lv_event_t* e);
     static void textareaEventHandler(lv_event_t* e);
 
     // Helper methods
-    void updateDispensingScreen();
-    void updateMainStatus();
+    void updateDispensingScreen(const UIMessage& msg);
+    void updateFlowChart();
     void updateWifiStatus();
     void updatePresetLabelsAndValues(const VolumeUnit* unit);
 };
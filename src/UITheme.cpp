@@ -0,0 +1,150 @@
+#include "UITheme.h"
+#include "LvglTask.h"
+#include "config.h"
+#include <ArduinoJson.h>
+
+// Global instance
+UITheme uiTheme;
+
+// Properties resolved for a typical object while drawing it
+static const lv_style_prop_t lookupProps[] = {
+    LV_STYLE_BG_COLOR, LV_STYLE_BG_OPA, LV_STYLE_RADIUS, LV_STYLE_BORDER_WIDTH,
+    LV_STYLE_PAD_TOP, LV_STYLE_TEXT_COLOR, LV_STYLE_TEXT_FONT, LV_STYLE_TEXT_OPA
+};
+
+// Keeps the lookups from being optimised away
+static volatile int32_t lookupSink;
+
+UITheme::UITheme() {
+    _initialized = false;
+}
+
+static void initBackground(lv_style_t* style, uint32_t color) {
+    lv_style_init(style);
+    lv_style_set_bg_color(style, lv_color_hex(color));
+}
+
+void UITheme::begin() {
+    if (_initialized) return;
+    _initialized = true;
+
+    initBackground(&screen, 0x2C3E50);
+    initBackground(&panel, 0x34495E);
+
+    lv_style_init(&form);
+    lv_style_set_pad_all(&form, 15);
+    lv_style_set_pad_row(&form, 10);
+
+    lv_style_init(&transparent);
+    lv_style_set_bg_opa(&transparent, LV_OPA_0);
+    lv_style_set_border_width(&transparent, 0);
+    lv_style_set_pad_all(&transparent, 0);
+
+    lv_style_init(&title);
+    lv_style_set_text_font(&title, &lv_font_montserrat_24);
+    lv_style_set_text_color(&title, lv_color_white());
+
+    lv_style_init(&sectionTitle);
+    lv_style_set_text_font(&sectionTitle, &lv_font_montserrat_20);
+    lv_style_set_text_color(&sectionTitle, lv_color_hex(0x3498DB));
+
+    lv_style_init(&sectionGap);
+    lv_style_set_pad_top(&sectionGap, 20);
+
+    lv_style_init(&subsectionGap);
+    lv_style_set_pad_top(&subsectionGap, 10);
+
+    lv_style_init(&label);
+    lv_style_set_text_color(&label, lv_color_white());
+
+    lv_style_init(&value);
+    lv_style_set_text_font(&value, &lv_font_montserrat_24);
+    lv_style_set_text_color(&value, lv_color_hex(0x3498DB));
+
+    lv_style_init(&textLarge);
+    lv_style_set_text_font(&textLarge, &lv_font_montserrat_24);
+
+    lv_style_init(&textMedium);
+    lv_style_set_text_font(&textMedium, &lv_font_montserrat_20);
+
+    lv_style_init(&textMuted);
+    lv_style_set_text_color(&textMuted, lv_color_hex(0x95A5A6));
+
+    initBackground(&btnPrimary, 0x27AE60);
+    initBackground(&btnDanger, 0xE74C3C);
+    initBackground(&btnInfo, 0x3498DB);
+    initBackground(&btnWarning, 0xF39C12);
+    initBackground(&btnAccent, 0xE67E22);
+    initBackground(&btnNeutral, 0x7F8C8D);
+    initBackground(&btnMuted, 0x95A5A6);
+
+    lv_style_init(&btnRound);
+    lv_style_set_radius(&btnRound, 30);
+
+    lv_style_init(&chart);
+    lv_style_set_line_color(&chart, lv_color_hex(0x4A5F73));
+    lv_style_set_border_width(&chart, 0);
+    lv_style_set_pad_all(&chart, 6);
+
+    lv_style_init(&chartSeries);
+    lv_style_set_line_width(&chartSeries, 2);
+    lv_style_set_size(&chartSeries, 0);
+}
+
+// Resolves lookupProps on obj and all its descendants; returns the object count
+static uint32_t lookupTree(lv_obj_t* obj) {
+    uint32_t count = 1;
+    for (uint8_t i = 0; i < sizeof(lookupProps) / sizeof(lookupProps[0]); i++) {
+        lv_style_value_t v = lv_obj_get_style_prop(obj, LV_PART_MAIN, lookupProps[i]);
+        lookupSink = lookupSink + v.num;
+    }
+
+    uint32_t children = lv_obj_get_child_cnt(obj);
+    for (uint32_t i = 0; i < children; i++) {
+        count += lookupTree(lv_obj_get_child(obj, i));
+    }
+    return count;
+}
+
+String UITheme::getLookupStatsJSON(uint8_t passes) {
+    if (passes == 0) passes = 1;
+    if (passes > UI_STYLE_STATS_MAX_PASSES) passes = UI_STYLE_STATS_MAX_PASSES;
+
+    uint32_t objects = 0;
+    uint32_t localStyles = 0;
+    uint32_t elapsed = 0;
+    for (uint8_t i = 0; i < passes; i++) {
+        if (i > 0) {
+            // The caller outranks the LVGL task; give it a tick to render
+            vTaskDelay(1);
+        }
+        LvglLock lock;
+        uint32_t start = micros();
+        objects = lookupTree(lv_scr_act());
+        elapsed += micros() - start;
+    }
+
+    {
+        LvglLock lock;
+        // Objects still carrying a local style (state colours set at runtime)
+        lv_obj_tree_walk(lv_scr_act(), [](lv_obj_t* obj, void* user) -> lv_obj_tree_walk_res_t {
+            for (uint32_t i = 0; i < obj->style_cnt; i++) {
+                if (obj->styles[i].is_local) {
+                    (*(uint32_t*)user)++;
+                    break;
+                }
+            }
+            return LV_OBJ_TREE_WALK_NEXT;
+        }, &localStyles);
+    }
+
+    StaticJsonDocument<192> doc;
+    doc["objects"] = objects;
+    doc["objectsWithLocalStyle"] = localStyles;
+    doc["passes"] = passes;
+    doc["lookupUsPerPass"] = elapsed / passes;
+
+    String output;
+    serializeJson(doc, output);
+    return output;
+}
@@ -0,0 +1,60 @@
+#ifndef UI_THEME_H
+#define UI_THEME_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+
+// Shared styles for all screens. Each lv_style_t is stored once and only
+// referenced by the objects using it, where lv_obj_set_style_*() gives every
+// object its own local style allocation.
+class UITheme {
+public:
+    UITheme();
+
+    // Initialise the styles. Call before any screen is created.
+    void begin();
+
+    // Screens and containers
+    lv_style_t screen;          // Dark screen background
+    lv_style_t panel;           // Slightly lighter panel / bar track
+    lv_style_t form;            // Padding of the scrolling settings column
+    lv_style_t transparent;     // Layout-only container: no background, border or padding
+
+    // Text
+    lv_style_t title;           // Large white heading
+    lv_style_t sectionTitle;    // Blue settings section heading
+    lv_style_t sectionGap;      // Space above a section
+    lv_style_t subsectionGap;   // Smaller space above a sub-group
+    lv_style_t label;           // White field label
+    lv_style_t value;           // Large blue live value
+    lv_style_t textLarge;
+    lv_style_t textMedium;
+    lv_style_t textMuted;
+
+    // Buttons (backgrounds; btnPrimary is also the progress bar indicator)
+    lv_style_t btnPrimary;      // Green: dispense, OK, connect
+    lv_style_t btnDanger;       // Red: stop, cancel
+    lv_style_t btnInfo;         // Blue: scan, save
+    lv_style_t btnWarning;      // Yellow: pause
+    lv_style_t btnAccent;       // Orange: calibrate
+    lv_style_t btnNeutral;      // Grey: settings, back
+    lv_style_t btnMuted;        // Light grey: inactive
+    lv_style_t btnRound;        // Circular icon buttons
+
+    // Charts
+    lv_style_t chart;           // Plot area: panel colour, dim division lines
+    lv_style_t chartSeries;     // Series lines without point markers
+
+    // Time one style-resolution pass over the active screen: every object is
+    // asked for the properties a redraw needs. Takes the LVGL lock once per
+    // pass and lets the LVGL task run in between.
+    String getLookupStatsJSON(uint8_t passes);
+
+private:
+    bool _initialized;
+};
+
+// Global instance
+extern UITheme uiTheme;
+
+#endif // UI_THEME_H
@@ -2,6 +2,18 @@
 #include "HardwareControl.h"
 #include "config.h"
 #include "VolumeUnit.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include "LoopMonitor.h"
+#include "TaskProfiler.h"
+#include "Log.h"
+#include "DisplayBench.h"
+#include "WiFiService.h"
+#include "UITheme.h"
+#include "IdleManager.h"
+#include "BootProfiler.h"
+#include "DrawBufferTuner.h"
+#include "HotPathBench.h"
 #include <WiFi.h>
 #include <Preferences.h>
 #include <LittleFS.h>
@@ -10,24 +22,53 @@
 // Global instance
 WebServerManager webServer;
 
+// Registered first so it sees every request; never handles any itself
+class HttpActivityHandler : public AsyncWebHandler {
+public:
+    bool canHandle(AsyncWebServerRequest* request) override {
+        idleManager.notifyHttp();
+        return false;
+    }
+};
+
+// Prometheus text is rendered here one section at a time, so scrapes never
+// allocate their own buffer; the stream state below walks the sections
+static char metricsBuffer[METRICS_BUFFER_SIZE];
+static uint8_t metricsSection = 0;
+static size_t metricsLen = 0;
+static size_t metricsSent = 0;
+
 WebServerManager::WebServerManager() {
     _server = nullptr;
     _ws = nullptr;
     _lastBroadcast = 0;
+    _metricsBusy = false;
+    _traceBusy = false;
+    _screenshot = nullptr;
+    _screenshotStart = 0;
+    memset(_clientIds, 0, sizeof(_clientIds));
 }
 
 void WebServerManager::begin() {
     // Initialize LittleFS
-    if (!LittleFS.begin(true)) {
+    int8_t phase = bootProfiler.begin("littlefs");
+    bool mounted = LittleFS.begin(true);
+    bootProfiler.end(phase);
+    if (!mounted) {
         Serial.println("ERROR: Failed to mount LittleFS!");
         Serial.println("Web interface will not be available.");
         return;
     }
     Serial.println("LittleFS mounted successfully");
 
+    phase = bootProfiler.begin("web_server");
+
     _server = new AsyncWebServer(80);
     _ws = new AsyncWebSocket("/ws");
 
+    // Full CPU speed while requests are being served
+    _server->addHandler(new HttpActivityHandler());
+
     // Setup WebSocket
     _ws->onEvent([this](AsyncWebSocket* server, AsyncWebSocketClient* client,
                        AwsEventType type, void* arg, uint8_t* data, size_t len) {
@@ -39,6 +80,192 @@ void WebServerManager::begin() {
         request->send(200, "application/json", getStatusJSON());
     });
 
+    _server->on("/metrics", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        // The buffer is shared, so only one scrape may stream from it at a time
+        if (_metricsBusy) {
+            request->send(503, "text/plain", "Scrape in progress");
+            return;
+        }
+        _metricsBusy = true;
+        sampleQueueDepth();
+        metricsSection = 0;
+        metricsLen = 0;
+        metricsSent = 0;
+
+        AsyncWebServerResponse* response = request->beginChunkedResponse("text/plain; version=0.0.4",
+            [](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+                // Render the next section once the previous one is fully sent
+                while (metricsSent == metricsLen) {
+                    if (metricsSection >= metrics.sectionCount()) return 0;
+                    metricsLen = metrics.renderSection(metricsSection++, metricsBuffer, sizeof(metricsBuffer));
+                    metricsSent = 0;
+                }
+                size_t n = min(maxLen, metricsLen - metricsSent);
+                memcpy(buffer, metricsBuffer + metricsSent, n);
+                metricsSent += n;
+                return n;
+            });
+        request->onDisconnect([this]() { _metricsBusy = false; });
+        request->send(response);
+    });
+
+    _server->on("/api/loop", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        request->send(200, "application/json", loopMonitor.getStatusJSON());
+    });
+
+    _server->on("/api/loop/reset", HTTP_POST, [this](AsyncWebServerRequest* request) {
+        loopMonitor.reset();
+        request->send(200, "application/json", "{\"success\":true}");
+    });
+
+    _server->on("/api/power", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        request->send(200, "application/json", idleManager.getStatusJSON());
+    });
+
+    _server->on("/api/boot", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        request->send(200, "application/json", bootProfiler.getJSON());
+    });
+
+    _server->on("/api/tasks", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        request->send(200, "application/json", taskProfiler.getStatusJSON());
+    });
+
+    _server->on("/api/display/bench", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        request->send(200, "application/json", displayBench.getStatusJSON());
+    });
+
+    _server->on("/api/display/bench", HTTP_POST, [this](AsyncWebServerRequest* request) {
+        uint16_t seconds = 10;
+        if (request->hasParam("seconds", true)) {
+            seconds = request->getParam("seconds", true)->value().toInt();
+        }
+        if (displayBench.start(seconds)) {
+            request->send(200, "application/json", "{\"success\":true}");
+        } else {
+            request->send(409, "application/json", "{\"success\":false,\"error\":\"Benchmark already running\"}");
+        }
+    });
+
+    _server->on("/api/display/buffers", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        request->send(200, "application/json", drawBufferTuner.getStatusJSON());
+    });
+
+    _server->on("/api/display/buffers/tune", HTTP_POST, [this](AsyncWebServerRequest* request) {
+        if (!drawBufferTuner.isActive()) {
+            request->send(503, "application/json", "{\"success\":false,\"error\":\"Display not initialized\"}");
+        } else if (drawBufferTuner.requestTune()) {
+            request->send(200, "application/json", "{\"success\":true}");
+        } else {
+            request->send(409, "application/json", "{\"success\":false,\"error\":\"Tuning already running\"}");
+        }
+    });
+
+    _server->on("/api/hotpath", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        request->send(200, "application/json", hotPathBench.getStatusJSON());
+    });
+
+    _server->on("/api/hotpath/bench", HTTP_POST, [this](AsyncWebServerRequest* request) {
+        uint16_t seconds = 10;
+        if (request->hasParam("seconds", true)) {
+            seconds = request->getParam("seconds", true)->value().toInt();
+        }
+        if (hotPathBench.start(seconds)) {
+            request->send(200, "application/json", "{\"success\":true}");
+        } else {
+            request->send(409, "application/json", "{\"success\":false,\"error\":\"Benchmark already running\"}");
+        }
+    });
+
+    _server->on("/api/log", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        request->send(200, "text/plain", logger.getHistory());
+    });
+
+    _server->on("/api/ui/styles", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        uint8_t passes = 10;
+        if (request->hasParam("passes")) {
+            passes = constrain(request->getParam("passes")->value().toInt(), 1, UI_STYLE_STATS_MAX_PASSES);
+        }
+        request->send(200, "application/json", uiTheme.getLookupStatsJSON(passes));
+    });
+
+    _server->on("/api/trace/start", HTTP_POST, [this](AsyncWebServerRequest* request) {
+        if (request->hasParam("clear", true)) {
+            tracer.clear();
+        }
+        tracer.setEnabled(true);
+        request->send(200, "application/json",
+                      tracer.isEnabled() ? "{\"success\":true}" : "{\"success\":false,\"error\":\"No trace buffer\"}");
+    });
+
+    _server->on("/api/trace/stop", HTTP_POST, [this](AsyncWebServerRequest* request) {
+        tracer.setEnabled(false);
+        request->send(200, "application/json", "{\"success\":true}");
+    });
+
+    // What the panel shows right now, as PNG. Encoded a chunk at a time on
+    // the AsyncTCP task from LVGL-rendered strips, so neither rendering nor
+    // loop() waits for more than one strip.
+    _server->on("/api/screenshot", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        if (!ScreenshotStream::isAvailable()) {
+            request->send(503, "text/plain", "Display not initialized");
+            return;
+        }
+        if (_screenshot != nullptr) {
+            request->send(503, "text/plain", "Screenshot in progress");
+            return;
+        }
+
+        ScreenshotStream* stream = new ScreenshotStream();
+        if (!stream->begin()) {
+            delete stream;
+            request->send(503, "text/plain", "Out of memory");
+            return;
+        }
+        _screenshot = stream;
+        _screenshotStart = millis();
+
+        // Each request owns its stream and deletes it on disconnect. The
+        // stream frees its buffers once the PNG is complete, and _screenshot
+        // is cleared then so the next request need not wait for the close.
+        AsyncWebServerResponse* response = request->beginChunkedResponse("image/png",
+            [this, stream](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+                size_t n = stream->read(buffer, maxLen);
+                if (n == 0 && _screenshot == stream) {
+                    LOG_INFO("Screenshot: %u bytes in %lu ms", stream->getBytesSent(),
+                             millis() - _screenshotStart);
+                    _screenshot = nullptr;
+                }
+                return n;
+            });
+        response->addHeader("Cache-Control", "no-store");
+        request->onDisconnect([this, stream]() {
+            if (_screenshot == stream) _screenshot = nullptr;
+            delete stream;
+        });
+        request->send(response);
+    });
+
+    // Chrome trace-event JSON (load in chrome://tracing or ui.perfetto.dev)
+    _server->on("/api/trace", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        // The export cursor is shared, so only one download may run at a time
+        if (_traceBusy) {
+            request->send(503, "text/plain", "Trace export in progress");
+            return;
+        }
+        _traceBusy = true;
+
+        AsyncWebServerResponse* response = request->beginChunkedResponse("application/json",
+            [](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+                return tracer.exportChunk(buffer, maxLen, index);
+            });
+        response->addHeader("Content-Disposition", "attachment; filename=\"trace.json\"");
+        request->onDisconnect([this]() {
+            tracer.abortExport();
+            _traceBusy = false;
+        });
+        request->send(response);
+    });
+
     _server->on("/api/start", HTTP_POST, [this](AsyncWebServerRequest* request) {
         if (request->hasParam("amount", true)) {
             float amount = request->getParam("amount", true)->value().toFloat();
@@ -68,6 +295,19 @@ void WebServerManager::begin() {
         request->send(200, "application/json", "{\"success\":true}");
     });
 
+    // Registered before /api/wifi, which would otherwise also match /api/wifi/scan
+    _server->on("/api/wifi/scan", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        request->send(200, "application/json", wifiService.getScanJSON());
+    });
+
+    _server->on("/api/wifi/scan", HTTP_POST, [this](AsyncWebServerRequest* request) {
+        if (wifiService.startScan()) {
+            request->send(202, "application/json", "{\"success\":true,\"message\":\"Scanning...\"}");
+        } else {
+            request->send(409, "application/json", "{\"success\":false,\"error\":\"WiFi busy\"}");
+        }
+    });
+
     _server->on("/api/wifi", HTTP_POST, [this](AsyncWebServerRequest* request) {
         if (request->hasParam("ssid", true) && request->hasParam("password", true)) {
             String ssid = request->getParam("ssid", true)->value();
@@ -79,10 +319,11 @@ void WebServerManager::begin() {
                 prefs.putString("wifi_ssid", ssid);
                 prefs.putString("wifi_pass", password);
                 prefs.end();
+                metrics.nvsWrites.inc(2);
             }
 
             // Attempt connection
-            WiFi.begin(ssid.c_str(), password.c_str());
+            wifiService.connect(ssid.c_str(), password.c_str());
             request->send(200, "application/json", "{\"success\":true,\"message\":\"Connecting...\"}");
         } else {
             request->send(400, "application/json", "{\"success\":false,\"error\":\"Missing parameters\"}");
@@ -121,6 +362,7 @@ void WebServerManager::begin() {
                     if (prefs.begin(PREFS_NAMESPACE, false)) {
                         prefs.putString("mdns_hostname", hostname);
                         prefs.end();
+                        metrics.nvsWrites.inc();
                     }
                     request->send(200, "application/json", "{\"success\":true,\"message\":\"Hostname saved. Restart required.\"}");
                 } else {
@@ -188,6 +430,7 @@ void WebServerManager::begin() {
                     prefs.putInt("preset3_ml", preset3);
                     prefs.putInt("preset4_ml", preset4);
                     prefs.end();
+                    metrics.nvsWrites.inc(4);
                     request->send(200, "application/json", "{\"success\":true}");
                 } else {
                     request->send(500, "application/json", "{\"success\":false,\"error\":\"Failed to save presets\"}");
@@ -225,6 +468,7 @@ void WebServerManager::begin() {
                 if (prefs.begin(PREFS_NAMESPACE, false)) {
                     prefs.putInt("volume_unit", unitType);
                     prefs.end();
+                    metrics.nvsWrites.inc();
                     request->send(200, "application/json", "{\"success\":true}");
                 } else {
                     request->send(500, "application/json", "{\"success\":false,\"error\":\"Failed to save unit preference\"}");
@@ -248,14 +492,16 @@ void WebServerManager::begin() {
             request->send(response);
 
             if (shouldReboot) {
+                logger.flush();
                 delay(500);
                 ESP.restart();
             }
         },
         [](AsyncWebServerRequest* request, String filename, size_t index, uint8_t* data, size_t len, bool final) {
             // This is called for each chunk of data uploaded
+            idleManager.notifyHttp();
             if (!index) {
-                Serial.printf("OTA Update Start: %s\n", filename.c_str());
+                LOG_INFO("OTA Update Start: %s", filename.c_str());
 
                 // Get update type from query parameter
                 int cmd = U_FLASH; // Default to firmware
@@ -267,21 +513,21 @@ void WebServerManager::begin() {
                 }
 
                 if (!Update.begin(UPDATE_SIZE_UNKNOWN, cmd)) {
-                    Update.printError(Serial);
+                    LOG_ERROR("OTA Update begin failed: %s", Update.errorString());
                 }
             }
 
             if (!Update.hasError()) {
                 if (Update.write(data, len) != len) {
-                    Update.printError(Serial);
+                    LOG_ERROR("OTA Update write failed at %uB: %s", index, Update.errorString());
                 }
             }
 
             if (final) {
                 if (Update.end(true)) {
-                    Serial.printf("OTA Update Success: %uB\n", index + len);
+                    LOG_INFO("OTA Update Success: %uB", index + len);
                 } else {
-                    Update.printError(Serial);
+                    LOG_ERROR("OTA Update end failed: %s", Update.errorString());
                 }
             }
         }
@@ -294,6 +540,7 @@ void WebServerManager::begin() {
         .setCacheControl("max-age=600");  // Cache for 10 minutes
 
     _server->begin();
+    bootProfiler.end(phase);
     Serial.println("Web server started on port 80");
 }
 
@@ -314,15 +561,50 @@ void WebServerManager::broadcastStatus() {
     _ws->textAll(status);
 }
 
+// AsyncTCP task only (WebSocket events, /metrics): clients are freed on that
+// task, so the ones looked up here stay valid while they are read. loop()
+// sees only the published gauges.
+void WebServerManager::sampleQueueDepth() {
+    int32_t depth = 0;
+    for (uint8_t i = 0; i < WS_MAX_TRACKED_CLIENTS; i++) {
+        if (_clientIds[i] == 0) continue;
+        AsyncWebSocketClient* client = _ws->client(_clientIds[i]);
+        if (client == nullptr) {
+            _clientIds[i] = 0;
+            continue;
+        }
+        depth += client->queueLen();
+    }
+
+    uint32_t clients = _ws->count();
+    metrics.wsClients.set(clients);
+    metrics.wsQueueDepth.set(depth);
+    if (clients > 0) {
+        metrics.wsQueueDepthHist.observe(depth);
+    }
+}
+
 void WebServerManager::onWebSocketEvent(AsyncWebSocket* server, AsyncWebSocketClient* client,
                                         AwsEventType type, void* arg, uint8_t* data, size_t len) {
     if (type == WS_EVT_CONNECT) {
-        Serial.printf("WebSocket client #%u connected from %s\n", client->id(), client->remoteIP().toString().c_str());
+        LOG_INFO("WebSocket client #%u connected from %s", client->id(), client->remoteIP().toString().c_str());
+        for (uint8_t i = 0; i < WS_MAX_TRACKED_CLIENTS; i++) {
+            if (_clientIds[i] == 0) {
+                _clientIds[i] = client->id();
+                break;
+            }
+        }
         // Send current status to new client
         client->text(getStatusJSON());
     } else if (type == WS_EVT_DISCONNECT) {
-        Serial.printf("WebSocket client #%u disconnected\n", client->id());
+        LOG_INFO("WebSocket client #%u disconnected", client->id());
+        for (uint8_t i = 0; i < WS_MAX_TRACKED_CLIENTS; i++) {
+            if (_clientIds[i] == client->id()) {
+                _clientIds[i] = 0;
+            }
+        }
     }
+    sampleQueueDepth();
 }
 
 String WebServerManager::getStatusJSON() {
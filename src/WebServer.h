@@ -4,6 +4,8 @@
 #include <ESPAsyncWebServer.h>
 #include <AsyncTCP.h>
 #include <ArduinoJson.h>
+#include "config.h"
+#include "Screenshot.h"
 
 class WebServerManager {
 public:
@@ -22,9 +24,24 @@ private:
 
     // Helper methods
     String getStatusJSON();
+    void sampleQueueDepth();
 
     // Timing for periodic updates
     unsigned long _lastBroadcast;
+
+    // WebSocket client ids, tracked for queue depth sampling (AsyncTCP task only)
+    uint32_t _clientIds[WS_MAX_TRACKED_CLIENTS];
+
+    // Set while a /metrics response is streaming out of the shared buffer
+    bool _metricsBusy;
+
+    // Set while a /api/trace download is streaming (the export cursor is shared)
+    bool _traceBusy;
+
+    // The /api/screenshot being encoded, if any (one at a time). Owned and
+    // deleted by its request; only compared here, never freed.
+    ScreenshotStream* _screenshot;
+    unsigned long _screenshotStart;
 };
 
 // Global instance
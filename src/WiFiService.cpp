@@ -0,0 +1,288 @@
+#include "WiFiService.h"
+#include "OTAManager.h"
+#include "Log.h"
+#include "BootProfiler.h"
+#include <WiFi.h>
+#include <ESPmDNS.h>
+#include <Preferences.h>
+#include <ArduinoJson.h>
+
+// Global instance
+WiFiService wifiService;
+
+WiFiService::WiFiService() {
+    _state = WIFI_SVC_IDLE;
+    _attemptStart = 0;
+    _nextAttempt = 0;
+    _backoff = WIFI_RECONNECT_MIN;
+    _servicesStarted = false;
+    _linkUp = false;
+    _linkDown = false;
+    _scanMutex = nullptr;
+    _scanCount = 0;
+    _scanTime = 0;
+    _scanning = false;
+    _scanDoneCallback = nullptr;
+}
+
+void WiFiService::begin() {
+    _scanMutex = xSemaphoreCreateMutex();
+
+    WiFi.mode(WIFI_STA);
+    // Reconnects are ours, with backoff, instead of the core's immediate retry
+    WiFi.setAutoReconnect(false);
+
+    WiFi.onEvent([](arduino_event_id_t event, arduino_event_info_t info) {
+        wifiService._linkUp = true;
+    }, ARDUINO_EVENT_WIFI_STA_GOT_IP);
+    WiFi.onEvent([](arduino_event_id_t event, arduino_event_info_t info) {
+        // ASSOC_LEAVE is our own WiFi.disconnect(), not a lost link
+        if (info.wifi_sta_disconnected.reason != WIFI_REASON_ASSOC_LEAVE) {
+            wifiService._linkDown = true;
+        }
+    }, ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+    WiFi.onEvent([](arduino_event_id_t event, arduino_event_info_t info) {
+        wifiService.storeScanResults();
+    }, ARDUINO_EVENT_WIFI_SCAN_DONE);
+
+    // Load saved credentials
+    Preferences prefs;
+    if (prefs.begin(PREFS_NAMESPACE, true)) {
+        _ssid = prefs.getString("wifi_ssid", "");
+        _password = prefs.getString("wifi_pass", "");
+        prefs.end();
+    }
+
+    if (_ssid.length() > 0) {
+        LOG_INFO("Connecting to WiFi: %s", _ssid.c_str());
+        beginAttempt();
+    } else {
+        LOG_INFO("No saved WiFi credentials. Use config screen to setup.");
+    }
+}
+
+void WiFiService::connect(const char* ssid, const char* password) {
+    _ssid = ssid;
+    _password = password;
+    _backoff = WIFI_RECONNECT_MIN;
+
+    WiFi.disconnect();
+    beginAttempt();
+}
+
+void WiFiService::beginAttempt() {
+    WiFi.begin(_ssid.c_str(), _password.c_str());
+    _state = WIFI_SVC_CONNECTING;
+    _attemptStart = millis();
+}
+
+void WiFiService::scheduleReconnect() {
+    _state = WIFI_SVC_BACKOFF;
+    _nextAttempt = millis() + _backoff;
+    LOG_WARN("WiFi down, retrying in %u ms", _backoff);
+
+    _backoff *= 2;
+    if (_backoff > WIFI_RECONNECT_MAX) {
+        _backoff = WIFI_RECONNECT_MAX;
+    }
+}
+
+void WiFiService::update() {
+    if (_linkUp) {
+        _linkUp = false;
+        _linkDown = false;
+        _state = WIFI_SVC_CONNECTED;
+        _backoff = WIFI_RECONNECT_MIN;
+        LOG_INFO("WiFi connected! IP: %s", WiFi.localIP().toString().c_str());
+        startServices();
+    }
+
+    if (_linkDown) {
+        _linkDown = false;
+        if (_state == WIFI_SVC_CONNECTED || _state == WIFI_SVC_CONNECTING) {
+            scheduleReconnect();
+        }
+    }
+
+    switch (_state) {
+        case WIFI_SVC_CONNECTING:
+            if (millis() - _attemptStart >= WIFI_TIMEOUT) {
+                WiFi.disconnect();
+                scheduleReconnect();
+            }
+            break;
+
+        case WIFI_SVC_BACKOFF:
+            // A running scan would make WiFi.begin() fail; wait for it
+            if ((long)(millis() - _nextAttempt) >= 0 && !_scanning) {
+                beginAttempt();
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void WiFiService::startServices() {
+    // mDNS and ArduinoOTA keep running across reconnects; start them once
+    if (_servicesStarted) return;
+    _servicesStarted = true;
+    bootProfiler.mark("wifi_connected");
+    int8_t phase = bootProfiler.begin("mdns_ota");
+
+    Preferences prefs;
+    String hostname = DEFAULT_MDNS_HOSTNAME;
+    String otaPassword = "";
+    if (prefs.begin(PREFS_NAMESPACE, true)) {
+        hostname = prefs.getString("mdns_hostname", DEFAULT_MDNS_HOSTNAME);
+        otaPassword = prefs.getString("ota_password", "");
+        prefs.end();
+    }
+
+    // Ensure hostname is valid (alphanumeric and hyphens only, max 63 chars)
+    if (hostname.length() == 0 || hostname.length() > 63) {
+        hostname = DEFAULT_MDNS_HOSTNAME;
+    }
+
+    if (MDNS.begin(hostname.c_str())) {
+        LOG_INFO("mDNS responder started: %s.local", hostname.c_str());
+        MDNS.addService("http", "tcp", 80);
+    } else {
+        LOG_ERROR("Error starting mDNS");
+    }
+
+    LOG_INFO("Web interface available at http://%s and http://%s.local",
+             WiFi.localIP().toString().c_str(), hostname.c_str());
+
+    if (otaPassword.length() > 0) {
+        otaManager.begin(hostname.c_str(), otaPassword.c_str());
+        LOG_INFO("OTA enabled with password protection");
+    } else {
+        otaManager.begin(hostname.c_str());
+        LOG_INFO("OTA enabled (no password)");
+    }
+    bootProfiler.end(phase);
+}
+
+// ============================================================
+// SCANNING
+// ============================================================
+
+bool WiFiService::startScan() {
+    if (_scanning) return true;
+
+    // Scanning while associating fails; the attempt will finish or time out first
+    if (_state == WIFI_SVC_CONNECTING) return false;
+
+    _scanning = true;
+    if (WiFi.scanNetworks(true) != WIFI_SCAN_RUNNING) {
+        _scanning = false;
+        return false;
+    }
+    return true;
+}
+
+void WiFiService::storeScanResults() {
+    int16_t n = WiFi.scanComplete();
+    if (n < 0) {
+        // Scan failed; keep the previous results
+        _scanning = false;
+        if (_scanDoneCallback != nullptr) {
+            _scanDoneCallback();
+        }
+        return;
+    }
+
+    WiFiScanEntry results[WIFI_SCAN_MAX_RESULTS];
+    uint8_t count = 0;
+
+    for (int16_t i = 0; i < n; i++) {
+        String ssid = WiFi.SSID(i);
+        int32_t rssi = WiFi.RSSI(i);
+        if (ssid.length() == 0) continue;   // Hidden network
+
+        // One entry per SSID, keeping the strongest access point
+        int8_t existing = -1;
+        for (uint8_t j = 0; j < count; j++) {
+            if (strcmp(results[j].ssid, ssid.c_str()) == 0) {
+                existing = j;
+                break;
+            }
+        }
+        if (existing >= 0) {
+            if (rssi <= results[existing].rssi) continue;
+            // Remove it; re-inserted below at its new position
+            memmove(&results[existing], &results[existing + 1], (count - existing - 1) * sizeof(WiFiScanEntry));
+            count--;
+        }
+
+        // Insert sorted by RSSI, dropping the weakest when full
+        uint8_t pos = count;
+        while (pos > 0 && results[pos - 1].rssi < rssi) pos--;
+        if (pos >= WIFI_SCAN_MAX_RESULTS) continue;
+        uint8_t tail = (count < WIFI_SCAN_MAX_RESULTS ? count : WIFI_SCAN_MAX_RESULTS - 1) - pos;
+        memmove(&results[pos + 1], &results[pos], tail * sizeof(WiFiScanEntry));
+
+        strlcpy(results[pos].ssid, ssid.c_str(), sizeof(results[pos].ssid));
+        results[pos].rssi = rssi;
+        results[pos].channel = WiFi.channel(i);
+        results[pos].secure = WiFi.encryptionType(i) != WIFI_AUTH_OPEN;
+        if (count < WIFI_SCAN_MAX_RESULTS) count++;
+    }
+    WiFi.scanDelete();
+
+    xSemaphoreTake(_scanMutex, portMAX_DELAY);
+    memcpy(_scanResults, results, count * sizeof(WiFiScanEntry));
+    _scanCount = count;
+    _scanTime = millis();
+    xSemaphoreGive(_scanMutex);
+
+    _scanning = false;
+    LOG_DEBUG("WiFi scan done: %d networks", count);
+
+    if (_scanDoneCallback != nullptr) {
+        _scanDoneCallback();
+    }
+}
+
+uint8_t WiFiService::getScanResults(WiFiScanEntry* entries, uint8_t maxEntries) {
+    if (_scanMutex == nullptr) return 0;
+
+    xSemaphoreTake(_scanMutex, portMAX_DELAY);
+    uint8_t count = _scanCount < maxEntries ? _scanCount : maxEntries;
+    memcpy(entries, _scanResults, count * sizeof(WiFiScanEntry));
+    xSemaphoreGive(_scanMutex);
+    return count;
+}
+
+uint32_t WiFiService::getScanAge() {
+    if (_scanTime == 0) return UINT32_MAX;
+    return millis() - _scanTime;
+}
+
+String WiFiService::getScanJSON() {
+    WiFiScanEntry entries[WIFI_SCAN_MAX_RESULTS];
+    uint8_t count = getScanResults(entries, WIFI_SCAN_MAX_RESULTS);
+    DynamicJsonDocument doc(256 + count * 128);
+
+    doc["scanning"] = _scanning;
+    if (_scanTime != 0) {
+        doc["ageMs"] = getScanAge();
+    } else {
+        doc["ageMs"] = nullptr;
+    }
+
+    JsonArray networks = doc.createNestedArray("networks");
+    for (uint8_t i = 0; i < count; i++) {
+        JsonObject net = networks.createNestedObject();
+        net["ssid"] = entries[i].ssid;
+        net["rssi"] = entries[i].rssi;
+        net["channel"] = entries[i].channel;
+        net["secure"] = entries[i].secure;
+    }
+
+    String output;
+    serializeJson(doc, output);
+    return output;
+}
@@ -0,0 +1,85 @@
+#ifndef WIFI_SERVICE_H
+#define WIFI_SERVICE_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "config.h"
+
+struct WiFiScanEntry {
+    char ssid[33];
+    int32_t rssi;
+    uint8_t channel;
+    bool secure;
+};
+
+enum WiFiServiceState {
+    WIFI_SVC_IDLE,          // No credentials
+    WIFI_SVC_CONNECTING,    // WiFi.begin() issued, waiting for an IP
+    WIFI_SVC_CONNECTED,
+    WIFI_SVC_BACKOFF        // Disconnected, next attempt at _nextAttempt
+};
+
+// Owns the station connection: event-driven connects, reconnects with
+// exponential backoff, async scans with a cached result list, and starting
+// mDNS/OTA whenever the link comes up. Call update() from loop().
+class WiFiService {
+public:
+    WiFiService();
+
+    // Register WiFi events and connect with the saved credentials
+    void begin();
+
+    // Runs the reconnect state machine and starts network services
+    void update();
+
+    // Connect to a network, replacing the current credentials (not saved)
+    void connect(const char* ssid, const char* password);
+
+    // Start a background scan. Returns false if one could not be started.
+    bool startScan();
+    bool isScanning() const { return _scanning; }
+
+    // Copy up to maxEntries cached results (strongest first). Returns the count.
+    uint8_t getScanResults(WiFiScanEntry* entries, uint8_t maxEntries);
+
+    // Milliseconds since the last completed scan, or UINT32_MAX if none
+    uint32_t getScanAge();
+
+    // Called on the WiFi event task when a scan completes
+    void onScanDone(void (*callback)()) { _scanDoneCallback = callback; }
+
+    WiFiServiceState getState() const { return _state; }
+    String getScanJSON();
+
+private:
+    WiFiServiceState _state;
+    String _ssid;
+    String _password;
+    unsigned long _attemptStart;
+    unsigned long _nextAttempt;
+    uint32_t _backoff;
+    bool _servicesStarted;
+
+    // Set on the WiFi event task, consumed by update()
+    volatile bool _linkUp;
+    volatile bool _linkDown;
+
+    // Scan cache, written on the WiFi event task
+    SemaphoreHandle_t _scanMutex;
+    WiFiScanEntry _scanResults[WIFI_SCAN_MAX_RESULTS];
+    uint8_t _scanCount;
+    unsigned long _scanTime;
+    volatile bool _scanning;
+    void (*_scanDoneCallback)();
+
+    void beginAttempt();
+    void scheduleReconnect();
+    void startServices();
+    void storeScanResults();
+};
+
+// Global instance
+extern WiFiService wifiService;
+
+#endif // WIFI_SERVICE_H
@@ -40,6 +40,21 @@
 #define TOUCH_WIDTH     480
 #define TOUCH_HEIGHT    272
 
+// Touch reader task: woken by TOUCH_INT, or polls when it is not connected
+#define TOUCH_POLL_INTERVAL    20   // Polling period without INT (ms)
+#define TOUCH_RELEASE_TIMEOUT  60   // No frame this long while touched = released (ms)
+#define TOUCH_TASK_STACK       3072
+#define TOUCH_TASK_PRIORITY    3    // Above LVGL so a touch is read before the next frame
+#define TOUCH_TASK_CORE        1
+
+// Gestures, recognised on the touch reader task (screen pixels / ms)
+#define GESTURE_SWIPE_MIN_PX   120  // Travel along the main axis
+#define GESTURE_SWIPE_MAX_MS   600  // Slower than this is a drag, not a swipe
+#define GESTURE_LONG_PRESS_MS  800
+#define GESTURE_SLOP_PX        20   // Movement still counted as holding still
+#define GESTURE_TAP_MAX_MS     300  // Two-finger tap
+#define GESTURE_PINCH_MIN_PX   60   // Change in finger distance
+
 // Hardware control pins
 // Note: GPIOs 0-48 are used by display/touch, avoid those
 #define VALVE_PIN       10   // Pin to control the valve (HIGH = open) - Available GPIO
@@ -49,6 +64,21 @@
 #define SCREEN_WIDTH    800
 #define SCREEN_HEIGHT   480
 
+// RGB panel pixel clock (Hz)
+#define DISPLAY_PCLK_HZ         16000000
+
+// LVGL draw buffers. On first boot, and on POST /api/display/buffers/tune,
+// a fixed reference screen is redrawn with every candidate height (rows, ascending),
+// in internal RAM and PSRAM, single and double buffered. The fastest one that
+// fits is kept and stored in Preferences. Until then DRAW_BUF_DEFAULT_LINES,
+// double buffered in internal RAM, is used.
+#define DRAW_BUF_TUNE_LINES         { 40, 80, 120, 240 }
+#define DRAW_BUF_TUNE_FRAMES        3       // Timed full-screen redraws per candidate
+#define DRAW_BUF_TUNE_TOLERANCE     5       // Within this % of the fastest, prefer less internal RAM
+#define DRAW_BUF_DEFAULT_LINES      40
+#define DRAW_BUF_INTERNAL_RESERVE   (96 * 1024)     // Internal RAM left for WiFi, lwIP and AsyncTCP
+#define DRAW_BUF_PSRAM_RESERVE      (512 * 1024)
+
 // ========================================
 // FLOW SENSOR CONFIGURATION
 // ========================================
@@ -73,6 +103,12 @@
 // Account for valve closing delay
 #define OVERSHOOT_COMPENSATION  5.0
 
+// Flow rate chart on the dispensing screen
+#define FLOW_RATE_SAMPLE_INTERVAL   100  // Flow rate sampling while dispensing (ms, >= 100)
+#define FLOW_HISTORY_COLUMNS        120  // Chart columns; must be even
+#define FLOW_CHART_REFRESH_INTERVAL 200  // How often the chart picks up new samples (ms)
+#define FLOW_CHART_RANGE            20   // Initial Y range (ml/s); doubles when exceeded
+
 // Preset button amounts (in ml)
 #define PRESET_1_ML     100
 #define PRESET_2_ML     250
@@ -94,12 +130,26 @@
 // WiFi connection timeout (milliseconds)
 #define WIFI_TIMEOUT    15000
 
+// Reconnect backoff after the link drops: doubles from MIN up to MAX (milliseconds)
+#define WIFI_RECONNECT_MIN  1000
+#define WIFI_RECONNECT_MAX  60000
+
+// Background task that brings up WiFi, LittleFS and the web server at boot
+// while the UI is already running; it exits once they are started
+#define NET_START_TASK_STACK    6144
+#define NET_START_TASK_PRIORITY 1
+#define NET_START_TASK_CORE     0
+
+// Networks kept from the last scan (strongest first)
+#define WIFI_SCAN_MAX_RESULTS 20
+
 // ========================================
 // SYSTEM SETTINGS
 // ========================================
 
-// Display brightness (0-255)
+// Display brightness (0-255), and while dimmed by the idle power mode
 #define DEFAULT_BRIGHTNESS  200
+#define DIMMED_BRIGHTNESS   30
 
 // Preferences namespace for storing settings
 #define PREFS_NAMESPACE "waterdisp"
@@ -107,7 +157,161 @@
 // Debounce time for buttons (milliseconds)
 #define BUTTON_DEBOUNCE 50
 
-// LVGL tick period (milliseconds)
+// LVGL tick period (milliseconds), driven by an esp_timer
 #define LVGL_TICK_PERIOD 5
 
+// Display refresh period (milliseconds): fast while something moves on screen
+// (dispensing, animations, recent touch), slow when the UI is idle
+#define DISPLAY_REFR_PERIOD_ACTIVE  20
+#define DISPLAY_REFR_PERIOD_IDLE    250
+
+// Keep the fast refresh rate this long after the last touch (milliseconds)
+#define DISPLAY_ACTIVE_HOLD         3000
+
+// LVGL task: runs lv_timer_handler() independently of loop()
+#define LVGL_TASK_STACK     8192
+#define LVGL_TASK_PRIORITY  2
+#define LVGL_TASK_CORE      1
+#define LVGL_TASK_MAX_SLEEP 10      // Longest sleep between handler calls (ms)
+#define LVGL_TASK_IDLE_SLEEP 200    // Same, with the display off (ms)
+
+// LVGL heap: dedicated pools instead of the system heap (see LvglHeap.h).
+// Allocations up to LVGL_MEM_SMALL_MAX bytes try the internal small pool
+// first (size classes of LVGL_MEM_SMALL_STEP, pages of LVGL_MEM_SMALL_PAGE),
+// allocations of LVGL_MEM_SCRATCH_MIN bytes and up (draw scratch, layer
+// buffers) the internal scratch pool. Everything else, and whatever those
+// pools can't fit, goes to PSRAM. Set a pool size to 0 to leave it in PSRAM.
+#define LVGL_MEM_POOL_SIZE      (512 * 1024)
+#define LVGL_MEM_SMALL_SIZE     (32 * 1024)
+#define LVGL_MEM_SMALL_MAX      128
+#define LVGL_MEM_SMALL_STEP     16
+#define LVGL_MEM_SMALL_PAGE     512
+#define LVGL_MEM_SCRATCH_SIZE   (24 * 1024)
+#define LVGL_MEM_SCRATCH_MIN    512
+
+// UI message queue between other tasks and the LVGL task
+#define UI_QUEUE_LENGTH 16
+
+// Dispensing progress is posted to the UI at most this often (milliseconds)
+#define UI_STATUS_POST_INTERVAL 50
+
+// How long result screens (complete, error, calibration saved) stay up (milliseconds)
+#define UI_RESULT_SCREEN_TIME 2000
+
+// How often the UI checks on a WiFi connect attempt (milliseconds)
+#define WIFI_CONNECT_POLL_INTERVAL 250
+
+// Build the keypad, config and calibration screens on first use and free the
+// config/calibration screens when left. 0 builds every screen at boot and
+// keeps it, for comparing boot time and heap use (-D UI_LAZY_SCREENS=0).
+#ifndef UI_LAZY_SCREENS
+#define UI_LAZY_SCREENS 1
+#endif
+
+// Most style lookup passes one GET /api/ui/styles may run (each holds the
+// LVGL lock for one pass over the active screen)
+#define UI_STYLE_STATS_MAX_PASSES 20
+
+// ========================================
+// DIAGNOSTICS
+// ========================================
+
+// Size of the static buffer /metrics renders each section (built-in group or
+// collector) into before streaming it out (bytes)
+#define METRICS_BUFFER_SIZE 10240
+
+// GET /api/screenshot: size of one PNG chunk buffered per request (bytes, >= 4096)
+#define SCREENSHOT_CHUNK_SIZE 8192
+
+// Rows LVGL renders per lock for /api/screenshot; must divide SCREEN_HEIGHT
+#define SCREENSHOT_STRIP_LINES 16
+
+// Maximum number of WebSocket clients tracked for queue depth sampling
+#define WS_MAX_TRACKED_CLIENTS 8
+
+// Trace ring buffer capacity in events (8 bytes each, allocated in PSRAM)
+#define TRACE_BUFFER_EVENTS 32768
+
+// Start recording trace spans at boot (can be toggled via /api/trace/start|stop)
+#define TRACE_ENABLED_AT_BOOT false
+
+// Per-phase loop() time budgets (microseconds). Exceeding one counts as an overrun.
+#define LOOP_BUDGET_OTA_US        2000
+#define LOOP_BUDGET_HARDWARE_US   500
+#define LOOP_BUDGET_WEB_US        2000
+#define LOOP_BUDGET_ITERATION_US  5000
+
+// Maximum time between two HardwareControl::update() calls (microseconds)
+#define CONTROL_PERIOD_BUDGET_US  50000
+
+// Minimum time between two overrun log lines (milliseconds)
+#define LOOP_OVERRUN_LOG_INTERVAL 1000
+
+// Task profiler sample interval (milliseconds)
+#define TASK_PROFILER_INTERVAL 2000
+
+// Write the task table to the log this often (milliseconds, 0 = never;
+// /api/tasks and /metrics always have it)
+#define TASK_PROFILER_LOG_INTERVAL 0
+
+// Flag tasks whose stack high water mark drops below this (bytes)
+#define TASK_STACK_WARN_BYTES 1024
+
+// Highest log level compiled in (LOG_LVL_ERROR/WARN/INFO/DEBUG from Log.h);
+// can be overridden with -D LOG_COMPILE_LEVEL=... in build_flags
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LVL_INFO
+#endif
+
+// Log queue: number of pending lines and maximum length of one line
+#define LOG_QUEUE_SLOTS 64
+#define LOG_LINE_MAX    128
+
+// Recent log output kept for GET /api/log (bytes, allocated in PSRAM)
+#define LOG_HISTORY_SIZE 8192
+
+// How often the drain task empties the queue to UART (milliseconds)
+#define LOG_DRAIN_INTERVAL 10
+
+// Display benchmark load phase (POST /api/display/bench). UDP goes to the
+// discard port of DISPLAY_BENCH_UDP_HOST, or of the WiFi gateway when empty,
+// at most DISPLAY_BENCH_UDP_RATE packets of 1400 bytes per second. NVS gets
+// a 1 KB write every DISPLAY_BENCH_NVS_INTERVAL ms, at most
+// DISPLAY_BENCH_NVS_MAX_WRITES per run, to bound flash wear.
+#define DISPLAY_BENCH_UDP_HOST        ""
+#define DISPLAY_BENCH_UDP_RATE        200
+#define DISPLAY_BENCH_NVS_INTERVAL    500
+#define DISPLAY_BENCH_NVS_MAX_WRITES  60
+
+// Hot path benchmark (POST /api/hotpath/bench): calls per target, and the
+// height in rows of the LVGL blend/fill test area (scratch buffers in internal RAM)
+#define HOT_PATH_BENCH_ITERATIONS 50
+#define HOT_PATH_BENCH_LINES      8
+
+// ========================================
+// POWER MANAGEMENT
+// ========================================
+
+// With no touch and nothing dispensing, dim the backlight after
+// IDLE_DIM_TIMEOUT, then switch it off and stop LVGL refresh after
+// IDLE_OFF_TIMEOUT (milliseconds, 0 = never). A touch or a dispense wakes it.
+#define IDLE_DIM_TIMEOUT        60000
+#define IDLE_OFF_TIMEOUT        300000
+
+// Dynamic frequency scaling. Needs CONFIG_PM_ENABLE in the core's sdkconfig;
+// light sleep also needs CONFIG_FREERTOS_USE_TICKLESS_IDLE and only happens
+// with the display off. Without them the CPU stays at its fixed clock.
+#define PM_MAX_FREQ_MHZ         240
+#define PM_MIN_FREQ_MHZ         80      // Lowest clock that keeps APB at 80 MHz (panel, I2C)
+#define PM_LIGHT_SLEEP          true
+
+// Keep full speed this long after an HTTP request (milliseconds)
+#define PM_HTTP_HOLD            2000
+
+// loop() delay with the display off and nothing dispensing (milliseconds)
+#define IDLE_LOOP_DELAY         30
+
+// Touch polling period with the display off (milliseconds, no INT pin)
+#define IDLE_TOUCH_POLL_INTERVAL 100
+
 #endif // CONFIG_H
@@ -1,15 +1,40 @@
 #include "display_driver.h"
+#include "Log.h"
+#include <esp_timer.h>
 
 esp_lcd_panel_handle_t panel_handle = NULL;
 
+// Frame timing, written only from the frame-done ISR
+static volatile uint32_t frameCount = 0;
+static volatile uint32_t lateFrameCount = 0;
+static volatile uint32_t maxFrameIntervalUs = 0;
+static volatile uint32_t lastFrameUs = 0;
+static uint32_t framePeriodUs = 0;
+
+static void IRAM_ATTR recordFrame() {
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    if (lastFrameUs != 0) {
+        uint32_t interval = now - lastFrameUs;
+        if (interval > maxFrameIntervalUs) maxFrameIntervalUs = interval;
+        if (interval > framePeriodUs + framePeriodUs / 2) lateFrameCount++;
+    }
+    lastFrameUs = now;
+    frameCount++;
+}
+
+static bool IRAM_ATTR onFrameTransDone(esp_lcd_panel_handle_t panel, esp_lcd_rgb_panel_event_data_t* edata, void* user_ctx) {
+    recordFrame();
+    return false;
+}
+
 bool initRGBDisplay() {
-    Serial.println("Initializing RGB LCD...");
+    LOG_INFO("Initializing RGB LCD...");
 
     esp_lcd_rgb_panel_config_t panel_config;
     memset(&panel_config, 0, sizeof(panel_config));
 
     panel_config.clk_src = LCD_CLK_SRC_PLL160M;
-    panel_config.timings.pclk_hz = 16 * 1000 * 1000;
+    panel_config.timings.pclk_hz = DISPLAY_PCLK_HZ;
     panel_config.timings.h_res = SCREEN_WIDTH;
     panel_config.timings.v_res = SCREEN_HEIGHT;
     panel_config.timings.hsync_pulse_width = 48;
@@ -26,7 +51,7 @@ bool initRGBDisplay() {
 
     panel_config.data_width = 16;
     panel_config.sram_trans_align = 64;  // Match PSRAM alignment
-    panel_config.psram_trans_align = 64;
+    panel_config.psram_trans_align = 64; // Framebuffer starts on a cache line
     panel_config.hsync_gpio_num = LCD_HSYNC;
     panel_config.vsync_gpio_num = LCD_VSYNC;
     panel_config.de_gpio_num = LCD_DE;
@@ -52,11 +77,22 @@ bool initRGBDisplay() {
 
     panel_config.flags.disp_active_low = 0;
     panel_config.flags.fb_in_psram = 1;  // Enable PSRAM for framebuffer
+    // The callback only measures frame timing
+    panel_config.on_frame_trans_done = onFrameTransDone;
+    panel_config.user_ctx = NULL;
+
+    // Nominal frame period, used to flag frames the panel could not keep up with
+    uint32_t totalPixels =
+        (SCREEN_WIDTH + panel_config.timings.hsync_pulse_width + panel_config.timings.hsync_back_porch +
+         panel_config.timings.hsync_front_porch) *
+        (SCREEN_HEIGHT + panel_config.timings.vsync_pulse_width + panel_config.timings.vsync_back_porch +
+         panel_config.timings.vsync_front_porch);
+    framePeriodUs = (uint32_t)((uint64_t)totalPixels * 1000000 / panel_config.timings.pclk_hz);
 
     // Create RGB panel
     esp_err_t ret = esp_lcd_new_rgb_panel(&panel_config, &panel_handle);
     if (ret != ESP_OK) {
-        Serial.printf("Failed to create RGB panel: %d\n", ret);
+        LOG_ERROR("Failed to create RGB panel: %d", ret);
         return false;
     }
 
@@ -68,19 +104,34 @@ bool initRGBDisplay() {
     pinMode(LCD_BL, OUTPUT);
     ledcSetup(0, 5000, 8);
     ledcAttachPin(LCD_BL, 0);
-    ledcWrite(0, 200);
+    setBacklight(DEFAULT_BRIGHTNESS);
 
-    Serial.println("RGB LCD initialized successfully");
+    LOG_INFO("RGB LCD initialized successfully");
     return true;
 }
 
+void setBacklight(uint8_t level) {
+    ledcWrite(0, level);
+}
+
 void drawBitmap(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t *data) {
     if (panel_handle) {
         esp_lcd_panel_draw_bitmap(panel_handle, x, y, x + w, y + h, data);
     }
 }
 
-void* getFramebuffer() {
-    // Direct framebuffer access not supported in this ESP-IDF version
-    return NULL;
+DisplayFrameStats getFrameStats() {
+    DisplayFrameStats stats;
+    stats.frames = frameCount;
+    stats.lateFrames = lateFrameCount;
+    stats.maxIntervalUs = maxFrameIntervalUs;
+    stats.periodUs = framePeriodUs;
+    return stats;
+}
+
+void resetFrameStats() {
+    frameCount = 0;
+    lateFrameCount = 0;
+    maxFrameIntervalUs = 0;
+    lastFrameUs = 0;
 }
@@ -12,10 +12,24 @@ extern esp_lcd_panel_handle_t panel_handle;
 // Initialize RGB LCD
 bool initRGBDisplay();
 
+// Backlight PWM duty, 0 (off) to 255
+void setBacklight(uint8_t level);
+
 // Draw bitmap to display
 void drawBitmap(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t *data);
 
-// Get framebuffer pointer
-void* getFramebuffer();
+// Frame timing measured from the frame-done interrupt. A frame is "late" when
+// its interrupt came more than 1.5x the nominal period after the previous one,
+// i.e. interrupt latency or a stalled transfer. A PSRAM underrun does not
+// delay it: the S3 LCD peripheral then shifts or corrupts pixels instead.
+struct DisplayFrameStats {
+    uint32_t frames;
+    uint32_t lateFrames;
+    uint32_t maxIntervalUs;
+    uint32_t periodUs;          // Nominal frame period from the panel timings
+};
+
+DisplayFrameStats getFrameStats();
+void resetFrameStats();
 
 #endif // DISPLAY_DRIVER_H
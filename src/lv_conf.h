@@ -7,6 +7,13 @@
 
 #define LV_MEM_CUSTOM 1
 #define LV_MEM_SIZE (16 * 1024U)
+#if LV_MEM_CUSTOM
+    /* Dedicated PSRAM/internal pools, see LvglHeap.h */
+    #define LV_MEM_CUSTOM_INCLUDE "LvglHeap.h"
+    #define LV_MEM_CUSTOM_ALLOC   lvgl_heap_alloc
+    #define LV_MEM_CUSTOM_FREE    lvgl_heap_free
+    #define LV_MEM_CUSTOM_REALLOC lvgl_heap_realloc
+#endif
 
 #define LV_USE_LOG 1
 #if LV_USE_LOG
@@ -35,8 +42,15 @@
 #define LV_USE_DROPDOWN 1
 #define LV_USE_SPINNER 1
 #define LV_USE_ARC 1
+#define LV_USE_CHART 1
 
-#define LV_TICK_CUSTOM 1
+#define LV_TICK_CUSTOM 0
 #define LV_DISP_DEF_REFR_PERIOD 30
 
+/* Blend, fill, mask and memcpy routines (LV_ATTRIBUTE_FAST_MEM) and
+ * lv_disp_flush_ready(), called from every flush, in IRAM. See HotPath.h */
+#include "HotPath.h"
+#define LV_ATTRIBUTE_FAST_MEM       HOT_PATH_ATTR
+#define LV_ATTRIBUTE_FLUSH_READY    HOT_PATH_ATTR
+
 #endif
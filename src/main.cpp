@@ -3,22 +3,34 @@
 #include <WiFi.h>
 #include <Preferences.h>
 #include <nvs_flash.h>
-#include <ESPmDNS.h>
 #include "config.h"
 #include "display_driver.h"
 #include "GT911.h"
+#include "Gesture.h"
 #include "HardwareControl.h"
 #include "UIManager.h"
 #include "WebServer.h"
 #include "OTAManager.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include "LoopMonitor.h"
+#include "TaskProfiler.h"
+#include "Log.h"
+#include "DisplayBench.h"
+#include "LvglTask.h"
+#include "WiFiService.h"
+#include "LvglHeap.h"
+#include "IdleManager.h"
+#include "BootProfiler.h"
+#include "DrawBufferTuner.h"
+#include "HotPath.h"
+#include "HotPathBench.h"
 
 // Touch object
 GT911 touch(TOUCH_SDA, TOUCH_SCL, TOUCH_INT, TOUCH_RST, TOUCH_WIDTH, TOUCH_HEIGHT);
 
-// LVGL display buffer - allocated in PSRAM to save DRAM
+// LVGL draw buffers, sized and placed by drawBufferTuner
 static lv_disp_draw_buf_t draw_buf;
-static lv_color_t *buf1;
-static lv_color_t *buf2;
 
 // LVGL display driver
 static lv_disp_drv_t disp_drv;
@@ -26,183 +38,201 @@ static lv_indev_drv_t indev_drv;
 
 // Forward declarations
 void my_disp_flush(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p);
+void my_monitor(lv_disp_drv_t *disp, uint32_t time, uint32_t px);
 void my_touchpad_read(lv_indev_drv_t *indev_driver, lv_indev_data_t *data);
 void setupDisplay();
 void setupTouch();
 void setupLVGL();
-void setupWiFi();
+static void networkStartTask(void* arg);
+static void benchTouchRead();
+static void benchControlCheck();
+
+// Set by networkStartTask once WiFi and the web server are initialized;
+// loop() only services them from then on
+static volatile bool networkStarted = false;
 
 void setup() {
     Serial.begin(115200);
-    delay(4000);  // Give serial/USB CDC time to initialize
+    // No waiting for a serial monitor: boot output stays in the log history
+    // (GET /api/log) and the phase timings in GET /api/boot
 
-    Serial.println();
-    Serial.println();
-    Serial.println();
-    Serial.flush();
+    // Log output goes through the drain task from here on
+    logger.begin();
+    LOG_INFO("Water Dispenser v2.0 starting");
 
-    Serial.println("========================================");
-    Serial.println("NEW FIRMWARE - Water Dispenser v2.0");
-    Serial.println("========================================");
-    Serial.flush();
+    // Trace buffer lives in PSRAM; allocate before anything starts recording
+    if (tracer.begin(TRACE_BUFFER_EVENTS)) {
+        tracer.setEnabled(TRACE_ENABLED_AT_BOOT);
+    }
+    loopMonitor.begin();
+    displayBench.begin();
 
     // Initialize NVS (required for Preferences)
-    Serial.println("[1/7] Initializing NVS...");
-    Serial.flush();
+    int8_t phase = bootProfiler.begin("nvs");
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
-        Serial.println("NVS partition full or version mismatch, erasing...");
+        LOG_WARN("NVS partition full or version mismatch, erasing...");
         ret = nvs_flash_erase();
         if (ret != ESP_OK) {
-            Serial.printf("ERROR: NVS erase failed: %d\n", ret);
+            LOG_ERROR("NVS erase failed: %d", ret);
         }
         ret = nvs_flash_init();
     }
     if (ret != ESP_OK) {
-        Serial.printf("ERROR: NVS init failed: %d\n", ret);
-    } else {
-        Serial.println("NVS initialized successfully");
+        LOG_ERROR("NVS init failed: %d", ret);
     }
+    bootProfiler.end(phase);
 
-    // Initialize display
-    Serial.println("[2/7] Initializing display...");
-    Serial.flush();
+    // Valve closed and flow sensor attached before anything slow
+    phase = bootProfiler.begin("hardware");
+    hardwareControl.begin();
+    bootProfiler.end(phase);
+
+    phase = bootProfiler.begin("display");
     setupDisplay();
+    bootProfiler.end(phase);
 
-    // Initialize touch controller
-    Serial.println("[3/7] Initializing touch controller...");
-    Serial.flush();
+    phase = bootProfiler.begin("touch");
     setupTouch();
+    bootProfiler.end(phase);
 
-    // Initialize LVGL
-    Serial.println("[4/7] Initializing LVGL...");
-    Serial.flush();
+    phase = bootProfiler.begin("lvgl");
     setupLVGL();
+    bootProfiler.end(phase);
 
-    // Initialize hardware control
-    Serial.println("[5/7] Initializing hardware control...");
-    Serial.flush();
-    hardwareControl.begin();
+    // Touch read and dispensing checks next to the LVGL blend targets
+    hotPathBench.begin();
+    hotPathBench.addTarget("touch_read", benchTouchRead, (const void*)my_touchpad_read);
+    hotPathBench.addTarget("control_check", benchControlCheck, nullptr);
 
-    // Initialize UI
-    Serial.println("[6/7] Initializing UI...");
-    Serial.flush();
+    phase = bootProfiler.begin("ui");
     uiManager.begin();
+    bootProfiler.end(phase);
 
-    // Setup WiFi (non-blocking)
-    Serial.println("[7/7] Setting up WiFi...");
-    Serial.flush();
-    setupWiFi();
+    // Display dimming and dynamic frequency scaling
+    idleManager.onStateChange([](IdleState state) {
+        touch.setPollInterval(state == IDLE_OFF ? IDLE_TOUCH_POLL_INTERVAL : TOUCH_POLL_INTERVAL);
+    });
+    idleManager.begin();
 
-    // Initialize web server
-    Serial.println("Starting web server...");
-    Serial.flush();
-    webServer.begin();
+    // From here on LVGL runs in its own task; other code must use
+    // lvglTask.lock() or post messages to uiManager. The first frame is
+    // recorded as "first_frame" by my_monitor().
+    lvglTask.begin();
 
-    // Initialize OTA if WiFi is connected
-    if (WiFi.status() == WL_CONNECTED) {
-        // Get the configured hostname
-        Preferences prefs;
-        String hostname = DEFAULT_MDNS_HOSTNAME;
-        String otaPassword = "";
-        if (prefs.begin(PREFS_NAMESPACE, true)) {
-            hostname = prefs.getString("mdns_hostname", DEFAULT_MDNS_HOSTNAME);
-            otaPassword = prefs.getString("ota_password", "");
-            prefs.end();
-        }
+    // WiFi, LittleFS and the web server come up in the background, so the
+    // dispenser is usable while they do; mDNS and OTA start once WiFi connects
+    xTaskCreatePinnedToCore(networkStartTask, "net_start", NET_START_TASK_STACK, nullptr,
+                            NET_START_TASK_PRIORITY, nullptr, NET_START_TASK_CORE);
 
-        Serial.printf("Web interface available at:\n");
-        Serial.printf("  http://%s\n", WiFi.localIP().toString().c_str());
-        Serial.printf("  http://%s.local\n", hostname.c_str());
-
-        // Initialize OTA with hostname and optional password
-        Serial.println("Starting OTA service...");
-        if (otaPassword.length() > 0) {
-            otaManager.begin(hostname.c_str(), otaPassword.c_str());
-            Serial.println("OTA enabled with password protection");
-        } else {
-            otaManager.begin(hostname.c_str());
-            Serial.println("OTA enabled (no password)");
-        }
-    }
+    // Start sampling task run time and stack usage
+    taskProfiler.begin();
 
-    Serial.println("\n=================================");
-    Serial.println("System Ready!");
-    Serial.println("=================================\n");
-    Serial.flush();
+    bootProfiler.mark("setup_done");
+    LOG_INFO("System ready, network starting in the background");
 }
 
-void loop() {
-    // Update OTA
-    otaManager.update();
+static void networkStartTask(void* arg) {
+    int8_t phase = bootProfiler.begin("wifi");
+    wifiService.begin();
+    bootProfiler.end(phase);
 
-    // Update LVGL
-    lv_timer_handler();
+    // Mounts LittleFS (formatting it if needed) and starts the server
+    webServer.begin();
+
+    networkStarted = true;
+    bootProfiler.mark("network_started");
+    vTaskDelete(nullptr);
+}
+
+void loop() {
+    uint32_t loopStart = micros();
+    loopMonitor.beginIteration();
+
+    // Update WiFi reconnects and OTA
+    loopMonitor.beginPhase(LOOP_PHASE_OTA);
+    if (networkStarted) {
+        wifiService.update();
+        otaManager.update();
+    }
+    loopMonitor.endPhase();
 
     // Update hardware control
+    loopMonitor.beginPhase(LOOP_PHASE_HARDWARE);
+    uint32_t hwStart = micros();
+    tracer.spanBegin(TRACE_HW_UPDATE);
     hardwareControl.update();
+    tracer.spanEnd(TRACE_HW_UPDATE);
+    metrics.hardwareUpdateTime.observe(micros() - hwStart);
+    loopMonitor.endPhase();
+
+    // Hand dispensing progress to the LVGL task
+    uiManager.postDispenseStatus();
 
-    // Update UI
-    uiManager.update();
+    // Display timeouts and power locks
+    idleManager.update();
 
     // Update web server
-    webServer.update();
+    loopMonitor.beginPhase(LOOP_PHASE_WEB);
+    tracer.spanBegin(TRACE_WEB_UPDATE);
+    if (networkStarted) {
+        webServer.update();
+    }
+    tracer.spanEnd(TRACE_WEB_UPDATE);
+    loopMonitor.endPhase();
 
-    // Minimal delay - let tasks run smoothly
-    delay(5);
+    metrics.loopTime.observe(micros() - loopStart);
+    loopMonitor.endIteration();
+
+    // Minimal delay - let tasks run smoothly; longer while idle with the display off
+    delay(idleManager.getLoopDelay());
 }
 
 void setupDisplay() {
     if (!initRGBDisplay()) {
-        Serial.println("ERROR: Failed to initialize display!");
+        LOG_ERROR("Failed to initialize display!");
     }
 }
 
 void setupTouch() {
     if (touch.begin()) {
-        touch.setRotation(1);  // Match display rotation
-        Serial.println("Touch controller initialized");
+        touch.setRotation(0);  // Panel and touch share the landscape orientation
+
+        // Gestures are recognised on the touch task and queued for the UI
+        touch.onFrame([](const TouchFrame& frame, uint32_t ms) {
+            if (frame.count > 0) {
+                idleManager.notifyActivity(IDLE_WAKE_TOUCH);
+            }
+            gestureDetector.update(frame, ms);
+        });
+        gestureDetector.onGesture([](const Gesture& gesture) {
+            uiManager.postGesture(gesture);
+        });
+
+        // I2C reads happen in the touch task from here on
+        touch.startReader();
+        LOG_INFO("Touch controller initialized");
     } else {
-        Serial.println("ERROR: Touch controller initialization failed!");
+        LOG_ERROR("Touch controller initialization failed!");
     }
 }
 
 void setupLVGL() {
+    // LVGL allocates from its own pools from lv_init() on
+    lvglHeap.begin();
+    lvglHeap.registerMetrics();
     lv_init();
 
-    // Use double buffering with larger buffers to reduce partial updates
-    // Buffer size: 1/5 of screen to minimize number of flushes
-    size_t buf_size = SCREEN_WIDTH * (SCREEN_HEIGHT / 4) * sizeof(lv_color_t);
-    buf1 = (lv_color_t *)heap_caps_aligned_alloc(64, buf_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
-    buf2 = (lv_color_t *)heap_caps_aligned_alloc(64, buf_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
-
-
-    if (buf1 != NULL && buf2 != NULL) {
-        Serial.printf("Display buffers allocated in PSRAM: 2x%d bytes\n", buf_size);
-        // Double buffering - one buffer for drawing, one for DMA
-        lv_disp_draw_buf_init(&draw_buf, buf1, buf2, SCREEN_WIDTH * (SCREEN_HEIGHT / 4));
-    } else if (buf1 != NULL) {
-        Serial.printf("Single display buffer allocated in PSRAM: %d bytes\n", buf_size);
-        if (buf2 != NULL) free(buf2);
-        buf2 = NULL;
-        lv_disp_draw_buf_init(&draw_buf, buf1, NULL, SCREEN_WIDTH * (SCREEN_HEIGHT / 4));
-    } else {
-        Serial.println("PSRAM buffer failed, trying SRAM");
-        buf1 = (lv_color_t *)malloc(SCREEN_WIDTH * 40 * sizeof(lv_color_t));
-
-        if (buf1 == NULL) {
-            Serial.println("ERROR: Failed to allocate display buffer!");
-            return;
-        }
+    lv_disp_drv_init(&disp_drv);
 
-        lv_disp_draw_buf_init(&draw_buf, buf1, NULL, SCREEN_WIDTH * 40);
-    }
+    // Size and placement come from the tuner (stored, or tuned on first boot)
+    drawBufferTuner.begin(&draw_buf);
 
     // Initialize display driver
-    lv_disp_drv_init(&disp_drv);
     disp_drv.hor_res = SCREEN_WIDTH;
     disp_drv.ver_res = SCREEN_HEIGHT;
     disp_drv.flush_cb = my_disp_flush;
+    disp_drv.monitor_cb = my_monitor;
     disp_drv.draw_buf = &draw_buf;
     lv_disp_drv_register(&disp_drv);
 
@@ -212,57 +242,28 @@ void setupLVGL() {
     indev_drv.read_cb = my_touchpad_read;
     lv_indev_drv_register(&indev_drv);
 
-    Serial.println("LVGL initialized");
+    LOG_INFO("LVGL initialized");
 }
 
-void setupWiFi() {
-    WiFi.mode(WIFI_STA);
-
-    // Try to load saved credentials and hostname
-    Preferences prefs;
-    if (prefs.begin(PREFS_NAMESPACE, true)) {
-        String ssid = prefs.getString("wifi_ssid", "");
-        String password = prefs.getString("wifi_pass", "");
-        String hostname = prefs.getString("mdns_hostname", DEFAULT_MDNS_HOSTNAME);
-        prefs.end();
-
-        // Ensure hostname is valid (alphanumeric and hyphens only, max 63 chars)
-        if (hostname.length() == 0 || hostname.length() > 63) {
-            hostname = DEFAULT_MDNS_HOSTNAME;
-        }
-
-        if (ssid.length() > 0) {
-            Serial.printf("Attempting to connect to WiFi: %s\n", ssid.c_str());
-            WiFi.begin(ssid.c_str(), password.c_str());
+// Called by LVGL after each frame it actually redrew
+void my_monitor(lv_disp_drv_t *disp, uint32_t time, uint32_t px) {
+    metrics.lvglRenderTime.observe(time * 1000);
+    metrics.lvglFrames.inc();
+    idleManager.onFrameRendered();
 
-            // Non-blocking connection attempt
-            unsigned long start = millis();
-            while (WiFi.status() != WL_CONNECTED && millis() - start < 10000) {
-                delay(100);
-                Serial.print(".");
-            }
-
-            if (WiFi.status() == WL_CONNECTED) {
-                Serial.printf("\nWiFi connected! IP: %s\n", WiFi.localIP().toString().c_str());
-
-                // Start mDNS service with configured hostname
-                if (MDNS.begin(hostname.c_str())) {
-                    Serial.printf("mDNS responder started: %s.local\n", hostname.c_str());
-                    MDNS.addService("http", "tcp", 80);
-                } else {
-                    Serial.println("Error starting mDNS");
-                }
-            } else {
-                Serial.println("\nWiFi connection failed. Use config screen to setup.");
-            }
-        } else {
-            Serial.println("No saved WiFi credentials. Use config screen to setup.");
-        }
+    static bool firstFrame = true;
+    if (firstFrame) {
+        firstFrame = false;
+        bootProfiler.mark("first_frame");
     }
 }
 
 // LVGL display flush callback
-void my_disp_flush(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p) {
+void HOT_PATH_ATTR my_disp_flush(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p) {
+    TRACE_SCOPE(TRACE_DISP_FLUSH);
+    uint32_t flushStart = micros();
+    metrics.lvglFlushArea.observe(lv_area_get_size(area));
+
     // Cast color buffer directly - LVGL uses RGB565 which matches our display
     void *color_buffer = (void *)color_p;
 
@@ -274,16 +275,34 @@ void my_disp_flush(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color
                                                color_buffer);
 
     if (ret != ESP_OK) {
-        Serial.printf("Draw error: %d, area: x1=%d y1=%d x2=%d y2=%d\n",
-                      ret, area->x1, area->y1, area->x2, area->y2);
+        LOG_ERROR("Draw error: %d, area: x1=%d y1=%d x2=%d y2=%d",
+                  ret, area->x1, area->y1, area->x2, area->y2);
     }
 
+    metrics.lvglFlushTime.observe(micros() - flushStart);
     lv_disp_flush_ready(disp);
 }
 
+// Hot path benchmark targets (GET /api/hotpath)
+static void HOT_PATH_ATTR benchTouchRead() {
+    lv_indev_data_t data;
+    my_touchpad_read(&indev_drv, &data);
+}
+
+static void HOT_PATH_ATTR benchControlCheck() {
+    hardwareControl.checkDispensing(millis(), hardwareControl.getDispensedAmount());
+}
+
 // LVGL touchpad read callback
-void my_touchpad_read(lv_indev_drv_t *indev_driver, lv_indev_data_t *data) {
-    TouchPoint point = touch.readTouch();
+void HOT_PATH_ATTR my_touchpad_read(lv_indev_drv_t *indev_driver, lv_indev_data_t *data) {
+    TouchPoint point = touch.isReaderRunning() ? touch.getLatest() : touch.readTouch();
+
+    // A swipe or two-finger gesture must not also click the button it
+    // started on (no active indev when called from the hot path bench)
+    lv_indev_t* indev = lv_indev_get_act();
+    if (indev != nullptr && gestureDetector.takeCapture()) {
+        lv_indev_wait_release(indev);
+    }
 
     if (point.touched) {
         data->state = LV_INDEV_STATE_PR;